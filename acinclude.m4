@@ -14,15 +14,15 @@ AC_ARG_ENABLE(drivers,
 	[                    joy,lb216,lcdm001,lcterm,lirc,lis,MD8800,mdm166a,]
 	[                    ms6931,mtc_s16209x,MtxOrb,mx5000,NoritakeVFD,]
 	[                    picolcd,pyramid,rawserial,sdeclcd,sed1330,sed1520,]
-	[                    serialPOS,serialVFD,shuttleVFD,sli,stv5730,SureElec,]
-	[                    svga,t6963,text,tyan,ula200,vlsys_m428,xosd]
+	[                    serialPOS,serialVFD,shm,shuttleVFD,sli,stv5730,]
+	[                    SureElec,svga,t6963,text,tyan,ula200,vlsys_m428,xosd]
 	[                    ]
 	[                  'all' compiles all drivers;]
 	[                  'all,!xxx,!yyy' de-selects previously selected drivers],
 	drivers="$enableval",
 	drivers=[bayrad,CFontz,CFontzPacket,curses,CwLnx,glk,lb216,lcdm001,MtxOrb,pyramid,text])
 
-allDrivers=[bayrad,CFontz,CFontzPacket,curses,CwLnx,ea65,EyeboxOne,g15,glcd,glcdlib,glk,hd44780,i2500vfd,icp_a106,imon,imonlcd,IOWarrior,irman,irtrans,joy,lb216,lcdm001,lcterm,lirc,lis,MD8800,mdm166a,ms6931,mtc_s16209x,MtxOrb,mx5000,NoritakeVFD,picolcd,pyramid,sdeclcd,sed1330,sed1520,serialPOS,serialVFD,shuttleVFD,sli,stv5730,SureElec,svga,t6963,text,tyan,ula200,vlsys_m428,xosd,rawserial]
+allDrivers=[bayrad,CFontz,CFontzPacket,curses,CwLnx,ea65,EyeboxOne,g15,glcd,glcdlib,glk,hd44780,i2500vfd,icp_a106,imon,imonlcd,IOWarrior,irman,irtrans,joy,lb216,lcdm001,lcterm,lirc,lis,MD8800,mdm166a,ms6931,mtc_s16209x,MtxOrb,mx5000,NoritakeVFD,picolcd,pyramid,sdeclcd,sed1330,sed1520,serialPOS,serialVFD,shm,shuttleVFD,sli,stv5730,SureElec,svga,t6963,text,tyan,ula200,vlsys_m428,xosd,rawserial]
 if test "$debug" = yes; then
 	allDrivers=["${allDrivers},debug"]
 fi
@@ -189,6 +189,9 @@ dnl			else
 			if test "$enable_libX11" = yes ; then
 				GLCD_DRIVERS="$GLCD_DRIVERS glcd-glcd-x11.o"
 			fi
+			if test "$ac_cv_have_shm_open" = yes ; then
+				GLCD_DRIVERS="$GLCD_DRIVERS glcd-glcd-shm.o glcd-shm-lcd.o"
+			fi
 			DRIVERS="$DRIVERS glcd${SO}"
 			actdrivers=["$actdrivers glcd"]
 			;;
@@ -450,6 +453,14 @@ dnl			else
 			DRIVERS="$DRIVERS serialVFD${SO}"
 			actdrivers=["$actdrivers serialVFD"]
 			;;
+		shm)
+			if test "$ac_cv_have_shm_open" = yes ; then
+				DRIVERS="$DRIVERS shm${SO}"
+				actdrivers=["$actdrivers shm"]
+			else
+				AC_MSG_WARN([The shm driver needs shm_open()])
+			fi
+			;;
 		shuttleVFD)
 			if test "$enable_libusb" = yes ; then
 				DRIVERS="$DRIVERS shuttleVFD${SO}"
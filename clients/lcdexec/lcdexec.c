@@ -87,6 +87,7 @@ char *pidfile = NULL;
 int pidfile_written = FALSE;
 char *displayname = NULL;
 char *default_shell = NULL;
+int on_demand = FALSE;		/**< send submenus when they are entered */
 
 /* Other global variables */
 MenuEntry *main_menu = NULL;	/**< pointer to the main menu */
@@ -319,6 +320,8 @@ static int process_configfile(char *configfile)
 	if ((tmp = config_get_string(progname, "DisplayName", 0, NULL)) != NULL)
 		displayname = strdup(tmp);
 
+	on_demand = config_get_bool(progname, "OnDemand", 0, FALSE);
+
 	/* try to find a shell that understands the -c COMMAND syntax */
 	if ((tmp = config_get_string(progname, "Shell", 0, NULL)) != NULL)
 		default_shell = strdup(tmp);
@@ -373,7 +376,7 @@ static int connect_and_setup(void)
 	}
 
 	/* Create our menu */
-	if (menu_sock_send(main_menu, NULL, sock) < 0) {
+	if (menu_sock_send(main_menu, NULL, sock, on_demand) < 0) {
 		return -1;
 	}
 
@@ -491,6 +494,28 @@ static int process_response(char *str)
 					return -1;
 			}
 		}
+		else if (strcmp(argv[1], "enter") == 0) {
+			MenuEntry *entry;
+
+			if (argc < 3) {
+				report(RPT_WARNING, "Server gave invalid response");
+				free(str2);
+				return -1;
+			}
+
+			/* Supply the entries of an on_demand submenu if
+			 * the server does not have them (any more) */
+			entry = menu_find_by_id(main_menu, atoi(argv[2]));
+			if ((on_demand) && (entry != NULL)) {
+				menu_unload(main_menu, entry);
+				if ((entry->type == MT_MENU) && (entry->id != 0) &&
+				    (!entry->loaded) &&
+				    (menu_sock_send_contents(entry, sock, on_demand) < 0)) {
+					free(str2);
+					return -1;
+				}
+			}
+		}
 		else {
 			; /* Ignore other menuevents */
 		}
@@ -244,8 +244,16 @@ MenuEntry *menu_read(MenuEntry *parent, const char *name)
 }
 
 
-/** create LCDproc commands for the menu entry hierarchy and send it to the server */
-int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock)
+/**
+ * Create LCDproc commands for the menu entry hierarchy and send it to the server.
+ * \param me         Menu entry to send.
+ * \param parent     Parent of \c me (NULL for the main menu).
+ * \param sock       Socket connected to the server.
+ * \param on_demand  If set, submenus are sent without their entries;
+ *                   menu_sock_send_contents() sends them when they are entered.
+ * \return  0 on success, -1 on error.
+ */
+int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock, int on_demand)
 {
 	if ((me != NULL) && (sock > 0)) {
 		char parent_id[12];
@@ -262,16 +270,19 @@ int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock)
 			case MT_MENU:
 				// don't create a separate entry for the main menu
 				if ((parent != NULL) && (me->id != 0)) {
-					if (sock_printf(sock, "menu_add_item \"%s\" \"%d\" menu \"%s\"\n",
-							parent_id, me->id, me->displayname) < 0)
+					if (sock_printf(sock, "menu_add_item \"%s\" \"%d\" menu \"%s\"%s\n",
+							parent_id, me->id, me->displayname,
+							(on_demand) ? " -on_demand true" : "") < 0)
 						return -1;
+
+					// the server asks for the entries when needed
+					if (on_demand)
+						break;
 				}
 
 				// recursively do it for the menu's sub-menus
-				for (entry = me->children; entry != NULL; entry = entry->next) {
-					if (menu_sock_send(entry, me, sock) < 0)
-						return -1;
-				}
+				if (menu_sock_send_contents(me, sock, on_demand) < 0)
+					return -1;
 				break;
 			case MT_EXEC:
 				if (me->children == NULL) {
@@ -292,7 +303,7 @@ int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock)
 
 					// (recursively) do it for the entry's parameters
 					for (entry = me->children; entry != NULL; entry = entry->next) {
-						if (menu_sock_send(entry, me, sock) < 0)
+						if (menu_sock_send(entry, me, sock, on_demand) < 0)
 							return -1;
 					}
 				}
@@ -424,6 +435,55 @@ int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock)
 }
 
 
+/**
+ * Send the entries of a menu to the server.
+ * \param me         Menu entry of type \c MT_MENU.
+ * \param sock       Socket connected to the server.
+ * \param on_demand  See menu_sock_send().
+ * \return  0 on success, -1 on error.
+ */
+int menu_sock_send_contents(MenuEntry *me, int sock, int on_demand)
+{
+	MenuEntry *entry;
+
+	if ((me == NULL) || (me->type != MT_MENU))
+		return 0;
+
+	for (entry = me->children; entry != NULL; entry = entry->next) {
+		if (menu_sock_send(entry, me, sock, on_demand) < 0)
+			return -1;
+	}
+	me->loaded = 1;
+	return 0;
+}
+
+
+/**
+ * Forget about the entries sent for menus that do not contain \c keep.
+ * The server discards the entries of on demand menus once they are left,
+ * so this needs to be called with each newly entered item.
+ * \param me    Menu entry hierarchy to check.
+ * \param keep  Entry the user is in.
+ */
+void menu_unload(MenuEntry *me, MenuEntry *keep)
+{
+	MenuEntry *entry;
+
+	if ((me == NULL) || (me->type != MT_MENU))
+		return;
+
+	if (me->loaded) {
+		for (entry = keep; (entry != NULL) && (entry != me); entry = entry->parent)
+			;
+		if (entry == NULL)
+			me->loaded = 0;
+	}
+
+	for (entry = me->children; entry != NULL; entry = entry->next)
+		menu_unload(entry, keep);
+}
+
+
 /** find menu entry by its id */
 MenuEntry *menu_find_by_id(MenuEntry *me, int id)
 {
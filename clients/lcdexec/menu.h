@@ -52,6 +52,7 @@ typedef struct menu_entry {
 	int numChildren;		/**< # of child entries. */
 	struct menu_entry *children;	/**< Subordinate menu entries (for type \c MT_MENU & \c MT_EXEC). */
 	struct menu_entry *next;	/**< Next sibling menu entry (for type \c MT_MENU). */
+	int loaded;		/**< Entries have been sent to the server (on demand only). */
 
 	// Variables specific to one special type
 	union data {
@@ -96,7 +97,9 @@ typedef struct menu_entry {
 
 
 MenuEntry *menu_read(MenuEntry *parent, const char *name);
-int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock);
+int menu_sock_send(MenuEntry *me, MenuEntry *parent, int sock, int on_demand);
+int menu_sock_send_contents(MenuEntry *me, int sock, int on_demand);
+void menu_unload(MenuEntry *me, MenuEntry *keep);
 MenuEntry *menu_find_by_id(MenuEntry *me, int id);
 const char *menu_command(MenuEntry *me);
 void menu_free(MenuEntry *me);
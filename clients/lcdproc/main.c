@@ -686,14 +686,16 @@ main_loop(void)
 					if (sequence[i].timer >= sequence[i].on_time) {
 						sequence[i].timer = 0;
 						/* Now, update the screen... */
-						update_screen(&sequence[i], 1);
+						if (update_screen(&sequence[i], 1) < 0)
+							exit_program(EXIT_FAILURE);
 					}
 				}
 				else {
 					if (sequence[i].timer >= sequence[i].off_time) {
 						sequence[i].timer = 0;
 						/* Now, update the screen... */
-						update_screen(&sequence[i], sequence[i].show_invisible);
+						if (update_screen(&sequence[i], sequence[i].show_invisible) < 0)
+							exit_program(EXIT_FAILURE);
 					}
 				}
 				if (islow > 0)
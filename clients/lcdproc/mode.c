@@ -26,6 +26,7 @@
 #endif
 
 #include "shared/sockets.h"
+#include "shared/report.h"
 
 #include "main.h"
 #include "mode.h"
@@ -58,7 +59,7 @@ mode_close(void)
  *
  * \param m        The screen mode
  * \param display  Flag whether to update screen even if not visible.
- * \return  Backlight state
+ * \return  Backlight state, -1 if the update could not be sent.
  */
 int
 update_screen(ScreenMode *m, int display)
@@ -66,6 +67,12 @@ update_screen(ScreenMode *m, int display)
 	static int status = -1;
 	int old_status = status;
 
+	/* Send all commands of this update with one write */
+	if (sock_buffer_begin(sock) < 0) {
+		report(RPT_ERR, "%s: error sending to LCDd", __FUNCTION__);
+		return -1;
+	}
+
 	if (m && m->func) {
 #ifdef LCDPROC_EYEBOXONE
 		/* Save the initialized flag (may be modified by m->func) */
@@ -90,6 +97,11 @@ update_screen(ScreenMode *m, int display)
 			sock_send_string(sock, "backlight blink\n");
 	}
 
+	if (sock_buffer_flush() < 0) {
+		report(RPT_ERR, "%s: error sending screen update to LCDd", __FUNCTION__);
+		return -1;
+	}
+
 	return (status);
 }
 
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -38,6 +39,7 @@ short scroll_x = 0, scroll_y = 0;
 short lcd_cursor_x, lcd_cursor_y;
 short lcd_width = 0, lcd_height = 0;
 char *lcd_buf = NULL;
+static char *out_buf = NULL;
 
 short last_vc_cursor_y = 0;
 short last_vc_cursor_x = 0;
@@ -268,11 +270,9 @@ int process_response(char *str)
 
 int update_display(void)
 {
-	//int bytes_read;
 	short line;
 	int e = 0;
-	char buf[80];
-	char *str_buf;
+	char *a;
 	short num_lines;
 	num_lines = min(lcd_height, vc_height);
 
@@ -280,10 +280,20 @@ int update_display(void)
 		return 0;
 
 	if (!lcd_buf) {
-		/* Not yet allocated */
+		/* Not yet allocated: the screen contents as last sent, and room
+		 * for one update of all lines plus the cursor command */
 		lcd_buf = malloc(lcd_width * lcd_height);
+		out_buf = malloc(80 + lcd_height * (40 + 2 * lcd_width));
+		if (!lcd_buf || !out_buf) {
+			report(RPT_ERR, "malloc failure: %s", strerror(errno));
+			free(lcd_buf);
+			free(out_buf);
+			lcd_buf = out_buf = NULL;
+			return -1;
+		}
 		memset(lcd_buf, ' ', lcd_width * lcd_height);
 	}
+	a = out_buf;
 
 	if (autoscroll
 	&& (last_vc_cursor_x != vc_cursor_x || last_vc_cursor_y != vc_cursor_y)) {
@@ -309,22 +319,21 @@ int update_display(void)
 		/* New scroll positions, send the cursor command */
 		if (lcd_cursor_x < 1 || lcd_cursor_x > lcd_width
 		|| lcd_cursor_y < 1 || lcd_cursor_y > lcd_height) {
-			snprintf(buf, sizeof(buf)-1, "screen_set console -cursor off\n");
+			a += sprintf(a, "screen_set console -cursor off\n");
 		} else {
-			snprintf(buf, sizeof(buf)-1, "screen_set console -cursor on -cursor_x %d -cursor_y %d\n",
+			a += sprintf(a, "screen_set console -cursor on -cursor_x %d -cursor_y %d\n",
 					lcd_cursor_x, lcd_cursor_y);
 		}
-		buf[sizeof(buf)-1] = 0;
-		CHAIN(e, sock_send_string(sock, buf));
 	}
 
-	/* Send all (changed) lines */
-	str_buf = malloc(80 + 2 * lcd_width);
+	/* Collect all (changed) lines */
 	for (line = 0; line < num_lines; line++) {
 
 		char *vc_p;
 		char *lcd_p;
 		short line_width;
+		short first, last;
+		short pos;
 
 		line_width = min(lcd_width, vc_width);
 
@@ -333,36 +342,43 @@ int update_display(void)
 		lcd_p = lcd_buf + lcd_width * line;
 
 		/* Has the line data changed ? */
-		if (memcmp(vc_p, lcd_p, line_width) != 0) {
-			/* Yes, so send it */
-			char *a;
-			short pos;
-
-			/* Format/escape the data */
-			snprintf(str_buf, 80, "widget_set console line%d 1 %d \"", line, line+1);
-
-			a = str_buf + strlen(str_buf); /* start just after the " */
-			for (pos = 0; pos < line_width; pos++) {
-				if (vc_p[pos] == '\\' || vc_p[pos] == '\"') {
-					*a++ = '\\'; /* add escape char */
-				}
-				if ((signed char) vc_p[pos] >= 32) {
-					*a++ = vc_p[pos]; /* add char */
-				} else {
-					*a++ = '?';
-				}
+		if (memcmp(vc_p, lcd_p, line_width) == 0)
+			continue;
+
+		/* Yes, find the changed columns and store the new data */
+		for (first = 0; vc_p[first] == lcd_p[first]; first++)
+			;
+		for (last = line_width - 1; vc_p[last] == lcd_p[last]; last--)
+			;
+		memcpy(lcd_p + first, vc_p + first, last - first + 1);
+
+		/*
+		 * A string widget can only be set as a whole, but the display
+		 * is cleared before rendering, so trailing blanks need not be
+		 * sent.
+		 */
+		while (line_width > 0 && vc_p[line_width - 1] == ' ')
+			line_width--;
+
+		/* Format/escape the data */
+		a += sprintf(a, "widget_set console line%d 1 %d \"", line, line+1);
+		for (pos = 0; pos < line_width; pos++) {
+			if (vc_p[pos] == '\\' || vc_p[pos] == '\"') {
+				*a++ = '\\'; /* add escape char */
+			}
+			if ((signed char) vc_p[pos] >= 32) {
+				*a++ = vc_p[pos]; /* add char */
+			} else {
+				*a++ = '?';
 			}
-			*a++ = '\"'; /* end string */
-			*a++ = '\n'; /* newline */
-			*a = 0; /* terminate */
-			CHAIN(e, sock_send_string(sock, str_buf));
-
-			/* And store the new data */
-			memcpy(lcd_p, vc_p, line_width);
-
 		}
+		*a++ = '\"'; /* end string */
+		*a++ = '\n'; /* newline */
 	}
-	free(str_buf);
+
+	/* Send everything at once */
+	if (a > out_buf)
+		CHAIN(e, sock_send(sock, out_buf, a - out_buf));
 
 	if (e < 0) {
 		report(RPT_ERR, "Error while sending data to LCDd");
@@ -373,6 +389,19 @@ int update_display(void)
 }
 
 
+/**
+ * Check whether the server closed the connection. To be called when the
+ * socket was reported readable, but no complete response could be read.
+ * \return  1 if the server closed the connection, 0 otherwise.
+ */
+int server_closed(void)
+{
+	char c;
+
+	return (recv(sock, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0);
+}
+
+
 int send_nop(void)
 {
 	return sock_send_string(sock, "\n");
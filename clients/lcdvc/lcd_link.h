@@ -3,6 +3,7 @@
 
 extern char *address;
 extern int port;
+extern int sock;
 
 int setup_connection(void);
 int teardown_connection(void);
@@ -10,5 +11,6 @@ int read_response(char *str, int maxsize);
 int process_response(char *str);
 int update_display(void);
 int send_nop(void);
+int server_closed(void);
 
 #endif
@@ -17,6 +17,8 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <time.h>
+#include <poll.h>
 #include <signal.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -41,6 +43,11 @@
 #define DEFAULT_CONFIGFILE	SYSCONFDIR "/lcdvc.conf"
 #define DEFAULT_PIDFILE		PIDFILEDIR "/lcdvc.pid"
 
+/** Minimum time between two reads of the console in milliseconds */
+#define UPDATE_INTERVAL		50
+/** Interval in milliseconds to check that the server still exists */
+#define NOP_INTERVAL		3000
+
 
 char *help_text =
 "lcdvc - LCDproc virtual console\n"
@@ -266,35 +273,105 @@ static int process_configfile(char *configfile)
 }
 
 
+/**
+ * Milliseconds elapsed since \c since on the monotonic clock.
+ * \param since  Start time.
+ * \return  Elapsed time in milliseconds, never negative.
+ */
+static long ms_since(struct timespec *since)
+{
+	struct timespec now;
+	long elapsed;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (now.tv_sec - since->tv_sec) * 1000L
+		+ (now.tv_nsec - since->tv_nsec) / 1000000L;
+	return (elapsed > 0) ? elapsed : 0;
+}
+
+
+/**
+ * Wait for server responses and for changes of the console. Linux signals
+ * changes of the console with POLLPRI on /dev/vcsa, so nothing is done while
+ * both the console and the server are idle. Console changes are read at most
+ * every UPDATE_INTERVAL ms to keep a fast-scrolling console from flooding
+ * the server.
+ */
 static int main_loop(void)
 {
-	int num_bytes;
+	int num_bytes = 0;
 	char buf[80];
-	short w = 0;
-
-	/* Continuously check if we get a menu event... */
+	struct pollfd fds[2];
+	struct timespec last_read, last_nop;
+
+	fds[0].fd = sock;
+	fds[0].events = POLLIN;
+	fds[1].fd = vcsa;
+	fds[1].events = POLLPRI;
+
+	/* The kernel records changes only after the first poll() */
+	poll(&fds[1], 1, 0);
+	read_vcdata();
+	update_display();
+	clock_gettime(CLOCK_MONOTONIC, &last_read);
+	clock_gettime(CLOCK_MONOTONIC, &last_nop);
+
+	while (!Quit) {
+		int nfds = 1;
+		int timeout;
+		long elapsed;
+		int changed = 0;
+
+		/* Send an empty line every 3 seconds to make sure the server still exists */
+		timeout = NOP_INTERVAL - ms_since(&last_nop);
+		if (timeout <= 0) {
+			if (send_nop() < 0)
+				break; /* Out of while loop */
+			clock_gettime(CLOCK_MONOTONIC, &last_nop);
+			timeout = NOP_INTERVAL;
+		}
 
-	while (!Quit && ((num_bytes = read_response(buf, sizeof(buf)-1)) >= 0)) {
-		if (num_bytes != 0) {
-			process_response(buf);
+		/* Only look at the console if it was not read just now */
+		elapsed = ms_since(&last_read);
+		if (elapsed >= UPDATE_INTERVAL)
+			nfds = 2;
+		else if (timeout > UPDATE_INTERVAL - elapsed)
+			timeout = UPDATE_INTERVAL - elapsed;
+
+		fds[0].revents = fds[1].revents = 0;
+		if (poll(fds, nfds, timeout) < 0) {
+			if (errno == EINTR)
+				continue;
+			report(RPT_ERR, "poll failed: %s", strerror(errno));
+			break;
 		}
-		else {
-			read_vcdata();
-			update_display();
 
-			/* Send an empty line every 3 seconds to make sure the server still exists */
-			if (w++ >= 60) {
-				w = 0;
-				if (send_nop() < 0) {
-					break; /* Out of while loop */
-				}
+		if (fds[0].revents) {
+			int responses = 0;
+
+			/* Continuously check if we get a menu event... */
+			while ((num_bytes = read_response(buf, sizeof(buf)-1)) > 0) {
+				process_response(buf);
+				responses++;
 			}
-			usleep(50000);
+			if (num_bytes < 0 || (responses == 0 && server_closed()))
+				break; /* Out of while loop */
+			changed = 1;
+		}
+
+		/* POLLERR without POLLPRI: kernel without change notification,
+		 * this degrades to reading every UPDATE_INTERVAL ms */
+		if (fds[1].revents) {
+			read_vcdata();
+			clock_gettime(CLOCK_MONOTONIC, &last_read);
+			changed = 1;
 		}
+
+		if (changed)
+			update_display();
 	}
 
 	if (!Quit)
 		report(RPT_WARNING, "Server disconnected %d", num_bytes);
 	return 0;
 }
-
@@ -57,9 +57,9 @@ int read_vcdata(void)
 	int bytes_read;
 	unsigned char buf[20];
 
-	/* Read size and cursor position from /dev/vcsa */
-	lseek(vcsa, 0, SEEK_SET);
-	bytes_read = read(vcsa, buf, 4);
+	/* Read size and cursor position from /dev/vcsa. This also re-arms
+	 * the change notification that main_loop() polls for. */
+	bytes_read = pread(vcsa, buf, 4, 0);
 	if (bytes_read != 4) {
 		report(RPT_ERR, "Could not read from %s", vcsa_device);
 		return -1;
@@ -86,8 +86,7 @@ int read_vcdata(void)
 	}
 
 	/* Read characters from /dev/cvs0 */
-	lseek(vcs0, 0, SEEK_SET);
-	bytes_read = read(vcs0, vc_buf, vc_width * vc_height);
+	bytes_read = pread(vcs0, vc_buf, vc_width * vc_height, 0);
 	if (bytes_read != vc_width * vc_height) {
 		report(RPT_ERR, "Could not read from %s", vcs_device);
 		return -1;
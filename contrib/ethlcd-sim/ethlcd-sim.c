@@ -0,0 +1,379 @@
+/*
+ * ethlcd-sim: a stand-in for the ethlcd network display.
+ *
+ * Listens on the ethlcd TCP port and answers the ethlcd protocol the way the
+ * real device does: every command is acknowledged with its command byte,
+ * ETHLCD_GET_BUTTONS additionally returns the (inverted) button state. The
+ * HD44780 display memory is emulated so the screen can be printed.
+ *
+ * Options allow to add latency to each received frame and to drop the
+ * connection after a number of commands, which makes it possible to look at
+ * the effect of the hd44780 driver's EthlcdBatch option and at its reconnect
+ * handling without the hardware.
+ *
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/* Keep in sync with server/drivers/hd44780-ethlcd.h */
+#define DEFAULT_ETHLCD_PORT             2425
+
+#define ETHLCD_SEND_INSTR               0x01
+#define ETHLCD_SEND_DATA                0x02
+#define ETHLCD_GET_BUTTONS              0x03
+#define ETHLCD_SET_BACKLIGHT            0x04
+#define ETHLCD_SET_BEEP                 0x05
+#define ETHLCD_GET_FIRMWARE_VERSION     0x06
+#define ETHLCD_GET_PROTOCOL_VERSION     0x07
+#define ETHLCD_GET_ENC_REVISION         0x08
+#define ETHLCD_CLOSE_CONN               0x09
+#define ETHLCD_UNRECOGNIZED_COMMAND     0x0A
+
+#define DDRAM_SIZE	0x80
+#define CGRAM_SIZE	0x40
+
+static struct {
+	int port;		/* TCP port to listen on */
+	int latency;		/* delay in ms before a frame is answered */
+	long drop_after;	/* close connection after that many commands */
+	int width, height;	/* display size for printing */
+	int verbose;		/* print screen after every frame */
+} opt = { DEFAULT_ETHLCD_PORT, 0, 0, 20, 4, 0 };
+
+static struct {
+	unsigned char ddram[DDRAM_SIZE];
+	unsigned char cgram[CGRAM_SIZE];
+	int addr;		/* current address counter */
+	int cg;			/* address counter points to CGRAM */
+	int backlight;
+} lcd;
+
+static struct {
+	long connections;
+	long frames;
+	long commands;
+	long bytes;
+} stats;
+
+static long next_drop;		/* command count at which to drop next */
+
+static volatile sig_atomic_t got_signal = 0;
+
+
+static void
+usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-p port] [-l latency_ms] [-d drop_after] [-s WxH] [-v]\n"
+		"  -p port        TCP port to listen on (default %d)\n"
+		"  -l latency_ms  delay before answering each received frame\n"
+		"  -d count       close the connection after count commands\n"
+		"  -s WxH         display size used for printing (default 20x4)\n"
+		"  -v             print the screen after every frame\n",
+		prog, DEFAULT_ETHLCD_PORT);
+	exit(1);
+}
+
+
+static void
+signal_handler(int sig)
+{
+	got_signal = sig;
+}
+
+
+/* Map a display position to the HD44780 DDRAM address (like the driver). */
+static int
+ddram_address(int x, int y)
+{
+	int addr = x + (y % 2) * 0x40;
+
+	if ((y % 4) >= 2)
+		addr += opt.width;
+	return addr;
+}
+
+
+static void
+print_screen(void)
+{
+	int x, y;
+
+	printf("+");
+	for (x = 0; x < opt.width; x++)
+		putchar('-');
+	printf("+ backlight %d\n", lcd.backlight);
+	for (y = 0; y < opt.height; y++) {
+		putchar('|');
+		for (x = 0; x < opt.width; x++) {
+			unsigned char c = lcd.ddram[ddram_address(x, y) % DDRAM_SIZE];
+
+			putchar((c < 8) ? '0' + c : ((c < 0x20 || c > 0x7E) ? '?' : c));
+		}
+		printf("|\n");
+	}
+	printf("+");
+	for (x = 0; x < opt.width; x++)
+		putchar('-');
+	printf("+\n");
+	fflush(stdout);
+}
+
+
+static void
+print_stats(void)
+{
+	printf("connections %ld, frames %ld, commands %ld, bytes %ld",
+	       stats.connections, stats.frames, stats.commands, stats.bytes);
+	if (stats.frames > 0)
+		printf(", %.1f commands/frame", (double) stats.commands / stats.frames);
+	printf("\n");
+	fflush(stdout);
+}
+
+
+/* Execute an HD44780 instruction. Only what LCDd uses is emulated. */
+static void
+lcd_instruction(unsigned char ch)
+{
+	if (ch & 0x80) {		/* set DDRAM address */
+		lcd.addr = ch & 0x7F;
+		lcd.cg = 0;
+	}
+	else if (ch & 0x40) {		/* set CGRAM address */
+		lcd.addr = ch & 0x3F;
+		lcd.cg = 1;
+	}
+	else if (ch == 0x01) {		/* clear */
+		memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+		lcd.addr = 0;
+		lcd.cg = 0;
+	}
+	else if ((ch & 0xFE) == 0x02) {	/* home */
+		lcd.addr = 0;
+		lcd.cg = 0;
+	}
+}
+
+
+static void
+lcd_data(unsigned char ch)
+{
+	if (lcd.cg) {
+		lcd.cgram[lcd.addr] = ch;
+		lcd.addr = (lcd.addr + 1) % CGRAM_SIZE;
+	}
+	else {
+		lcd.ddram[lcd.addr] = ch;
+		lcd.addr = (lcd.addr + 1) % DDRAM_SIZE;
+	}
+}
+
+
+/*
+ * Process as many complete commands from buf as possible and append the
+ * answers to reply. Returns the number of bytes consumed, -1 if the
+ * connection should be closed.
+ */
+static int
+process(unsigned char *buf, int len, unsigned char *reply, int *rlen)
+{
+	int pos = 0;
+
+	while (pos < len) {
+		unsigned char cmd = buf[pos];
+		int need = 1;
+
+		switch (cmd) {
+		    case ETHLCD_SEND_INSTR:
+		    case ETHLCD_SEND_DATA:
+		    case ETHLCD_SET_BACKLIGHT:
+		    case ETHLCD_SET_BEEP:
+			need = 2;
+			break;
+		}
+		if (pos + need > len)
+			break;		/* wait for the rest of the command */
+
+		if ((opt.drop_after > 0) && (stats.commands >= next_drop)) {
+			printf("dropping connection after %ld commands\n", stats.commands);
+			next_drop += opt.drop_after;
+			return -1;
+		}
+		stats.commands++;
+
+		switch (cmd) {
+		    case ETHLCD_SEND_INSTR:
+			lcd_instruction(buf[pos + 1]);
+			reply[(*rlen)++] = cmd;
+			break;
+		    case ETHLCD_SEND_DATA:
+			lcd_data(buf[pos + 1]);
+			reply[(*rlen)++] = cmd;
+			break;
+		    case ETHLCD_SET_BACKLIGHT:
+			lcd.backlight = buf[pos + 1];
+			reply[(*rlen)++] = cmd;
+			break;
+		    case ETHLCD_SET_BEEP:
+			reply[(*rlen)++] = cmd;
+			break;
+		    case ETHLCD_GET_BUTTONS:
+			reply[(*rlen)++] = cmd;
+			reply[(*rlen)++] = 0xFF;	/* negative logic: none pressed */
+			break;
+		    case ETHLCD_GET_FIRMWARE_VERSION:
+		    case ETHLCD_GET_PROTOCOL_VERSION:
+		    case ETHLCD_GET_ENC_REVISION:
+			reply[(*rlen)++] = cmd;
+			reply[(*rlen)++] = 0x01;
+			break;
+		    case ETHLCD_CLOSE_CONN:
+			return -1;
+		    default:
+			reply[(*rlen)++] = ETHLCD_UNRECOGNIZED_COMMAND;
+			break;
+		}
+		pos += need;
+	}
+	return pos;
+}
+
+
+static void
+serve(int sock)
+{
+	unsigned char buf[4096];
+	unsigned char reply[2 * sizeof(buf)];
+	int have = 0;
+
+	while (!got_signal) {
+		int len, used, rlen = 0;
+
+		len = read(sock, buf + have, sizeof(buf) - have);
+		if (len <= 0)
+			break;
+		stats.frames++;
+		stats.bytes += len;
+		have += len;
+
+		if (opt.latency > 0)
+			usleep(opt.latency * 1000);
+
+		used = process(buf, have, reply, &rlen);
+		if ((rlen > 0) && (write(sock, reply, rlen) != rlen))
+			break;
+		if (used < 0)
+			break;
+		memmove(buf, buf + used, have - used);
+		have -= used;
+
+		if (opt.verbose)
+			print_screen();
+	}
+}
+
+
+int
+main(int argc, char **argv)
+{
+	struct sockaddr_in addr;
+	struct sigaction sa;
+	int listener, c, one = 1;
+
+	while ((c = getopt(argc, argv, "p:l:d:s:vh")) > 0) {
+		switch (c) {
+		    case 'p':
+			opt.port = atoi(optarg);
+			break;
+		    case 'l':
+			opt.latency = atoi(optarg);
+			break;
+		    case 'd':
+			opt.drop_after = atol(optarg);
+			break;
+		    case 's':
+			if ((sscanf(optarg, "%dx%d", &opt.width, &opt.height) != 2)
+			    || (opt.width < 1) || (opt.width > 40)
+			    || (opt.height < 1) || (opt.height > 4))
+				usage(argv[0]);
+			break;
+		    case 'v':
+			opt.verbose = 1;
+			break;
+		    default:
+			usage(argv[0]);
+		}
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = signal_handler;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	listener = socket(PF_INET, SOCK_STREAM, 0);
+	if (listener < 0) {
+		perror("socket");
+		return 1;
+	}
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(opt.port);
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(listener, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		perror("bind");
+		return 1;
+	}
+	if (listen(listener, 1) < 0) {
+		perror("listen");
+		return 1;
+	}
+
+	next_drop = opt.drop_after;
+	memset(lcd.ddram, ' ', sizeof(lcd.ddram));
+	printf("ethlcd-sim listening on port %d\n", opt.port);
+	fflush(stdout);
+
+	while (!got_signal) {
+		struct sockaddr_in peer;
+		socklen_t peerlen = sizeof(peer);
+		int sock = accept(listener, (struct sockaddr *) &peer, &peerlen);
+
+		if (sock < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("accept");
+			break;
+		}
+		/* the device answers immediately, do not let Nagle delay it */
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		stats.connections++;
+		printf("connection from %s\n", inet_ntoa(peer.sin_addr));
+		fflush(stdout);
+
+		serve(sock);
+		close(sock);
+
+		print_screen();
+		print_stats();
+	}
+
+	close(listener);
+	print_stats();
+	return 0;
+}
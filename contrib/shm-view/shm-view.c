@@ -0,0 +1,172 @@
+/*
+ * shm-view: print the screen LCDd publishes in shared memory.
+ *
+ * Maps the shared memory object written by the shm driver (or the glcd
+ * driver's shm connection type) read-only and prints every new frame. The
+ * screen is copied under the sequence lock described in shm-lcd.h, readers
+ * sleep on the futex in between frames.
+ *
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "shm-lcd.h"
+
+static volatile sig_atomic_t got_signal = 0;
+
+
+static void
+usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [-n name] [-1]\n"
+		"  -n name  shared memory object to read (default %s)\n"
+		"  -1       print the current frame once and exit\n",
+		prog, SHM_LCD_DEFAULT_NAME);
+	exit(1);
+}
+
+
+static void
+signal_handler(int sig)
+{
+	got_signal = sig;
+}
+
+
+/* Map the segment; the header tells the full size. */
+static ShmLcdHeader *
+map_segment(const char *name, size_t *size)
+{
+	ShmLcdHeader *hdr;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+	if ((fstat(fd, &st) < 0) || (st.st_size < (off_t) sizeof(ShmLcdHeader))) {
+		close(fd);
+		return NULL;
+	}
+	hdr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hdr == MAP_FAILED)
+		return NULL;
+
+	if ((hdr->magic != SHM_LCD_MAGIC) || (hdr->version != SHM_LCD_VERSION)
+	    || (hdr->size > st.st_size)) {
+		munmap(hdr, st.st_size);
+		return NULL;
+	}
+	*size = st.st_size;
+	return hdr;
+}
+
+
+static void
+print_frame(const ShmLcdHeader *hdr, const unsigned char *data, uint32_t frame,
+	    int backlight)
+{
+	unsigned int x, y;
+
+	printf("frame %u, %ux%u %s, backlight %s\n", frame, hdr->width, hdr->height,
+	       (hdr->type == SHM_LCD_TEXT) ? "characters" : "pixels",
+	       backlight ? "on" : "off");
+
+	for (y = 0; y < hdr->height; y++) {
+		const unsigned char *row = data + y * hdr->bytes_per_line;
+
+		putchar('|');
+		for (x = 0; x < hdr->width; x++) {
+			if (hdr->type == SHM_LCD_TEXT) {
+				unsigned char c = row[x];
+
+				/* custom characters are shown as their number */
+				putchar((c < SHM_LCD_CUSTOM_CHARS) ? '0' + c :
+					((c < 0x20 || c > 0x7E) ? '?' : c));
+			}
+			else {
+				putchar((row[x / 8] & (0x80 >> (x % 8))) ? '#' : '.');
+			}
+		}
+		printf("|\n");
+	}
+	fflush(stdout);
+}
+
+
+int
+main(int argc, char **argv)
+{
+	const char *name = SHM_LCD_DEFAULT_NAME;
+	ShmLcdHeader *hdr;
+	unsigned char *copy;
+	size_t size;
+	int c, once = 0;
+
+	while ((c = getopt(argc, argv, "n:1h")) > 0) {
+		switch (c) {
+		    case 'n':
+			name = optarg;
+			break;
+		    case '1':
+			once = 1;
+			break;
+		    default:
+			usage(argv[0]);
+		}
+	}
+
+	signal(SIGINT, signal_handler);
+	signal(SIGTERM, signal_handler);
+
+	hdr = map_segment(name, &size);
+	if (hdr == NULL) {
+		fprintf(stderr, "Cannot map %s: %s\n", name,
+			errno ? strerror(errno) : "not an LCDd segment");
+		return 1;
+	}
+	copy = malloc(hdr->data_size);
+	if (copy == NULL)
+		return 1;
+
+	while (!got_signal) {
+		uint32_t seq, frame;
+		int backlight, alive;
+
+		/* Copy a consistent frame, the writer is never blocked by us */
+		do {
+			seq = shm_lcd_read_begin(hdr);
+			memcpy(copy, shm_lcd_data(hdr), hdr->data_size);
+			frame = hdr->frame;
+			backlight = hdr->backlight;
+			alive = hdr->writer_pid;
+		} while (shm_lcd_read_retry(hdr, seq));
+
+		print_frame(hdr, copy, frame, backlight);
+		if (once)
+			break;
+		if (!alive) {
+			printf("LCDd has exited\n");
+			break;
+		}
+
+		/* Sleep until the next frame, check for LCDd restarts once a second */
+		shm_lcd_wait(hdr, seq, 1000);
+	}
+
+	free(copy);
+	munmap(hdr, size);
+	return 0;
+}
@@ -43,6 +43,11 @@ Client *client_create(int sock)
 	/* Init struct members*/
 	c->sock = sock;
 	c->messages = NULL;
+	c->queue_depth = 0;
+	c->queue_max = 0;
+	c->queue_report = CLIENT_QUEUE_REPORT;
+	c->msg_count = 0;
+	c->throttled = 0;
 	c->backlight = BACKLIGHT_OPEN;
 	c->heartbeat = HEARTBEAT_OPEN;
 
@@ -79,6 +84,10 @@ client_destroy(Client *c)
 
 	debug(RPT_DEBUG, "%s(c=[%d])", __FUNCTION__, c->sock);
 
+	if (c->queue_max >= CLIENT_QUEUE_REPORT || c->throttled > 0)
+		report(RPT_INFO, "Client on socket %d sent %ld messages, max. %d queued, throttled %ld times",
+			c->sock, c->msg_count, c->queue_max, c->throttled);
+
 	/* Close the socket */
 	close(c->sock);
 
@@ -141,6 +150,16 @@ client_add_message(Client *c, char *message)
 		debug(RPT_DEBUG, "%s(c=[%d], message=\"%s\")", __FUNCTION__,
 			c->sock, message);
 		err = LL_Enqueue(c->messages, (void *) message);
+		if (err == 0) {
+			c->msg_count++;
+			if (++c->queue_depth > c->queue_max)
+				c->queue_max = c->queue_depth;
+			if (c->queue_depth >= c->queue_report) {
+				report(RPT_NOTICE, "Client on socket %d has %d messages queued",
+					c->sock, c->queue_depth);
+				c->queue_report *= 2;
+			}
+		}
 	}
 
 	return err;
@@ -158,10 +177,21 @@ client_get_message(Client *c)
 		return NULL;
 
 	str = (char *) LL_Dequeue(c->messages);
+	if (str != NULL)
+		c->queue_depth--;
 
 	return str;
 }
 
+char *
+client_peek_message(Client *c)
+{
+	if (!c)
+		return NULL;
+
+	return (char *) LL_Look(c->messages);
+}
+
 
 Screen *
 client_find_screen(Client *c, char *id)
@@ -28,6 +28,9 @@
 
 #define CLIENT_NAME_SIZE 256
 
+/** Queue depth at which a flooding client is first reported (doubles after) */
+#define CLIENT_QUEUE_REPORT 64
+
 /** Possible states of a client. */
 typedef enum _clientstate {
 	NEW,			/**< Client did not yet send \c hello. */
@@ -45,6 +48,11 @@ typedef struct Client {
 	int heartbeat;
 
 	LinkedList *messages;		/**< Messages that the client sent. */
+	int queue_depth;		/**< Number of messages waiting in \c messages. */
+	int queue_max;			/**< Largest queue depth seen. */
+	int queue_report;		/**< Queue depth to report next. */
+	long msg_count;			/**< Number of messages received. */
+	long throttled;			/**< Passes that left messages over. */
 	LinkedList *screenlist;		/**< List of client's screens. */
 
 	void* menu;			/**< Menu hierarchy, if any */
@@ -75,6 +83,9 @@ int client_add_message(Client *c, char *message);
 /* Get message from queue */
 char *client_get_message(Client *c);
 
+/* Look at the next message in the queue without removing it */
+char *client_peek_message(Client *c);
+
 /* Find a named screen for the client */
 Screen *client_find_screen(Client *c, char *id);
 
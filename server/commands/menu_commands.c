@@ -318,6 +318,12 @@ menu_del_item_func(Client *c, int argc, char **argv)
  * -next id			()
  *	Sets the successor of this item (what happens after "Enter")
  *
+ * menu:
+ * -on_demand false|true	(false)
+ *	If set, the menu's contents are only kept while it is in use.
+ *	The client adds them when it gets the "enter" event of the menu,
+ *	the server deletes them when the user moves to an item outside it.
+ *
  * action:
  * -menu_result none|close|quit	(none)
  *	Sets what to do with the menu when this action is selected:
@@ -412,6 +418,7 @@ menu_set_item_func(Client *c, int argc, char **argv)
 		{ -1,			"is_hidden",	BOOLEAN,	offsetof(MenuItem,is_hidden) },
 		{ -1,			"prev",		STRING,		-1 },
 		{ -1,			"next",		STRING,		-1 },
+		{ MENUITEM_MENU,	"on_demand",	BOOLEAN,	offsetof(MenuItem,data.menu.on_demand) },
 		{ MENUITEM_ACTION,	"menu_result",	STRING,		-1 },
 		{ MENUITEM_CHECKBOX,	"value",	CHECKBOX_VALUE,	offsetof(MenuItem,data.checkbox.value) },
 		{ MENUITEM_CHECKBOX,	"allow_gray",	BOOLEAN,	offsetof(MenuItem,data.checkbox.allow_gray) },
@@ -173,6 +173,127 @@ widget_del_func(Client *c, int argc, char **argv)
 	return 0;
 }
 
+/**
+ * Find the widget a widget_set command refers to.
+ * Errors are reported to the client.
+ * \param c     The client that sent the command.
+ * \param argc  Number of arguments.
+ * \param argv  The arguments.
+ * \return  The widget, NULL on error.
+ */
+static Widget *
+widget_set_find(Client *c, int argc, char **argv)
+{
+	Screen *s;
+	Widget *w;
+
+	/* Find screen */
+	s = client_find_screen(c, argv[1]);
+	if (s == NULL) {
+		sock_send_error(c->sock, "Unknown screen id\n");
+		return NULL;
+	}
+	/* Find widget */
+	w = screen_find_widget(s, argv[2]);
+	if (w == NULL) {
+		sock_send_error(c->sock, "Unknown widget id\n");
+		/* Client Debugging...*/
+		{
+			int i;
+			report(RPT_WARNING, "Unknown widget id (%s)", argv[2]);
+			for (i = 0; i < argc; i++)
+				report(RPT_WARNING, "    %.40s ", argv[i]);
+		}
+		return NULL;
+	}
+	return w;
+}
+
+/**
+ * Check the widget specific data of a widget_set command without
+ * applying it.
+ * \param w     The widget the command refers to.
+ * \param argc  Number of arguments.
+ * \param argv  The arguments.
+ * \return  NULL if the data is valid, else the error message for the client.
+ */
+const char *
+widget_set_check(Widget *w, int argc, char **argv)
+{
+	/* number of data arguments and how many of them are coordinates */
+	int nargs, ncoords;
+	int i;
+
+	if (argc < 4)
+		return "Usage: widget_set <screenid> <widgetid> <widget-SPECIFIC-data>\n";
+
+	switch (w->type) {
+	case WID_STRING:		/* String takes "x y text" */
+	case WID_HBAR:			/* Hbar takes "x y length" */
+	case WID_VBAR:			/* Vbar takes "x y length" */
+	case WID_ICON:			/* Icon takes "x y icon" */
+		nargs = 3;
+		ncoords = 2;
+		break;
+	case WID_TITLE:			/* title takes "text" */
+		nargs = 1;
+		ncoords = 0;
+		break;
+	case WID_SCROLLER:		/* Scroller takes "left top right bottom direction speed text" */
+		nargs = 7;
+		ncoords = 4;
+		break;
+	case WID_FRAME:			/* Frame takes "left top right bottom wid hgt direction speed" */
+		nargs = 8;
+		ncoords = 6;
+		break;
+	case WID_NUM:			/* Num takes "x num" */
+		nargs = 2;
+		ncoords = 1;
+		break;
+	case WID_NONE:
+	default:
+		return "Widget has no type\n";
+	}
+
+	if (argc != 3 + nargs) {
+		return "Wrong number of arguments\n";
+	}
+	for (i = 3; i < 3 + ncoords; i++) {
+		if (!isdigit((unsigned int) argv[i][0])) {
+			return "Invalid coordinates\n";
+		}
+	}
+
+	switch (w->type) {
+	case WID_ICON:
+		if (widget_iconname_to_icon(argv[5]) == -1) {
+			return "Invalid icon name\n";
+		}
+		break;
+	case WID_SCROLLER:
+		/* Direction must be m, v or h*/
+		if ((argv[7][0] != 'h') && (argv[7][0] != 'v') && (argv[7][0] != 'm')) {
+			return "Invalid direction\n";
+		}
+		break;
+	case WID_FRAME:
+		/* Direction must be v or h*/
+		if ((argv[9][0] != 'h') && (argv[9][0] != 'v')) {
+			return "Invalid direction\n";
+		}
+		break;
+	case WID_NUM:
+		if (!isdigit((unsigned int) argv[4][0])) {
+			return "Invalid number\n";
+		}
+		break;
+	default:
+		break;
+	}
+	return NULL;
+}
+
 /**
  * Configures information about a widget, such as its size, shape,
  * contents, position, speed, etc.
@@ -185,15 +306,8 @@ int
 widget_set_func(Client *c, int argc, char **argv)
 {
 	int i;
-	char *wid;
-	char *sid;
-
-	int x, y;
-	int left, top, right, bottom;
-	int length, direction;
-	int width, height;
-	int speed;
-	Screen *s;
+	int old_y;
+	const char *error;
 	Widget *w;
 
 	if (c->state != ACTIVE)
@@ -210,241 +324,101 @@ widget_set_func(Client *c, int argc, char **argv)
 		return 0;
 	}
 
-	/* Find screen */
-	sid = argv[1];
-	s = client_find_screen(c, sid);
-	if (s == NULL) {
-		sock_send_error(c->sock, "Unknown screen id\n");
+	w = widget_set_find(c, argc, argv);
+	if (w == NULL)
 		return 0;
-	}
-	/* Find widget */
-	wid = argv[2];
-	w = screen_find_widget(s, wid);
-	if (w == NULL) {
-		sock_send_error(c->sock, "Unknown widget id\n");
-		/* Client Debugging...*/
-		{
-			int i;
-			report(RPT_WARNING, "Unknown widget id (%s)", argv[2]);
-			for (i = 0; i < argc; i++)
-				report(RPT_WARNING, "    %.40s ", argv[i]);
-		}
+	error = widget_set_check(w, argc, argv);
+	if (error != NULL) {
+		sock_send_error(c->sock, (char *) error);
 		return 0;
 	}
+
+	old_y = w->y;
 	i = 3;
 	switch (w->type) {
 	case WID_STRING:		/* String takes "x y text" */
-		if (argc != i + 3)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if ((!isdigit((unsigned int) argv[i][0])) ||
-			    (!isdigit((unsigned int) argv[i + 1][0]))) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			}
-			else {					  /* Set all the data...*/
-				x = atoi(argv[i]);
-				y = atoi(argv[i + 1]);
-				w->x = x;
-				w->y = y;
-				if (w->text != NULL)
-					free(w->text);
-				w->text = strdup(argv[i + 2]);
-				if (w->text == NULL) {
-					report(RPT_WARNING, "widget_set_func: Allocation error");
-					return -1;
-				}
-				debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
-				sock_send_string(c->sock, "success\n");
-			}
+		w->x = atoi(argv[i]);
+		w->y = atoi(argv[i + 1]);
+		if (w->text != NULL)
+			free(w->text);
+		w->text = strdup(argv[i + 2]);
+		if (w->text == NULL) {
+			report(RPT_WARNING, "widget_set_func: Allocation error");
+			return -1;
 		}
+		debug(RPT_DEBUG, "Widget %s set to %s", argv[2], w->text);
 		break;
 	case WID_HBAR:			/* Hbar takes "x y length" */
-		if (argc != i + 3)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if ((!isdigit((unsigned int) argv[i][0])) ||
-			    (!isdigit((unsigned int) argv[i + 1][0]))) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			} else {
-				x = atoi(argv[i]);
-				y = atoi(argv[i + 1]);
-				length = atoi(argv[i + 2]);
-				w->x = x;
-				w->y = y;
-				w->length = length;	/* This is the length in pixels */
-			}
-			debug(RPT_DEBUG, "Widget %s set to %i", wid, w->length);
-			sock_send_string(c->sock, "success\n");
-		}
+		w->x = atoi(argv[i]);
+		w->y = atoi(argv[i + 1]);
+		w->length = atoi(argv[i + 2]);	/* This is the length in pixels */
+		debug(RPT_DEBUG, "Widget %s set to %i", argv[2], w->length);
 		break;
 	case WID_VBAR:			/* Vbar takes "x y length" */
-		if (argc != i + 3)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if ((!isdigit((unsigned int) argv[i][0])) ||
-			    (!isdigit((unsigned int) argv[i + 1][0]))) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			} else {
-				x = atoi(argv[i]);
-				y = atoi(argv[i + 1]);
-				length = atoi(argv[i + 2]);
-				w->x = x;
-				w->y = y;
-				w->length = length;
-			}
-			debug(RPT_DEBUG, "Widget %s set to %i", wid, w->length);
-			sock_send_string(c->sock, "success\n");
-		}
+		w->x = atoi(argv[i]);
+		w->y = atoi(argv[i + 1]);
+		w->length = atoi(argv[i + 2]);
+		debug(RPT_DEBUG, "Widget %s set to %i", argv[2], w->length);
 		break;
 	case WID_ICON:			/* Icon takes "x y icon" */
-		if (argc != i + 3)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if ((!isdigit((unsigned int) argv[i][0])) ||
-			    (!isdigit((unsigned int) argv[i + 1][0]))) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			} else {
-				int icon;
-
-				x = atoi(argv[i]);
-				y = atoi(argv[i + 1]);
-				icon = widget_iconname_to_icon(argv[i + 2]);
-				if (icon == -1) {
-					sock_send_error(c->sock, "Invalid icon name\n");
-				}
-				else {
-					w->x = x;
-					w->y = y;
-					w->length = icon;
-					sock_send_string(c->sock, "success\n");
-				}
-			}
-		}
+		w->x = atoi(argv[i]);
+		w->y = atoi(argv[i + 1]);
+		w->length = widget_iconname_to_icon(argv[i + 2]);
 		break;
 	case WID_TITLE:			/* title takes "text" */
-		if (argc != i + 1)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if (w->text != NULL)
-				free(w->text);
-			w->text = strdup(argv[i]);
-			if (w->text == NULL) {
-				report(RPT_WARNING, "widget_set_func: Allocation error");
-				return -1;
-			}
-			/* Set width too */
-			w->width = display_props->width;
-			debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
-			sock_send_string(c->sock, "success\n");
+		if (w->text != NULL)
+			free(w->text);
+		w->text = strdup(argv[i]);
+		if (w->text == NULL) {
+			report(RPT_WARNING, "widget_set_func: Allocation error");
+			return -1;
 		}
+		/* Set width too */
+		w->width = display_props->width;
+		debug(RPT_DEBUG, "Widget %s set to %s", argv[2], w->text);
 		break;
 	case WID_SCROLLER:		/* Scroller takes "left top right bottom direction speed text" */
-		if (argc != i + 7)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if ((!isdigit((unsigned int) argv[i][0])) ||
-			    (!isdigit((unsigned int) argv[i + 1][0])) ||
-			    (!isdigit((unsigned int) argv[i + 2][0])) ||
-			    (!isdigit((unsigned int) argv[i + 3][0]))) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			}
-			else {
-				left = atoi(argv[i]);
-				top = atoi(argv[i + 1]);
-				right = atoi(argv[i + 2]);
-				bottom = atoi(argv[i + 3]);
-				direction = (int) (argv[i + 4][0]);
-				speed = atoi(argv[i + 5]);
-				/* Direction must be m, v or h*/
-				if (((char) direction != 'h') && ((char) direction != 'v') &&
-				    ((char) direction != 'm')) {
-					sock_send_error(c->sock, "Invalid direction\n");
-				}
-				else {
-					w->left = left;
-					w->top = top;
-					w->right = right;
-					w->bottom = bottom;
-					w->length = direction;
-					w->speed = speed;
-					if (w->text != NULL)
-						free(w->text);
-					w->text = strdup(argv[i + 6]);
-					if (w->text == NULL) {
-						sock_send_error(c->sock, "Allocation error\n");
-						return -1;
-					}
-					debug(RPT_DEBUG, "Widget %s set to %s", wid, w->text);
-					sock_send_string(c->sock, "success\n");
-				}
-			}
+		w->left = atoi(argv[i]);
+		w->top = atoi(argv[i + 1]);
+		w->right = atoi(argv[i + 2]);
+		w->bottom = atoi(argv[i + 3]);
+		w->length = (int) (argv[i + 4][0]);	/* direction */
+		w->speed = atoi(argv[i + 5]);
+		if (w->text != NULL)
+			free(w->text);
+		w->text = strdup(argv[i + 6]);
+		if (w->text == NULL) {
+			sock_send_error(c->sock, "Allocation error\n");
+			return -1;
 		}
+		debug(RPT_DEBUG, "Widget %s set to %s", argv[2], w->text);
 		break;
 	case WID_FRAME:			/* Frame takes "left top right bottom wid hgt direction speed" */
-		if (argc != i + 8)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if ((!isdigit((unsigned int) argv[i][0])) ||
-			    (!isdigit((unsigned int) argv[i + 1][0])) ||
-			    (!isdigit((unsigned int) argv[i + 2][0])) ||
-			    (!isdigit((unsigned int) argv[i + 3][0])) ||
-			    (!isdigit((unsigned int) argv[i + 4][0])) ||
-			    (!isdigit((unsigned int) argv[i + 5][0]))) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			}
-			else {
-				left = atoi(argv[i]);
-				top = atoi(argv[i + 1]);
-				right = atoi(argv[i + 2]);
-				bottom = atoi(argv[i + 3]);
-				width = atoi(argv[i + 4]);
-				height = atoi(argv[i + 5]);
-				direction = (int) (argv[i + 6][0]);
-				speed = atoi(argv[i + 7]);
-				/* Direction must be v or h*/
-				if (((char) direction != 'h') && ((char) direction != 'v')) {
-					sock_send_error(c->sock, "Invalid direction\n");
-				}
-				else {
-					w->left = left;
-					w->top = top;
-					w->right = right;
-					w->bottom = bottom;
-					w->width = width;
-					w->height = height;
-					w->length = direction;
-					w->speed = speed;
-					debug(RPT_DEBUG, "Widget %s set to (%i,%i)-(%i,%i) %ix%i", wid, left, top, right, bottom, width, height);
-					sock_send_string(c->sock, "success\n");
-				}
-			}
-		}
+		w->left = atoi(argv[i]);
+		w->top = atoi(argv[i + 1]);
+		w->right = atoi(argv[i + 2]);
+		w->bottom = atoi(argv[i + 3]);
+		w->width = atoi(argv[i + 4]);
+		w->height = atoi(argv[i + 5]);
+		w->length = (int) (argv[i + 6][0]);	/* direction */
+		w->speed = atoi(argv[i + 7]);
+		debug(RPT_DEBUG, "Widget %s set to (%i,%i)-(%i,%i) %ix%i", argv[2],
+		      w->left, w->top, w->right, w->bottom, w->width, w->height);
 		break;
 	case WID_NUM:			/* Num takes "x num" */
-		if (argc != i + 2)
-			sock_send_error(c->sock, "Wrong number of arguments\n");
-		else {
-			if (!isdigit((unsigned int) argv[i][0])) {
-				sock_send_error(c->sock, "Invalid coordinates\n");
-			}
-			else if (!isdigit((unsigned int) argv[i + 1][0])) {
-				sock_send_error(c->sock, "Invalid number\n");
-			}
-			else {
-				x = atoi(argv[i]);
-				y = atoi(argv[i + 1]);
-				w->x = x;
-				w->y = y;
-			}
-			debug(RPT_DEBUG, "Widget %s set to %i", wid, w->y);
-			sock_send_string(c->sock, "success\n");
-		}
+		w->x = atoi(argv[i]);
+		w->y = atoi(argv[i + 1]);
+		debug(RPT_DEBUG, "Widget %s set to %i", argv[2], w->y);
 		break;
 	case WID_NONE:
 	default:
-		sock_send_error(c->sock, "Widget has no type\n");
 		break;
 	}
+	sock_send_string(c->sock, "success\n");
+
+	/* The renderer finds widgets in frames by their row */
+	if (w->y != old_y)
+		screen_invalidate_index(w->screen);
 
 	return 0;
 }
@@ -15,5 +15,6 @@
 int widget_add_func(Client *c, int argc, char **argv);
 int widget_del_func(Client *c, int argc, char **argv);
 int widget_set_func(Client *c, int argc, char **argv);
+const char *widget_set_check(struct Widget *w, int argc, char **argv);
 
 #endif
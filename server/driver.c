@@ -17,6 +17,7 @@
 #include <errno.h>
 #include <dlfcn.h>
 #include <string.h>
+#include <sys/select.h>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -81,6 +82,8 @@ DriverSymbols driver_symbols[] = {
 static int request_display_width(void);
 static int request_display_height(void);
 static int driver_store_private_ptr(Driver *driver, void *private_data);
+static int driver_register_input_fd(Driver *driver, int fd);
+static int driver_unregister_input_fd(Driver *driver, int fd);
 
 
 /** Create a driver object.
@@ -285,6 +288,10 @@ driver_bind_module(Driver *driver)
 	driver->request_display_width	= request_display_width;
 	driver->request_display_height	= request_display_height;
 
+	/* Input event registration */
+	driver->register_input_fd	= driver_register_input_fd;
+	driver->unregister_input_fd	= driver_unregister_input_fd;
+
 	return 0;
 }
 
@@ -371,6 +378,59 @@ driver_store_private_ptr(Driver *driver, void *private_data)
 }
 
 
+/** Register a file descriptor that becomes readable when the driver has
+ * input. Once a driver has registered a descriptor its \c get_key method is
+ * only called after one of them was found readable, and then until it
+ * returns NULL.
+ * \param driver  Pointer to the driver object.
+ * \param fd      File descriptor to watch.
+ * \retval <0     Error, the driver has to be polled as before.
+ * \retval  0     Success.
+ */
+static int
+driver_register_input_fd(Driver *driver, int fd)
+{
+	debug(RPT_DEBUG, "%s(driver=[%.40s], fd=%d)", __FUNCTION__, driver->name, fd);
+
+	if ((fd < 0) || (fd >= FD_SETSIZE)) {
+		report(RPT_WARNING, "Driver [%.40s] registered invalid input fd %d",
+			driver->name, fd);
+		return -1;
+	}
+	if (driver->num_input_fds >= MAX_INPUT_FDS) {
+		report(RPT_WARNING, "Driver [%.40s] registered too many input fds",
+			driver->name);
+		return -1;
+	}
+	driver->input_fds[driver->num_input_fds++] = fd;
+	return 0;
+}
+
+
+/** Stop watching a file descriptor registered by driver_register_input_fd().
+ * Without registered descriptors the driver is polled again.
+ * \param driver  Pointer to the driver object.
+ * \param fd      File descriptor to remove.
+ * \retval <0     Error, the fd was not registered.
+ * \retval  0     Success.
+ */
+static int
+driver_unregister_input_fd(Driver *driver, int fd)
+{
+	int i;
+
+	debug(RPT_DEBUG, "%s(driver=[%.40s], fd=%d)", __FUNCTION__, driver->name, fd);
+
+	for (i = 0; i < driver->num_input_fds; i++) {
+		if (driver->input_fds[i] == fd) {
+			driver->input_fds[i] = driver->input_fds[--driver->num_input_fds];
+			return 0;
+		}
+	}
+	return -1;
+}
+
+
 static int
 request_display_width(void)
 {
@@ -437,6 +497,19 @@ driver_alt_hbar(Driver *drv, int x, int y, int len, int promille, int options)
 	debug(RPT_DEBUG, "%s(drv=[%.40s], x=%d, y=%d, len=%d, promille=%d, options=%d)",
 		__FUNCTION__, drv->name, x, y, len, promille, options);
 
+	/* Build the bar as one string: the cells are filled from the left */
+	if ((drv->string != NULL) && (len > 0)) {
+		char bar[len + 1];
+
+		for (pos = 0; (pos < len) && (2 * pos < ((long) promille * len / 500 + 1)); pos++)
+			bar[pos] = '-';
+		bar[pos] = '\0';
+
+		if (pos > 0)
+			drv->string(drv, x, y, bar);
+		return;
+	}
+
 	/* if the driver does not support output, do nothing */
 	if (drv->chr == NULL)
 		return;
@@ -15,6 +15,9 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/select.h>
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -450,28 +453,96 @@ drivers_output(int state)
 
 
 /**
- * Get key presses from loaded drivers.
- * \return  Pointer to key string for first driver ithat has a get_key() function defined
- *          and for which the get_key() function returns a key; otherwise \c NULL.
+ * Get the number of loaded drivers. Drivers are numbered from 0 in the order
+ * they were loaded.
+ * \return  Number of loaded drivers.
+ */
+int
+drivers_count(void)
+{
+	return LL_Length(loaded_drivers);
+}
+
+
+/**
+ * Get a key press from one of the loaded drivers.
+ * \param num  Number of the driver (see drivers_count()).
+ * \return     Pointer to key string if the driver has a get_key() function
+ *             defined and it returns a key; otherwise \c NULL. The string
+ *             may be overwritten by the next call.
  */
 const char *
-drivers_get_key(void)
+drivers_get_key(int num)
 {
-	/* Find the first input keystroke, if any */
 	Driver *drv;
 	const char *keystroke;
 
-	debug(RPT_DEBUG, "%s()", __FUNCTION__);
+	debug(RPT_DEBUG, "%s(num=%d)", __FUNCTION__, num);
+
+	drv = LL_GetByIndex(loaded_drivers, num);
+	if ((drv == NULL) || (drv->get_key == NULL))
+		return NULL;
+
+	/* Drivers with input fds are only asked if they have input */
+	if ((drv->num_input_fds > 0) && !drv->input_pending)
+		return NULL;
+
+	keystroke = drv->get_key(drv);
+	if (keystroke == NULL) {
+		drv->input_pending = 0;
+		return NULL;
+	}
+	report(RPT_INFO, "Driver [%.40s] generated keystroke %.40s", drv->name, keystroke);
+	return keystroke;
+}
+
 
+/**
+ * Wait until an input fd registered by a driver becomes readable, or until
+ * the timeout expires. Drivers with a readable fd are marked to be asked
+ * for keys by drivers_get_key().
+ * \param timeout  Maximum time to wait in microseconds, 0 to only check.
+ * \return         Number of drivers with pending input.
+ */
+int
+drivers_wait_input(long timeout)
+{
+	Driver *drv;
+	fd_set rfds;
+	struct timeval tv;
+	int maxfd = -1;
+	int pending = 0;
+	int i;
+
+	FD_ZERO(&rfds);
 	ForAllDrivers(drv) {
-		if (drv->get_key) {
-			keystroke = drv->get_key(drv);
-			if (keystroke != NULL) {
-				report(RPT_INFO, "Driver [%.40s] generated keystroke %.40s", drv->name, keystroke);
-				return keystroke;
-			}
+		for (i = 0; i < drv->num_input_fds; i++) {
+			FD_SET(drv->input_fds[i], &rfds);
+			if (drv->input_fds[i] > maxfd)
+				maxfd = drv->input_fds[i];
+		}
+	}
+
+	/* Nothing to wait for, just sleep */
+	if (maxfd < 0) {
+		if (timeout > 0)
+			usleep(timeout);
+		return 0;
+	}
+
+	tv.tv_sec = timeout / 1000000;
+	tv.tv_usec = timeout % 1000000;
+	if (select(maxfd + 1, &rfds, NULL, NULL, &tv) <= 0)
+		return 0;
+
+	ForAllDrivers(drv) {
+		for (i = 0; i < drv->num_input_fds; i++) {
+			if (FD_ISSET(drv->input_fds[i], &rfds))
+				drv->input_pending = 1;
 		}
+		if (drv->input_pending)
+			pending++;
 	}
-	return NULL;
+	return pending;
 }
 
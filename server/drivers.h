@@ -76,8 +76,14 @@ drivers_backlight(int brightness);
 void
 drivers_output(int state);
 
+int
+drivers_count(void);
+
 const char *
-drivers_get_key(void);
+drivers_get_key(int num);
+
+int
+drivers_wait_input(long timeout);
 
 
 /* Please don't read this list except using the following functions */
@@ -66,6 +66,9 @@ typedef struct CFontz_private_data {
 	unsigned char *framebuf;
 	unsigned char *backingstore;
 
+	/* output collected during a frame and sent on flush */
+	LibSerialBuffer *sb;
+
 	/* definable characters */
 	CGmode ccmode;
 
@@ -238,6 +241,13 @@ CFontz_init(Driver *drvthis)
 	}
 	memset(p->framebuf, ' ', p->width * p->height);
 
+	/* ... and the output buffer used for flushing */
+	p->sb = lib_serbuf_new(p->fd, 3 * p->width * p->height, 0);
+	if (p->sb == NULL) {
+		report(RPT_ERR, "%s: unable to create output buffer", drvthis->name);
+		return -1;
+	}
+
 	// Set display-specific stuff..
 	if (reboot) {
 		report(RPT_INFO, "%s: rebooting LCD...", drvthis->name);
@@ -280,6 +290,9 @@ CFontz_close(Driver *drvthis)
 			free(p->framebuf);
 		p->framebuf = NULL;
 
+		lib_serbuf_free(p->sb);
+		p->sb = NULL;
+
 		free(p);
 	}
 	drvthis->store_private_ptr(drvthis, NULL);
@@ -379,7 +392,7 @@ CFontz_flush(Driver *drvthis)
 				}
 				*ptr++ = c;
 			}
-			write(p->fd, out, (ptr - out));
+			lib_serbuf_write(p->sb, out, (ptr - out));
 		}
 	}
 	else {
@@ -393,9 +406,13 @@ CFontz_flush(Driver *drvthis)
 			/* move cursor to start of (i+1)'th line */
 			CFontz_cursor_goto(drvthis, 1, i+1);
 
-			write(p->fd, p->framebuf + (p->width * i), p->width);
+			lib_serbuf_write(p->sb, p->framebuf + (p->width * i), p->width);
 		}
 	}
+
+	/* send everything collected during this frame at once */
+	lib_serbuf_flush(p->sb);
+	debug(RPT_DEBUG, "%s: flushed %d bytes", drvthis->name, p->sb->frame_bytes);
 }
 
 
@@ -620,7 +637,7 @@ CFontz_cursor_goto(Driver *drvthis, int x, int y)
 		out[1] = (unsigned char) (x - 1);
 	if ((y > 0) && (y <= p->height))
 		out[2] = (unsigned char) (y - 1);
-	write(p->fd, out, 3);
+	lib_serbuf_write(p->sb, out, 3);
 }
 
 
@@ -779,7 +796,7 @@ CFontz_set_char(Driver *drvthis, int n, unsigned char *dat)
 	for (row = 0; row < p->cellheight; row++) {
 		out[2+row] = dat[row] & mask;
 	}
-	write(p->fd, out, 2 + p->cellheight);
+	lib_serbuf_write(p->sb, out, 2 + p->cellheight);
 }
 
 
@@ -947,7 +964,7 @@ CFontz_cursor(Driver *drvthis, int x, int y, int state)
 			stylecmd[0] = CFONTZ_Show_Block_Cursor;
 			break;
 	}
-	write(p->fd, stylecmd, 1);
+	lib_serbuf_write(p->sb, stylecmd, 1);
 
 	/* set cursor position */
 	CFontz_cursor_goto(drvthis, x, y);
@@ -85,7 +85,9 @@
 /* static local functions */
 static void send_packet(int fd, COMMAND_PACKET *out, COMMAND_PACKET *in);
 static int  get_crc(unsigned char *buf, int len, int seed);
-static int  test_packet(int fd, unsigned char response, COMMAND_PACKET *in);
+static void receive_packets(int fd, COMMAND_PACKET *in);
+static void wait_for_answers(int fd, int max_pending, COMMAND_PACKET *in);
+static void dispatch_packet(COMMAND_PACKET *in);
 static int  check_for_packet(int fd, COMMAND_PACKET *in, unsigned char expected_length);
 #ifdef DEBUG
 static void print_packet(COMMAND_PACKET *packet);
@@ -155,6 +157,68 @@ unsigned char GetKeyFromKeyRing(KeyRing *kr)
 /** @} */
 
 
+/** \addtogroup CFA_PacketWindow
+ *
+ * Packet window handling.
+ * Instead of waiting for the answer to each command before sending the
+ * next one, up to packet_window commands may be outstanding. The answers
+ * arrive in the order the commands were sent; an answer acknowledges its
+ * command and all older ones whose answers have been lost.
+ * @{
+ */
+
+/** Expected answer types of commands sent but not yet acknowledged. */
+static unsigned char pending[MAX_PACKET_WINDOW];
+/** Number of entries used in \c pending. */
+static int pending_count = 0;
+/** Max. number of commands in flight. */
+static int packet_window = DEFAULT_PACKET_WINDOW;
+
+/**
+ * Set the number of commands that may be sent without having received
+ * their answers. A size of 1 results in stop-and-wait operation.
+ * Commands still outstanding are forgotten.
+ * \param size  Window size (1 - MAX_PACKET_WINDOW).
+ */
+void set_packet_window(int size)
+{
+	pending_count = 0;
+
+	if (size < 1)
+		size = 1;
+	if (size > MAX_PACKET_WINDOW)
+		size = MAX_PACKET_WINDOW;
+	packet_window = size;
+}
+
+
+/**
+ * Process all packets already received from the given handle without
+ * waiting for more. Keys end up in the key ring.
+ * \param fd  File handle to read from.
+ */
+void poll_packets(int fd)
+{
+	COMMAND_PACKET in;
+
+	receive_packets(fd, &in);
+}
+
+
+/**
+ * Wait until the answers to all commands sent have been received (or
+ * are considered lost).
+ * \param fd  File handle to read from.
+ */
+void flush_packets(int fd)
+{
+	COMMAND_PACKET in;
+
+	wait_for_answers(fd, 0, &in);
+}
+/** @} */
+
+
 
 /**
  * Send message with arguments to the given handle.
@@ -224,24 +288,33 @@ void send_zerobyte_message(int fd, unsigned char msg)
 static void
 send_packet(int fd, COMMAND_PACKET *out, COMMAND_PACKET *in)
 {
-	unsigned char CRC[2];
-
-	write(fd, &out->command, 1);
-	write(fd, &out->data_length, 1);
-	if (out->data_length > 0)
-		write(fd, out->data, out->data_length);
+	unsigned char buf[MAX_DATA_LENGTH + 4];
+	int len = 0;
+
+	buf[len++] = out->command;
+	buf[len++] = out->data_length;
+	if (out->data_length > 0) {
+		memcpy(&buf[len], out->data, out->data_length);
+		len += out->data_length;
+	}
 
-	/* calculate & send the CRC: convert to bytes manually to avoid endianess issues */
+	/* calculate & append the CRC: convert to bytes manually to avoid endianess issues */
 	out->crc = get_crc((unsigned char *) out, out->data_length + 2, 0xFFFF);
-	CRC[0] = out->crc & 0xFF;
-	CRC[1] = (out->crc >> 8) & 0xFF;
-	write(fd, CRC, 2);
+	buf[len++] = out->crc & 0xFF;
+	buf[len++] = (out->crc >> 8) & 0xFF;
+
+	/* make room in the window by waiting for the oldest answer(s) */
+	if (pending_count >= packet_window)
+		wait_for_answers(fd, packet_window - 1, in);
+
+	write(fd, buf, len);
+	pending[pending_count++] = 0x40 | out->command;
 
 	/**** TEST STUFF ****/
 	//print_packet(out);
 
-	/* Every time we send a message, we also check for an incoming one. */
-	test_packet(fd, 0x40 | out->command, in);
+	/* Every time we send a message, we also check for incoming ones. */
+	receive_packets(fd, in);
 }
 
 
@@ -493,54 +566,88 @@ unsigned char PeekByte(ReceiveBuffer *rb)
 
 
 /**
- * Check for a response packet and try to identify it.
- * \param fd        File handle to read from.
- * \param response  Expected response command.
- * \param in        Pointer to COMMAND_PACKET structure to write the response to.
- * \retval 1  Expected response received.
- * \retval 0  Expected response not received.
+ * Read and dispatch all complete packets available from the given handle.
+ * \param fd  File handle to read from.
+ * \param in  Pointer to COMMAND_PACKET structure used as receive buffer.
  *
  * \todo check_for_packet is always called with MAX_DATA_LENGTH. This doesn't
  *       do any harm, but passing that parameter is useless then. Additionally
  *       one complete packet is MAX_DATA_LENGTH + 4 (command, length, CRC).
  */
-static int
-test_packet(int fd, unsigned char response, COMMAND_PACKET *in)
+static void
+receive_packets(int fd, COMMAND_PACKET *in)
+{
+	int is_msg = check_for_packet(fd, in, MAX_DATA_LENGTH);
+
+	while (is_msg != GIVE_UP) {
+		if (is_msg == GOOD_MSG)
+			dispatch_packet(in);
+
+		is_msg = check_for_packet(fd, in, MAX_DATA_LENGTH);
+	}
+}
+
+
+/**
+ * Wait until no more than \c max_pending commands are without answer.
+ * Commands whose answers do not arrive in time are considered lost.
+ * \param fd           File handle to read from.
+ * \param max_pending  Number of commands that may remain unanswered.
+ * \param in           Pointer to COMMAND_PACKET structure used as receive buffer.
+ */
+static void
+wait_for_answers(int fd, int max_pending, COMMAND_PACKET *in)
 {
 #if defined(HAVE_SELECT) && defined(CFONTZ633_WRITE_DELAY) && (CFONTZ633_WRITE_DELAY > 0)
-	int response_received = 0;
 	int loop;
 
-	/* wait for answer packet but forever (LCDs should answer within max. 250ms) */
-	for (loop = 250000/CFONTZ633_WRITE_DELAY; !response_received && loop > 0; loop--) {
-		int is_msg = check_for_packet(fd, in, MAX_DATA_LENGTH);
-
-		while (is_msg != GIVE_UP) {
-			if (is_msg == GOOD_MSG) {
-				/* key activity ? */
-				if (in->command == 0x80)
-					AddKeyToKeyRing(&keyring, in->data[0]);
-				else if (in->command == response)
-					response_received = 1;
-			}
+	/* wait for answer packets but not forever (LCDs should answer within max. 250ms) */
+	for (loop = 250000/CFONTZ633_WRITE_DELAY; (pending_count > max_pending) && loop > 0; loop--)
+		receive_packets(fd, in);
+#else
+	receive_packets(fd, in);
+#endif
 
-			is_msg = check_for_packet(fd, in, MAX_DATA_LENGTH);
-		}
+	/* give up on the oldest commands */
+	if (pending_count > max_pending) {
+		int lost = pending_count - max_pending;
+
+		memmove(pending, pending + lost, max_pending);
+		pending_count = max_pending;
 	}
-	return(response_received);
-#else
-	int is_msg = check_for_packet(fd, in, MAX_DATA_LENGTH);
-	while (is_msg != GIVE_UP) {
-		if (is_msg == GOOD_MSG) {
+}
+
+
+/**
+ * Handle a packet received from the display: keys go to the key ring and
+ * answers acknowledge the matching outstanding command. Other reports (fan
+ * and temperature) are not used and dropped.
+ * \param in  Pointer to the received COMMAND_PACKET.
+ */
+static void
+dispatch_packet(COMMAND_PACKET *in)
+{
+	int i;
+
+	switch (in->command & 0xC0) {
+		case 0x80:	/* report */
 			if (in->command == 0x80)
 				AddKeyToKeyRing(&keyring, in->data[0]);
-		}
-
-		is_msg = check_for_packet(fd, in, MAX_DATA_LENGTH);
+			break;
+		case 0x40:	/* normal answer */
+		case 0xC0:	/* error answer */
+			for (i = 0; i < pending_count; i++) {
+				if ((pending[i] & 0x3F) == (in->command & 0x3F)) {
+					/* answers of older commands have been lost */
+					memmove(pending, pending + i + 1, pending_count - i - 1);
+					pending_count -= i + 1;
+					break;
+				}
+			}
+			break;
+		default:
+			break;
 	}
-
-	return 1;
-#endif
 }
 
 
@@ -108,10 +108,19 @@ typedef struct {
 } COMMAND_PACKET;
 
 
+/* packet window management */
+#define DEFAULT_PACKET_WINDOW	4	/* packets in flight without answer */
+#define MAX_PACKET_WINDOW	8
+
+
 void          EmptyKeyRing(KeyRing *kr);
 int           AddKeyToKeyRing(KeyRing *kr, unsigned char key);
 unsigned char GetKeyFromKeyRing(KeyRing *kr);
 
+void          set_packet_window(int size);
+void          poll_packets(int fd);
+void          flush_packets(int fd);
+
 void          send_bytes_message(int fd, unsigned char msg, int len, unsigned char *data);
 void          send_onebyte_message(int fd, unsigned char msg, unsigned char value);
 void          send_zerobyte_message(int fd, unsigned char msg);
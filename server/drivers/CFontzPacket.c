@@ -233,6 +233,16 @@ CFontzPacket_init (Driver *drvthis)
 	/* Does the display has an old firmware (<= 0.6)? */
 	p->oldfirmware = drvthis->config_get_bool(drvthis->name, "OldFirmware", 0, 0);
 
+	/* How many commands may be sent without waiting for an answer */
+	tmp = drvthis->config_get_int(drvthis->name, "PacketWindow", 0, DEFAULT_PACKET_WINDOW);
+	debug(RPT_INFO, "%s: PacketWindow (in config) is '%d'", __FUNCTION__, tmp);
+	if ((tmp < 1) || (tmp > MAX_PACKET_WINDOW)) {
+		report(RPT_WARNING, "%s: PacketWindow must be between 1 and %d; using default %d",
+			drvthis->name, MAX_PACKET_WINDOW, DEFAULT_PACKET_WINDOW);
+		tmp = DEFAULT_PACKET_WINDOW;
+	}
+	set_packet_window(tmp);
+
 	/* Reboot display? */
 	cf_reboot = drvthis->config_get_bool(drvthis->name, "Reboot", 0, 0);
 
@@ -324,8 +334,10 @@ CFontzPacket_close (Driver *drvthis)
 	PrivateData *p = drvthis->private_data;
 
 	if (p != NULL) {
-		if (p->fd >= 0)
+		if (p->fd >= 0) {
+			flush_packets(p->fd);
 			close(p->fd);
+		}
 
 		if (p->framebuf)
 			free(p->framebuf);
@@ -507,7 +519,12 @@ CFontzPacket_flush (Driver *drvthis)
 MODULE_EXPORT const char *
 CFontzPacket_get_key (Driver *drvthis)
 {
-	unsigned char key = GetKeyFromKeyRing(&keyring);
+	PrivateData *p = drvthis->private_data;
+	unsigned char key;
+
+	/* pick up keys that arrived since the last command was sent */
+	poll_packets(p->fd);
+	key = GetKeyFromKeyRing(&keyring);
 
 	switch (key) {
 		case CFP_KEY_UL_PRESS:
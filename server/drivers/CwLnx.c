@@ -748,38 +748,25 @@ CwLnx_flush(Driver *drvthis)
 {
     PrivateData *p = drvthis->private_data;
 
-    int i, j;
-    int iUpdate = 0, jUpdate = 0;
-    unsigned char *firstUpdate = NULL, *lastUpdate = NULL;
-
-    unsigned char *q = p->framebuf;
-    unsigned char *r = p->backingstore;
+    int i, j, k;
 
     for (i = 0; i < p->height; i++) {
+	unsigned char *q = p->framebuf + (i * p->width);
+	unsigned char *r = p->backingstore + (i * p->width);
+	LibDiffRun runs[LCD_MAX_WIDTH / 2 + 1];
+	int count;
+
+	/* custom characters may have been redefined: always send them */
 	for (j = 0; j < p->width; j++) {
-	    if ((*q == *r) && !((0 < *q) && (*q < 16))) {
-		if (firstUpdate && q - lastUpdate > MOVE_COST) {
-		    Set_Insert(p->fd, iUpdate, jUpdate);
-		    Write_LCD(p->fd, (char *) firstUpdate,
-			  lastUpdate - firstUpdate + 1);
-		    firstUpdate = lastUpdate = NULL;
-		}
-	    } else {
-		lastUpdate = q;
-		if (!firstUpdate) {
-		    firstUpdate = q;
-		    iUpdate = i;
-		    jUpdate = j;
-		}
-	    }
-	    q++;
-	    r++;
+	    if ((0 < q[j]) && (q[j] < 16))
+		r[j] = ~q[j];
+	}
+
+	count = lib_diff_row(q, r, p->width, MOVE_COST, runs);
+	for (k = 0; k < count; k++) {
+	    Set_Insert(p->fd, i, runs[k].x);
+	    Write_LCD(p->fd, (char *) q + runs[k].x, runs[k].len);
 	}
-    }
-    if (firstUpdate) {
-	Set_Insert(p->fd, iUpdate, jUpdate);
-	Write_LCD(p->fd, (char *) firstUpdate,
-		lastUpdate - firstUpdate + 1);
     }
 
     memcpy(p->backingstore, p->framebuf, p->width * p->height);
@@ -571,22 +571,21 @@ IOWarrior_flush(Driver *drvthis)
   /* Update LCD incrementally by comparing with last contents */
   for (y = 0; y < p->height; y++) {
     int offset = y * p->width;
+    LibDiffRun runs[LCD_MAX_WIDTH / 2 + 1];
+    int nruns = lib_diff_row(p->framebuf + offset, p->backingstore + offset,
+			     p->width, IOW_MOVE_COST, runs);
 
-    for (x = 0; x < p->width; x++) {
-      if (p->backingstore[offset+x] != p->framebuf[offset+x]) {
-        /* always flush a full line */
-        unsigned char buffer[LCD_MAX_WIDTH];
+    for (i = 0; i < nruns; i++) {
+      unsigned char buffer[LCD_MAX_WIDTH];
 
-        for (count = 0; count < p->width; count++) {
-          buffer[count] = HD44780_charmap[(unsigned char) p->framebuf[offset+count]];
-          p->backingstore[offset+count] = p->framebuf[offset+count];
-        }
-        iowlcd_set_text(p, 0, y, count, buffer);
-        debug(RPT_DEBUG, "%s: flushed %d chars at (%d,%d)",
-			drvthis->name, count, 0, y);
-
-        x += count-1;
+      for (count = 0; count < runs[i].len; count++) {
+        x = runs[i].x + count;
+        buffer[count] = HD44780_charmap[(unsigned char) p->framebuf[offset+x]];
+        p->backingstore[offset+x] = p->framebuf[offset+x];
       }
+      iowlcd_set_text(p, runs[i].x, y, count, buffer);
+      debug(RPT_DEBUG, "%s: flushed %d chars at (%d,%d)",
+		drvthis->name, count, runs[i].x, y);
     }
   }
 
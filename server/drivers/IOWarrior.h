@@ -53,6 +53,9 @@
 /* IOW56 uses a different USB request size */
 #define IOWLCD_SIZE		((p->productID == 0x1503) ? 64 : 8)
 
+/* A cursor move costs one report, which could have carried this many chars */
+#define IOW_MOVE_COST		(IOWLCD_SIZE - 2)
+
 /* IOWarriors drive HD44780 cmpatible displays that have these cells: */
 #define CELLWIDTH	LCD_DEFAULT_CELLWIDTH
 #define CELLHEIGHT	LCD_DEFAULT_CELLHEIGHT
@@ -117,6 +117,9 @@ typedef struct MtxOrb_private_data {
 	unsigned char *framebuf;
 	unsigned char *backingstore;
 
+	/* output collected during a frame and sent on flush */
+	LibSerialBuffer *sb;
+
 	/* definable characters */
 	CGmode ccmode;
 
@@ -439,6 +442,13 @@ MtxOrb_init (Driver *drvthis)
 	}
 	memset(p->backingstore, ' ', p->width * p->height);
 
+	/* ... and the output buffer used for flushing */
+	p->sb = lib_serbuf_new(p->fd, 2 * p->width * p->height, 0);
+	if (p->sb == NULL) {
+		report(RPT_ERR, "%s: unable to create output buffer", drvthis->name);
+		return -1;
+	}
+
 	/* set initial LCD configuration */
 	MtxOrb_hardware_clear(drvthis);
 	MtxOrb_linewrap(drvthis, DEFAULT_LINEWRAP);
@@ -476,6 +486,9 @@ MtxOrb_close (Driver *drvthis)
 			free(p->backingstore);
 		p->backingstore = NULL;
 
+		lib_serbuf_free(p->sb);
+		p->sb = NULL;
+
 		free(p);
 	}
 	drvthis->store_private_ptr(drvthis, NULL);
@@ -640,7 +653,7 @@ MtxOrb_flush (Driver *drvthis)
 			      __FUNCTION__, i, j, length, length, sp);
 
 			MtxOrb_cursor_goto(drvthis, j+1, i+1);
-			write(p->fd, out, length);
+			lib_serbuf_write(p->sb, out, length);
 			modified++;
 		}
 	}
@@ -648,7 +661,10 @@ MtxOrb_flush (Driver *drvthis)
 	if (modified)
 		memcpy(p->backingstore, p->framebuf, p->width * p->height);
 
-	debug(RPT_DEBUG, "MtxOrb: frame buffer flushed");
+	/* send everything collected during this frame at once */
+	lib_serbuf_flush(p->sb);
+
+	debug(RPT_DEBUG, "MtxOrb: frame buffer flushed (%d bytes)", p->sb->frame_bytes);
 }
 
 
@@ -946,7 +962,7 @@ MtxOrb_cursor_goto(Driver *drvthis, int x, int y)
 		out[2] = (unsigned char) x;
 	if ((y > 0) && (y <= p->height))
 		out[3] = (unsigned char) y;
-	write(p->fd, out, 4);
+	lib_serbuf_write(p->sb, out, 4);
 }
 
 
@@ -1146,7 +1162,7 @@ MtxOrb_hbar (Driver *drvthis, int x, int y, int len, int promille, int options)
 		}
 	}
 
-	lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+	lib_hbar_string(drvthis, x, y, len, promille, options, p->cellwidth, 0, 0xFF);
 }
 
 
@@ -1222,7 +1238,7 @@ MtxOrb_set_char (Driver *drvthis, int n, unsigned char *dat)
 	for (row = 0; row < p->cellheight; row++) {
 		out[row+3] = dat[row] & mask;
 	}
-	write(p->fd, out, 11);
+	lib_serbuf_write(p->sb, out, 11);
 }
 
 
@@ -1421,13 +1437,13 @@ MtxOrb_cursor (Driver *drvthis, int x, int y, int state)
 	/* set cursor state */
 	switch (state) {
 		case CURSOR_OFF:	/* no cursor */
-			write(p->fd, "\xFE" "K", 2);
+			lib_serbuf_write(p->sb, "\xFE" "K", 2);
 			break;
 		case CURSOR_UNDER:	/* underline cursor */
 		case CURSOR_BLOCK:	/* inverting blinking block */
 		case CURSOR_DEFAULT_ON:	/* blinking block */
 		default:
-			write(p->fd, "\xFE" "J", 2);
+			lib_serbuf_write(p->sb, "\xFE" "J", 2);
 			break;
 	}
 
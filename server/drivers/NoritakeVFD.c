@@ -62,6 +62,7 @@
 #include "lcd.h"
 #include "NoritakeVFD.h"
 #include "report.h"
+#include "lcd_lib.h"
 #include "adv_bignum.h"
 
 
@@ -80,6 +81,8 @@ typedef struct NoritakeVFD_private_data {
 	/* framebuffer and buffer for old LCD contents */
 	unsigned char *framebuf;
 	unsigned char *backingstore;
+	/* output collected during a frame and sent on flush */
+	LibSerialBuffer *sb;
 	/* definable characters */
 	CGmode ccmode;
 	int brightness;
@@ -247,6 +250,12 @@ NoritakeVFD_init (Driver *drvthis)
 	}
 	memset(p->backingstore, ' ', p->width * p->height);
 
+	/* ... and the output buffer used for flushing */
+	p->sb = lib_serbuf_new(p->fd, p->width * p->height + 3 * p->height, 0);
+	if (p->sb == NULL) {
+		report(RPT_ERR, "%s: unable to create output buffer", drvthis->name);
+		return -1;
+	}
 
 	/* Set display-specific stuff..*/
 	if (reboot) {
@@ -281,6 +290,8 @@ NoritakeVFD_close (Driver *drvthis)
 
 		if (p->backingstore)
 			free(p->backingstore);
+
+		lib_serbuf_free(p->sb);
 		free(p);
 	}
 	drvthis->store_private_ptr(drvthis, NULL);
@@ -362,9 +373,12 @@ NoritakeVFD_flush (Driver *drvthis)
 			memcpy(p->backingstore+offset, p->framebuf+offset, p->width);
 
 			NoritakeVFD_cursor_goto(drvthis, 1, i+1);
-			write(p->fd, p->framebuf+offset, p->width);
+			lib_serbuf_write(p->sb, p->framebuf+offset, p->width);
 		}
 	}
+
+	/* send everything collected during this frame at once */
+	lib_serbuf_flush(p->sb);
 }
 
 
@@ -706,7 +720,7 @@ NoritakeVFD_set_char (Driver *drvthis, int n, unsigned char *dat)
 		out[3 + i/8] |= ((dat[i/5] >> (4 - i%5)) & 1) << i%8;
 	}
 
-	write(p->fd, out, 8);
+	lib_serbuf_write(p->sb, out, 8);
 }
 
 
@@ -837,7 +851,7 @@ NoritakeVFD_cursor_goto(Driver *drvthis, int x, int y)
 	/* set cursor position */
 	if ((x > 0) && (x <= p->width) && (y > 0) && (y <= p->height))
 		out[2] = (x-1) * p->width + (y-1);
-	write(p->fd, out, 3);
+	lib_serbuf_write(p->sb, out, 3);
 }
 
 
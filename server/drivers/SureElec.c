@@ -81,6 +81,9 @@ typedef struct SureElec_private_data {
 	unsigned char *framebuf;
 	unsigned char *backingstore;
 
+	/* output collected during a frame and sent on flush */
+	LibSerialBuffer *sb;
+
 	/* definable characters */
 	CGmode ccmode;
 
@@ -138,6 +141,7 @@ SureElec_init(Driver * drvthis)
 
 	p->framebuf = NULL;
 	p->backingstore = NULL;
+	p->sb = NULL;
 
 	p->backlight = 0;
 
@@ -252,6 +256,13 @@ SureElec_init(Driver * drvthis)
 	}
 	memset(p->backingstore, '#', p->width * p->height);
 
+	/* Allocate the output buffer used for flushing. */
+	p->sb = lib_serbuf_new(p->fd, p->width * p->height + 4 * p->height, 0);
+	if (p->sb == NULL) {
+		report(RPT_ERR, "%s: unable to create output buffer", drvthis->name);
+		return -1;
+	}
+
 	SureElec_clear(drvthis);
 	SureElec_flush(drvthis);
 
@@ -277,6 +288,7 @@ SureElec_close(Driver * drvthis)
 			free(p->framebuf);
 		if (p->backingstore)
 			free(p->backingstore);
+		lib_serbuf_free(p->sb);
 
 		/* Free our private data */
 		free(p);
@@ -429,14 +441,18 @@ SureElec_flush(Driver * drvthis)
 			 * line on screen
 			 */
 			cmd[3] = i + 1;
-			if (write_(drvthis, cmd, sizeof(cmd)) == -1 ||
-			    write_(drvthis, &(p->framebuf[p->width * i]), p->width) == -1) {
-				return;
-			}
+			lib_serbuf_write(p->sb, cmd, sizeof(cmd));
+			lib_serbuf_write(p->sb, &(p->framebuf[p->width * i]), p->width);
 			modified = 1;
 		}
 	}
 
+	/* Send everything collected during this frame at once */
+	if (lib_serbuf_flush(p->sb) == -1) {
+		report(RPT_ERR, "SureElec: cannot write to port");
+		return;
+	}
+
 	if (modified) {
 		/* If something changed on screen, update the backingstore */
 		memcpy(p->backingstore, p->framebuf, p->width * p->height);
@@ -714,7 +730,7 @@ SureElec_set_char(Driver * drvthis, int n, unsigned char *dat)
 	for (row = 0; row < p->cellheight; row++) {
 		cmd[row + 3] = dat[row] & mask;
 	}
-	write_(drvthis, cmd, sizeof(cmd));
+	lib_serbuf_write(p->sb, cmd, sizeof(cmd));
 }
 
 
@@ -52,6 +52,7 @@ typedef struct bayrad_private_data {
   int cellwidth;
   int cellheight;
   char *framebuf;
+  LibSerialBuffer *sb;
   CGmode ccmode;
 } PrivateData;
 
@@ -90,6 +91,7 @@ bayrad_init(Driver *drvthis)
   p->cellwidth = 5;
   p->cellheight = 8;
   p->framebuf = NULL;
+  p->sb = NULL;
   p->ccmode = standard;
 
 
@@ -160,6 +162,13 @@ bayrad_init(Driver *drvthis)
   }
   memset(p->framebuf, ' ', p->width * p->height);
 
+  p->sb = lib_serbuf_new(p->fd, p->width * p->height + 4, 0);
+  if (p->sb == NULL) {
+    bayrad_close(drvthis);
+    report(RPT_ERR, "%s: Error: unable to create output buffer", drvthis->name);
+    return -1;
+  }
+
   /*** Open the port write-only, then fork off a process that reads chars ?!!? ***/
 
   /* Reset and clear the BayRAD */
@@ -190,6 +199,8 @@ bayrad_close(Driver *drvthis)
     if (p->framebuf != NULL)
       free(p->framebuf);
 
+    lib_serbuf_free(p->sb);
+
     free(p);
   }
   drvthis->store_private_ptr(drvthis, NULL);
@@ -276,10 +287,11 @@ bayrad_flush(Driver *drvthis)
   PrivateData *p = drvthis->private_data;
 
   //debug(RPT_DEBUG, "BayRAD flush");
-  write(p->fd, "\x80\x1e", 2);  //sync, home
-  write(p->fd, p->framebuf, 20);
-  write(p->fd, "\x1e\x0a", 2);  //home, LF
-  write(p->fd, p->framebuf+20, 20);
+  lib_serbuf_write(p->sb, "\x80\x1e", 2);  //sync, home
+  lib_serbuf_write(p->sb, p->framebuf, 20);
+  lib_serbuf_write(p->sb, "\x1e\x0a", 2);  //home, LF
+  lib_serbuf_write(p->sb, p->framebuf+20, 20);
+  lib_serbuf_flush(p->sb);
 }
 
 
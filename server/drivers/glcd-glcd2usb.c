@@ -37,7 +37,6 @@
 typedef struct glcd_glcd2usb_data {
 	usb_dev_handle *device;
 	unsigned char *paged_buffer;	/**< frame buffer in paged format */
-	unsigned char *dirty_buffer;	/**< buffer indicating changed bytes */
 	union {
 		unsigned char bytes[132];
 		/** when reading this buffer can be accessed as structure */
@@ -188,8 +187,6 @@ glcd2usb_close(PrivateData *p)
 			usb_close(ctd->device);
 		if (ctd->paged_buffer != NULL)
 			free(ctd->paged_buffer);
-		if (ctd->dirty_buffer != NULL)
-			free(ctd->dirty_buffer);
 		free(ctd);
 	}
 }
@@ -225,79 +222,37 @@ void
 glcd2usb_blit(PrivateData *p)
 {
 	CT_glcd2usb_data *ctd = (CT_glcd2usb_data *) p->ct_data;
-	int r;
-	int i, j;
+	int start, end, pos, len;
 	int err;
-	int pos;
 
 	p->glcd_functions->drv_debug(RPT_DEBUG, "glcd2usb_blit: starting");
 
-	/* Reset the dirty buffer */
-	memset(ctd->dirty_buffer, 0x00, p->framebuf.size);
-
-	/*
-	 * Step 1: Compare the content of the secondary buffer with the frame
-	 * buffer and copy the differences. For each different byte, set the
-	 * flag in the dirty buffer.
-	 */
-	for (pos = 0; pos < p->framebuf.size; pos++) {
-		if (ctd->paged_buffer[pos] != p->framebuf.data[pos]) {
-			ctd->paged_buffer[pos] = p->framebuf.data[pos];
-			ctd->dirty_buffer[pos] = 1;
-		}
-	}
-
 	/*
-	 * Step 2: Short gaps of unchanged bytes in fact increase the
-	 * communication overhead. So we eliminate them here.
+	 * Find ranges of bytes that differ from the secondary buffer. Short
+	 * gaps of unchanged bytes in fact increase the communication
+	 * overhead, so ranges separated by up to 4 clean bytes are merged.
 	 */
-	for (j = -1, i = 0; i < p->framebuf.size; i++) {
-		if (ctd->dirty_buffer[i] && j >= 0 && i - j <= 4) {
-			/* found a clean gap <= 4 bytes: mark it dirty */
-			for (r = j; r < i; r++)
-				ctd->dirty_buffer[r] = 1;
-		}
-
-		/* if this is dirty, drop the saved position */
-		if (ctd->dirty_buffer[i])
-			j = -1;
-
-		/* save position of this clean entry if no position saved yet */
-		if (!ctd->dirty_buffer[i] && j < 0)
-			j = i;
-	}
-
-	/* Step 3: Send the changes. */
-	ctd->tx_buffer.bytes[0] = 0;
-	for (i = 0; i < p->framebuf.size; i++) {
-		if (ctd->dirty_buffer[i]) {
-			/* Start a new packet */
-			if (!ctd->tx_buffer.bytes[0]) {
-				ctd->tx_buffer.bytes[0] = GLCD2USB_RID_WRITE;
-				ctd->tx_buffer.bytes[1] = i % 256;
-				ctd->tx_buffer.bytes[2] = i / 256;
-				ctd->tx_buffer.bytes[3] = 0;	/* length */
-			}
-			/* Append the dirty byte and increase size */
-			ctd->tx_buffer.bytes[4 + ctd->tx_buffer.bytes[3]++] = ctd->paged_buffer[i];
-		}
-
-		/*
-		 * Send the data if we hit a clean byte, are at the end of
-		 * the frame or reached the maximum payload for a write
-		 * request.
-		 */
-		if (!ctd->dirty_buffer[i] || i == p->framebuf.size - 1 || ctd->tx_buffer.bytes[3] == 128) {
-			/* Only write if there IS something to be written */
-			if (ctd->tx_buffer.bytes[0] == GLCD2USB_RID_WRITE && ctd->tx_buffer.bytes[3] > 0) {
-				err = usbSetReport(ctd->device, USB_HID_REPORT_TYPE_FEATURE,
-						   ctd->tx_buffer.bytes, ctd->tx_buffer.bytes[3] + 4);
-				if (err)
-					p->glcd_functions->drv_report(RPT_ERR, "glcd2usb_blit: error in transfer");
-				/* Start a new packet the next time */
-				ctd->tx_buffer.bytes[0] = 0;
-			}
+	pos = 0;
+	while ((start = fb_diff_span(p->framebuf.data, ctd->paged_buffer, pos,
+				     p->framebuf.size, 4, &end)) >= 0) {
+		/* Send the range in packets of at most 128 bytes */
+		for (pos = start; pos < end; pos += len) {
+			len = end - pos;
+			if (len > 128)
+				len = 128;
+
+			ctd->tx_buffer.bytes[0] = GLCD2USB_RID_WRITE;
+			ctd->tx_buffer.bytes[1] = pos % 256;
+			ctd->tx_buffer.bytes[2] = pos / 256;
+			ctd->tx_buffer.bytes[3] = len;
+			memcpy(ctd->tx_buffer.bytes + 4, p->framebuf.data + pos, len);
+
+			err = usbSetReport(ctd->device, USB_HID_REPORT_TYPE_FEATURE,
+					   ctd->tx_buffer.bytes, len + 4);
+			if (err)
+				p->glcd_functions->drv_report(RPT_ERR, "glcd2usb_blit: error in transfer");
 		}
+		memcpy(ctd->paged_buffer + start, p->framebuf.data + start, end - start);
 	}
 }
 
@@ -473,12 +428,6 @@ found_dev:
 	}
 	memset(ctd->paged_buffer, 0x55, p->framebuf.size);
 
-	ctd->dirty_buffer = malloc(p->framebuf.size);
-	if (ctd->dirty_buffer == NULL) {
-		report(RPT_ERR, "%s/glcd2usb: cannot allocate memory", drvthis->name);
-		goto err_out;
-	}
-
 	/* Allocate the display (turn off the 'whirl') */
 	ctd->tx_buffer.bytes[0] = GLCD2USB_RID_SET_ALLOC;
 	ctd->tx_buffer.bytes[1] = 1;
@@ -8,6 +8,8 @@
 #ifndef GLCD_LOW_H
 #define GLCD_LOW_H
 
+#include <string.h>
+
 #define GLCD_DEFAULT_SIZE	"128x64"
 #define GLCD_DEFAULT_CELLWIDTH	6
 #define GLCD_DEFAULT_CELLHEIGHT	8
@@ -158,4 +160,79 @@ fb_get_pixel(struct glcd_framebuf *fb, int x, int y)
 	else
 		return FB_WHITE;
 }
+
+
+/**
+ * Find the first byte at or after \c start where two buffers differ.
+ * Equal parts are skipped a machine word at a time.
+ *
+ * \param a      First buffer (e.g. framebuffer data)
+ * \param b      Second buffer (e.g. backing store)
+ * \param start  Offset to start at
+ * \param len    Number of bytes to compare up to
+ * \return  Offset of the first differing byte, \c len if there is none
+ */
+static inline int
+fb_diff_first(const unsigned char *a, const unsigned char *b, int start, int len)
+{
+	int pos = start;
+
+	while (pos + (int) sizeof(unsigned long) <= len) {
+		unsigned long wa, wb;
+
+		/* memcpy() compiles to plain loads but does not require alignment */
+		memcpy(&wa, a + pos, sizeof(wa));
+		memcpy(&wb, b + pos, sizeof(wb));
+		if (wa != wb)
+			break;
+		pos += sizeof(unsigned long);
+	}
+	while ((pos < len) && (a[pos] == b[pos]))
+		pos++;
+
+	return pos;
+}
+
+
+/**
+ * Find the next range of differing bytes in two buffers. Differences
+ * separated by at most \c maxgap equal bytes are merged into one range, as
+ * starting a new transfer usually costs more than sending a few unchanged
+ * bytes.
+ *
+ * \param a       First buffer (e.g. framebuffer data)
+ * \param b       Second buffer (e.g. backing store)
+ * \param start   Offset to start at
+ * \param len     Length of the buffers
+ * \param maxgap  Maximum number of equal bytes within a range
+ * \param end     Returns offset after the last differing byte of the range
+ * \return  Offset of the first differing byte of the range, -1 if none
+ */
+static inline int
+fb_diff_span(const unsigned char *a, const unsigned char *b, int start, int len,
+	     int maxgap, int *end)
+{
+	int first, last, next;
+
+	first = fb_diff_first(a, b, start, len);
+	if (first >= len)
+		return -1;
+
+	last = first;
+	while (last + 1 < len) {
+		/* Only look as far as a difference would still be merged */
+		int limit = last + 2 + maxgap;
+
+		if (limit > len)
+			limit = len;
+		next = fb_diff_first(a, b, last + 1, limit);
+		if (next >= limit)
+			break;
+		last = next;
+	}
+
+	*end = last + 1;
+	return first;
+}
+
 #endif
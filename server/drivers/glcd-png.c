@@ -1,6 +1,8 @@
 /** \file server/drivers/glcd-png.c
  * This driver writes the framebuffer content to PNG images as
- * /tmp/lcdproc######.png.
+ * /tmp/lcdproc######.png. Alternatively the images are written to a ring of
+ * files or all frames are written as a stream of PBM images to a single file
+ * or FIFO.
  */
 
 /*-
@@ -28,6 +30,19 @@
 #include "report.h"
 #include "glcd-low.h"
 
+#define PNG_FILE_FORMAT		"/tmp/lcdproc%06d.png"
+#define PNG_DEF_MODE		"files"
+#define PNG_DEF_RINGSIZE	8
+#define PNG_MAX_RINGSIZE	1000
+#define PNG_DEF_STREAM		"/tmp/lcdproc.pbm"
+
+/** Output modes of the PNG connection type */
+enum png_mode {
+	PNG_MODE_FILES,		/**< write a new numbered PNG for each frame */
+	PNG_MODE_RING,		/**< reuse a fixed number of PNG files */
+	PNG_MODE_STREAM		/**< write PBM frames to a single file / FIFO */
+};
+
 /* Prototypes */
 void glcd_png_blit(PrivateData *p);
 void glcd_png_close(PrivateData *p);
@@ -35,6 +50,17 @@ void glcd_png_close(PrivateData *p);
 /** Private data for the PNG connection type */
 typedef struct glcd_png_data {
 	unsigned char *backingstore;	/**< backing buffer */
+	enum png_mode mode;		/**< output mode */
+	int num;			/**< number of the next file */
+	int ringsize;			/**< number of files in ring mode */
+
+	char *stream_path;		/**< file or FIFO for stream mode */
+	int stream_fd;			/**< stream file descriptor, -1 if closed */
+	int stream_is_file;		/**< stream is a regular file, not a FIFO */
+	unsigned char *frame;		/**< PBM header and image to send */
+	int header_len;			/**< length of the PBM header */
+	int frame_len;			/**< length of the frame in \c frame */
+	int frame_sent;			/**< bytes of the frame written so far */
 } CT_png_data;
 
 /**
@@ -48,6 +74,7 @@ glcd_png_init(Driver *drvthis)
 {
 	PrivateData *p = (PrivateData *)drvthis->private_data;
 	CT_png_data *ct_data;
+	const char *s;
 
 	report(RPT_INFO, "GLCD/png: intializing");
 
@@ -69,6 +96,49 @@ glcd_png_init(Driver *drvthis)
 		return -1;
 	}
 	memset(ct_data->backingstore, 0x00, p->framebuf.size);
+	ct_data->stream_fd = -1;
+
+	/* Get output mode */
+	s = drvthis->config_get_string(drvthis->name, "png_Mode", 0, PNG_DEF_MODE);
+	if (strcmp(s, "files") == 0)
+		ct_data->mode = PNG_MODE_FILES;
+	else if (strcmp(s, "ring") == 0)
+		ct_data->mode = PNG_MODE_RING;
+	else if (strcmp(s, "stream") == 0)
+		ct_data->mode = PNG_MODE_STREAM;
+	else {
+		report(RPT_WARNING, "GLCD/png: unknown png_Mode %s; using default %s",
+		       s, PNG_DEF_MODE);
+		ct_data->mode = PNG_MODE_FILES;
+	}
+
+	/* Get number of files in ring mode */
+	ct_data->ringsize = drvthis->config_get_int(drvthis->name, "png_RingSize", 0,
+						    PNG_DEF_RINGSIZE);
+	if ((ct_data->ringsize < 1) || (ct_data->ringsize > PNG_MAX_RINGSIZE)) {
+		report(RPT_WARNING, "GLCD/png: png_RingSize must be between 1 and %d; using default %d",
+		       PNG_MAX_RINGSIZE, PNG_DEF_RINGSIZE);
+		ct_data->ringsize = PNG_DEF_RINGSIZE;
+	}
+
+	if (ct_data->mode == PNG_MODE_STREAM) {
+		/* The stream is a sequence of raw PBM (P4) images. */
+		if (p->framebuf.layout != FB_TYPE_LINEAR) {
+			report(RPT_ERR, "GLCD/png: stream mode requires linear framebuffer");
+			return -1;
+		}
+
+		s = drvthis->config_get_string(drvthis->name, "png_Stream", 0, PNG_DEF_STREAM);
+		ct_data->stream_path = strdup(s);
+		ct_data->frame = malloc(32 + p->framebuf.size);
+		if ((ct_data->stream_path == NULL) || (ct_data->frame == NULL)) {
+			report(RPT_ERR, "GLCD/png: unable to allocate stream buffer");
+			return -1;
+		}
+		ct_data->header_len = snprintf((char *) ct_data->frame, 32, "P4\n%d %d\n",
+					       p->framebuf.px_width, p->framebuf.px_height);
+		report(RPT_INFO, "GLCD/png: writing PBM stream to %s", ct_data->stream_path);
+	}
 
 	debug(RPT_DEBUG, "GLCD/png: init() done");
 
@@ -76,53 +146,49 @@ glcd_png_init(Driver *drvthis)
 }
 
 /**
- * API: Write the framebuffer to the display
- * \param p  Pointer to glcd driver's private date structure.
+ * Encode the framebuffer as PNG image.
+ * \param p   Pointer to glcd driver's private date structure.
+ * \param fp  File to write the image to.
+ * \retval 0   Success.
+ * \retval <0  Error.
  */
-void
-glcd_png_blit(PrivateData *p)
+static int
+glcd_png_write(PrivateData *p, FILE *fp)
 {
-	CT_png_data *ct_data = (CT_png_data *) p->ct_data;
-	char filename[256];
-	static int num = 0;
 	int row;
-	FILE *fp;
 	png_structp png_ptr;
 	png_infop info_ptr;
 	png_bytep row_pointer;
 
-	/* Check if framebufer has changed. If not there's nothing to do */
-	if (memcmp(p->framebuf.data, ct_data->backingstore, p->framebuf.size) == 0)
-		return;
-
-	snprintf(filename, sizeof(filename), "/tmp/lcdproc%06d.png", num++);
-	fp = fopen(filename, "wb");
-	if (!fp) {
-		p->glcd_functions->drv_debug(RPT_ERR, "File %s could not be opened for writing", filename);
-		return;
-	}
-
 	/* initialize stuff */
 	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 	if (!png_ptr) {
 		p->glcd_functions->drv_debug(RPT_ERR, "png_create_write_struct failed");
-		fclose(fp);
-		return;
+		return -1;
 	}
 
 	info_ptr = png_create_info_struct(png_ptr);
 	if (!info_ptr) {
 		p->glcd_functions->drv_debug(RPT_ERR, "png_create_info_struct failed");
 		png_destroy_write_struct(&png_ptr, (png_infopp) NULL);
-		fclose(fp);
-		return;
+		return -1;
 	}
 
-	if (setjmp(png_jmpbuf(png_ptr)))
-		goto err_out;
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		p->glcd_functions->drv_debug(RPT_ERR, "Error writing PNG image");
+		png_destroy_write_struct(&png_ptr, &info_ptr);
+		return -1;
+	}
 
 	png_init_io(png_ptr, fp);
 
+	/*
+	 * Row filters do not help with 1 bit images and are the most costly
+	 * part of encoding. Prefer speed over size.
+	 */
+	png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+	png_set_compression_level(png_ptr, 1);
+
 	png_set_IHDR(png_ptr, info_ptr, p->framebuf.px_width, p->framebuf.px_height,
 		     1, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
 		     PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
@@ -138,21 +204,171 @@ glcd_png_blit(PrivateData *p)
 	}
 
 	png_write_end(png_ptr, NULL);
-	fclose(fp);
-	fp = NULL;
 	png_destroy_write_struct(&png_ptr, &info_ptr);
 
+	return 0;
+}
+
+/**
+ * Write the framebuffer to a PNG file. In ring mode the image is written to
+ * a temporary file first and renamed, so readers never see partial images.
+ * \param p  Pointer to glcd driver's private date structure.
+ * \retval 0   Success.
+ * \retval <0  Error.
+ */
+static int
+glcd_png_write_file(PrivateData *p)
+{
+	CT_png_data *ct_data = (CT_png_data *) p->ct_data;
+	char filename[256];
+	char tmpname[260];
+	char *name;
+	FILE *fp;
+	int ret;
+
+	snprintf(filename, sizeof(filename), PNG_FILE_FORMAT, ct_data->num);
+	if (ct_data->mode == PNG_MODE_RING) {
+		snprintf(tmpname, sizeof(tmpname), "%s.tmp", filename);
+		name = tmpname;
+	}
+	else {
+		name = filename;
+	}
+
+	fp = fopen(name, "wb");
+	if (!fp) {
+		p->glcd_functions->drv_debug(RPT_ERR, "File %s could not be opened for writing", name);
+		return -1;
+	}
+	ret = glcd_png_write(p, fp);
+	if (fclose(fp) != 0)
+		ret = -1;
+
+	if ((ret == 0) && (name == tmpname) && (rename(tmpname, filename) < 0)) {
+		p->glcd_functions->drv_debug(RPT_ERR, "Renaming %s failed: %s",
+					     tmpname, strerror(errno));
+		ret = -1;
+	}
+	if (ret < 0) {
+		unlink(name);
+		return ret;
+	}
+
+	ct_data->num++;
+	if ((ct_data->mode == PNG_MODE_RING) && (ct_data->num >= ct_data->ringsize))
+		ct_data->num = 0;
+
+	return 0;
+}
+
+/**
+ * Continue writing the current frame to the stream.
+ * \param p  Pointer to glcd driver's private date structure.
+ * \retval 0   Frame completely written.
+ * \retval 1   Stream is full, rest of the frame is kept for later.
+ * \retval <0  Error, the stream has been closed.
+ */
+static int
+glcd_png_stream_send(PrivateData *p)
+{
+	CT_png_data *ct_data = (CT_png_data *) p->ct_data;
+
+	while (ct_data->frame_sent < ct_data->frame_len) {
+		ssize_t len;
+
+		/* A regular file always holds just the latest frame */
+		if (ct_data->stream_is_file)
+			len = pwrite(ct_data->stream_fd, ct_data->frame + ct_data->frame_sent,
+				     ct_data->frame_len - ct_data->frame_sent, ct_data->frame_sent);
+		else
+			len = write(ct_data->stream_fd, ct_data->frame + ct_data->frame_sent,
+				    ct_data->frame_len - ct_data->frame_sent);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 1;
+
+			/* Reader went away (EPIPE) or other error: reopen later */
+			p->glcd_functions->drv_debug(RPT_INFO, "Closing stream %s: %s",
+						     ct_data->stream_path, strerror(errno));
+			close(ct_data->stream_fd);
+			ct_data->stream_fd = -1;
+			ct_data->frame_len = 0;
+			ct_data->frame_sent = 0;
+			return -1;
+		}
+		ct_data->frame_sent += len;
+	}
+	return 0;
+}
+
+/**
+ * Write the framebuffer as PBM image to the stream. The stream is opened
+ * non-blocking: if it is a FIFO without reader it is retried on the next
+ * call, if the reader is slow the current frame is finished first and newer
+ * frames are dropped meanwhile. A new reader gets the current frame at once.
+ * A regular file is overwritten with each frame instead of growing.
+ * \param p  Pointer to glcd driver's private date structure.
+ */
+static void
+glcd_png_stream(PrivateData *p)
+{
+	CT_png_data *ct_data = (CT_png_data *) p->ct_data;
+	struct stat st;
+	int changed;
+
+	changed = memcmp(p->framebuf.data, ct_data->backingstore, p->framebuf.size);
+
+	if (ct_data->stream_fd < 0) {
+		ct_data->stream_fd = open(ct_data->stream_path,
+					  O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, 0644);
+		if (ct_data->stream_fd < 0) {
+			/* ENXIO: FIFO has no reader yet */
+			if (errno != ENXIO)
+				p->glcd_functions->drv_debug(RPT_ERR, "Stream %s could not be opened: %s",
+							     ct_data->stream_path, strerror(errno));
+			return;
+		}
+		ct_data->stream_is_file = ((fstat(ct_data->stream_fd, &st) == 0) && S_ISREG(st.st_mode));
+		changed = 1;
+	}
+
+	/* Finish the previous frame before starting a new one */
+	if (glcd_png_stream_send(p) != 0)
+		return;
+
+	if (!changed)
+		return;
+
+	memcpy(ct_data->frame + ct_data->header_len, p->framebuf.data, p->framebuf.size);
+	ct_data->frame_len = ct_data->header_len + p->framebuf.size;
+	ct_data->frame_sent = 0;
 	memcpy(ct_data->backingstore, p->framebuf.data, p->framebuf.size);
 
-	return;
+	glcd_png_stream_send(p);
+}
 
-err_out:
-	p->glcd_functions->drv_debug(RPT_ERR, "Error writing PNG image");
-	if (fp != NULL)
-		fclose(fp);
-	if (png_ptr != NULL)
-		png_destroy_write_struct(&png_ptr, &info_ptr);
-	return;
+/**
+ * API: Write the framebuffer to the display
+ * \param p  Pointer to glcd driver's private date structure.
+ */
+void
+glcd_png_blit(PrivateData *p)
+{
+	CT_png_data *ct_data = (CT_png_data *) p->ct_data;
+
+	if (ct_data->mode == PNG_MODE_STREAM) {
+		glcd_png_stream(p);
+		return;
+	}
+
+	/* Check if framebufer has changed. If not there's nothing to do */
+	if (memcmp(p->framebuf.data, ct_data->backingstore, p->framebuf.size) == 0)
+		return;
+
+	if (glcd_png_write_file(p) == 0)
+		memcpy(ct_data->backingstore, p->framebuf.data, p->framebuf.size);
 }
 
 /**
@@ -167,6 +383,12 @@ glcd_png_close(PrivateData *p)
 
 		if (ct_data->backingstore != NULL)
 			free(ct_data->backingstore);
+		if (ct_data->stream_fd >= 0)
+			close(ct_data->stream_fd);
+		if (ct_data->stream_path != NULL)
+			free(ct_data->stream_path);
+		if (ct_data->frame != NULL)
+			free(ct_data->frame);
 
 		free(p->ct_data);
 		p->ct_data = NULL;
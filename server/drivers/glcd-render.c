@@ -17,6 +17,7 @@
 #endif
 
 #include <string.h>
+#include <stdlib.h>
 
 #ifdef HAVE_FT2
 #include <ft2build.h>
@@ -31,18 +32,378 @@
 #include "sed1520fm.h"
 #include "shared/defines.h"
 
+/**
+ * A 1bpp glyph mask. In a linear framebuffer layout data holds the rows of
+ * the glyph, leftmost pixel in the MSB. In a vertically paged layout it holds
+ * the columns, topmost pixel in the LSB.
+ */
+typedef struct glcd_glyph {
+	int width;		/**< width in pixels */
+	int height;		/**< height in pixels */
+	int pitch;		/**< bytes per row (linear) or column (vpaged) */
+	const unsigned char *data;	/**< mask data */
+} GlyphMask;
+
+/** Width of the glyphs from the built-in 5x8 font including spacing */
+#define GLCD_FONT_CELLWIDTH	(GLCD_FONT_WIDTH + 1)
+/** Bytes per glyph of the built-in 5x8 font in either layout */
+#define GLCD_FONT_BYTES		GLCD_FONT_HEIGHT
+/** Bytes per bignum glyph (max. 16 pixels wide, 24 pixels high) */
+#define GLCD_BIGNUM_BYTES	(16 * 3)
+
 #ifdef HAVE_FT2
-/** Configuration for the Freetype renderer */
+/** Default size limit of the Freetype glyph cache in kilobytes */
+#define GLCD_DEFAULT_GLYPH_CACHE	64
+/** Number of hash buckets of the glyph cache */
+#define GLYPH_CACHE_BUCKETS	256
+
+/**
+ * A glyph rendered by Freetype, stored in the framebuffer's layout. Entries
+ * are found by hashing (codepoint, yscale, xscale) and kept in a list
+ * ordered by last use for LRU eviction.
+ */
+typedef struct glyph_cache_entry {
+	int c;				/**< codepoint */
+	int yscale;			/**< vertical scale */
+	int xscale;			/**< horizontal scale */
+	int dx;				/**< offset from left of the cell */
+	int dy;				/**< offset from bottom of the cell */
+	int size;			/**< memory used by this entry */
+	GlyphMask mask;			/**< the glyph, data follows the entry */
+	struct glyph_cache_entry *hnext;	/**< next entry in hash bucket */
+	struct glyph_cache_entry *prev;		/**< more recently used entry */
+	struct glyph_cache_entry *next;		/**< less recently used entry */
+} GlyphCacheEntry;
+#endif
+
+/** Configuration and state of the renderer */
 typedef struct glcd_render_data {
+	/** Copy a glyph mask into the framebuffer, replacing its pixels */
+	void (*blit) (struct glcd_framebuf *fb, int x, int y, const GlyphMask *g);
+	/** Clear a rectangle of the framebuffer */
+	void (*clear) (struct glcd_framebuf *fb, int x, int y, int width, int height);
+	/** built-in 5x8 font in the framebuffer's layout */
+	unsigned char font[256][GLCD_FONT_BYTES];
+	/** bignum font in the framebuffer's layout */
+	unsigned char bignum[11][GLCD_BIGNUM_BYTES];
+	GlyphMask bignum_glyph[11];	/**< bignum glyph descriptions */
+#ifdef HAVE_FT2
 	FT_Library ft_library;		/**< freetype library handle */
 	FT_Face ft_normal_font;		/**< handle for the normal font */
 	char ft_has_icons;		/**< flag is the font has icons */
+	int ft_font_size;		/**< pixel size currently set */
+	GlyphCacheEntry *cache[GLYPH_CACHE_BUCKETS];	/**< glyph cache */
+	GlyphCacheEntry *cache_head;	/**< most recently used glyph */
+	GlyphCacheEntry *cache_tail;	/**< least recently used glyph */
+	long cache_limit;		/**< max. memory used by the cache */
+	long cache_used;		/**< memory currently used by the cache */
+	long cache_hits;		/**< statistics: glyphs found in cache */
+	long cache_misses;		/**< statistics: glyphs rendered */
+#endif
 } RenderConfig;
 
+#ifdef HAVE_FT2
 static int icon2unicode(int icon);
+static void glyph_cache_flush(RenderConfig *rconf);
 #endif
 
 
+/*
+ * Glyph blitting. Instead of plotting every pixel with fb_draw_pixel() the
+ * functions below assemble whole framebuffer bytes from the glyph mask and
+ * merge them using a mask for the pixels covered by the glyph. The variants
+ * for linear and vertically paged framebuffers are selected once by
+ * glcd_render_init().
+ */
+
+/**
+ * Get 8 bits from a MSB-first bit stream of len bytes starting at bit
+ * offset off. Bits outside the stream are returned as 0.
+ */
+static inline unsigned char
+bits_msb(const unsigned char *src, int len, int off)
+{
+	int i;
+	unsigned int v;
+
+	if (off < 0)
+		return src[0] >> -off;
+
+	i = off >> 3;
+	v = (i < len) ? src[i] << 8 : 0;
+	if (i + 1 < len)
+		v |= src[i + 1];
+	return (v << (off & 7)) >> 8;
+}
+
+
+/**
+ * Get 8 bits from a LSB-first bit stream of len bytes starting at bit
+ * offset off. Bits outside the stream are returned as 0.
+ */
+static inline unsigned char
+bits_lsb(const unsigned char *src, int len, int off)
+{
+	int i;
+	unsigned int v;
+
+	if (off < 0)
+		return src[0] << -off;
+
+	i = off >> 3;
+	v = (i < len) ? src[i] : 0;
+	if (i + 1 < len)
+		v |= src[i + 1] << 8;
+	return v >> (off & 7);
+}
+
+
+/**
+ * Copy a glyph mask (rows, MSB left) into a linear framebuffer.
+ *
+ * \param fb  Pointer to framebuffer
+ * \param x   X-position of the glyph's left column (may be negative)
+ * \param y   Y-position of the glyph's top row (may be negative)
+ * \param g   Glyph mask
+ */
+static void
+fb_blit_linear(struct glcd_framebuf *fb, int x, int y, const GlyphMask *g)
+{
+	int x0 = max(x, 0);
+	int x1 = min(x + g->width, fb->px_width);
+	int y0 = max(y, 0);
+	int y1 = min(y + g->height, fb->px_height);
+	int bx, py;
+
+	for (py = y0; py < y1; py++) {
+		const unsigned char *src = g->data + (py - y) * g->pitch;
+		unsigned char *dst = fb->data + py * fb->bytesPerLine;
+
+		for (bx = x0 & ~7; bx < x1; bx += 8) {
+			unsigned char mask = 0xFF;
+
+			if (bx < x0)
+				mask &= 0xFF >> (x0 - bx);
+			if (bx + 8 > x1)
+				mask &= 0xFF << (bx + 8 - x1);
+			dst[bx >> 3] = (dst[bx >> 3] & ~mask) | (bits_msb(src, g->pitch, bx - x) & mask);
+		}
+	}
+}
+
+
+/**
+ * Copy a glyph mask (columns, LSB top) into a vertically paged framebuffer.
+ *
+ * \param fb  Pointer to framebuffer
+ * \param x   X-position of the glyph's left column (may be negative)
+ * \param y   Y-position of the glyph's top row (may be negative)
+ * \param g   Glyph mask
+ */
+static void
+fb_blit_vpaged(struct glcd_framebuf *fb, int x, int y, const GlyphMask *g)
+{
+	int x0 = max(x, 0);
+	int x1 = min(x + g->width, fb->px_width);
+	int y0 = max(y, 0);
+	int y1 = min(y + g->height, fb->px_height);
+	int by, px;
+
+	for (by = y0 & ~7; by < y1; by += 8) {
+		unsigned char *dst = fb->data + (by / 8) * fb->px_width;
+		unsigned char mask = 0xFF;
+
+		if (by < y0)
+			mask &= 0xFF << (y0 - by);
+		if (by + 8 > y1)
+			mask &= 0xFF >> (by + 8 - y1);
+
+		for (px = x0; px < x1; px++) {
+			const unsigned char *src = g->data + (px - x) * g->pitch;
+
+			dst[px] = (dst[px] & ~mask) | (bits_lsb(src, g->pitch, by - y) & mask);
+		}
+	}
+}
+
+
+/**
+ * Clear a rectangle of a linear framebuffer.
+ *
+ * \param fb      Pointer to framebuffer
+ * \param x       X-position of the left column
+ * \param y       Y-position of the top row
+ * \param width   Width in pixels
+ * \param height  Height in pixels
+ */
+static void
+fb_clear_linear(struct glcd_framebuf *fb, int x, int y, int width, int height)
+{
+	int x0 = max(x, 0);
+	int x1 = min(x + width, fb->px_width);
+	int y0 = max(y, 0);
+	int y1 = min(y + height, fb->px_height);
+	unsigned char lmask, rmask;
+	int b0, b1, py;
+
+	if ((x0 >= x1) || (y0 >= y1))
+		return;
+
+	b0 = x0 >> 3;
+	b1 = (x1 - 1) >> 3;
+	lmask = 0xFF >> (x0 & 7);
+	rmask = 0xFF << (7 - ((x1 - 1) & 7));
+	if (b0 == b1)
+		lmask &= rmask;
+
+	for (py = y0; py < y1; py++) {
+		unsigned char *dst = fb->data + py * fb->bytesPerLine;
+
+		dst[b0] &= ~lmask;
+		if (b1 > b0) {
+			memset(dst + b0 + 1, 0, b1 - b0 - 1);
+			dst[b1] &= ~rmask;
+		}
+	}
+}
+
+
+/**
+ * Clear a rectangle of a vertically paged framebuffer.
+ *
+ * \param fb      Pointer to framebuffer
+ * \param x       X-position of the left column
+ * \param y       Y-position of the top row
+ * \param width   Width in pixels
+ * \param height  Height in pixels
+ */
+static void
+fb_clear_vpaged(struct glcd_framebuf *fb, int x, int y, int width, int height)
+{
+	int x0 = max(x, 0);
+	int x1 = min(x + width, fb->px_width);
+	int y0 = max(y, 0);
+	int y1 = min(y + height, fb->px_height);
+	int by, px;
+
+	if (x0 >= x1)
+		return;
+
+	for (by = y0 & ~7; by < y1; by += 8) {
+		unsigned char *dst = fb->data + (by / 8) * fb->px_width;
+		unsigned char mask = 0xFF;
+
+		if (by < y0)
+			mask &= 0xFF << (y0 - by);
+		if (by + 8 > y1)
+			mask &= 0xFF >> (by + 8 - y1);
+
+		if (mask == 0xFF)
+			memset(dst + x0, 0, x1 - x0);
+		else
+			for (px = x0; px < x1; px++)
+				dst[px] &= ~mask;
+	}
+}
+
+
+/**
+ * Convert a glyph given as rows (MSB left) to columns (LSB top).
+ *
+ * \param dst    Destination buffer, (height + 7) / 8 * width bytes
+ * \param src    Source rows
+ * \param pitch  Bytes per source row
+ * \param width  Glyph width in pixels
+ * \param height Glyph height in pixels
+ */
+static void
+glyph_rows_to_columns(unsigned char *dst, const unsigned char *src, int pitch, int width, int height)
+{
+	int dpitch = (height + 7) / 8;
+	int col, row;
+
+	memset(dst, 0, dpitch * width);
+	for (row = 0; row < height; row++, src += pitch) {
+		for (col = 0; col < width; col++) {
+			if (src[col / 8] & (0x80 >> (col % 8)))
+				dst[col * dpitch + row / 8] |= 1 << (row % 8);
+		}
+	}
+}
+
+
+/**
+ * Convert a glyph given as columns (LSB top) to rows (MSB left).
+ *
+ * \param dst    Destination buffer, (width + 7) / 8 * height bytes
+ * \param src    Source columns
+ * \param pitch  Bytes per source column
+ * \param width  Glyph width in pixels
+ * \param height Glyph height in pixels
+ */
+static void
+glyph_columns_to_rows(unsigned char *dst, const unsigned char *src, int pitch, int width, int height)
+{
+	int dpitch = (width + 7) / 8;
+	int col, row;
+
+	memset(dst, 0, dpitch * height);
+	for (col = 0; col < width; col++, src += pitch) {
+		for (row = 0; row < height; row++) {
+			if (src[row / 8] & (1 << (row % 8)))
+				dst[row * dpitch + col / 8] |= 0x80 >> (col % 8);
+		}
+	}
+}
+
+
+/**
+ * Prepare the built-in fonts in the layout of the framebuffer.
+ *
+ * \param rconf   Renderer configuration
+ * \param layout  Framebuffer layout
+ */
+static void
+glcd_render_prepare_fonts(RenderConfig *rconf, enum fb_types layout)
+{
+	unsigned char rows[GLCD_FONT_HEIGHT];
+	int c, i;
+
+	for (c = 0; c < 256; c++) {
+		/*
+		 * The font definition has the leftmost pixel in bit
+		 * GLCD_FONT_WIDTH, leaving one empty column to the left.
+		 */
+		for (i = 0; i < GLCD_FONT_HEIGHT; i++)
+			rows[i] = glcd_iso8859_1[c][i] << (7 - GLCD_FONT_WIDTH);
+
+		if (layout == FB_TYPE_LINEAR)
+			memcpy(rconf->font[c], rows, GLCD_FONT_HEIGHT);
+		else
+			glyph_rows_to_columns(rconf->font[c], rows, 1,
+					      GLCD_FONT_CELLWIDTH, GLCD_FONT_HEIGHT);
+	}
+
+	for (c = 0; c < 11; c++) {
+		GlyphMask *g = &rconf->bignum_glyph[c];
+
+		g->width = widtbl_NUM[c];
+		g->height = chr_hgt_NUM;
+		if (layout == FB_TYPE_LINEAR) {
+			g->pitch = (g->width + 7) / 8;
+			glyph_columns_to_rows(rconf->bignum[c], chrtbl_NUM[c], 3,
+					      g->width, g->height);
+			g->data = rconf->bignum[c];
+		}
+		else {
+			/* The bignum font already is in column format */
+			g->pitch = 3;
+			g->data = chrtbl_NUM[c];
+		}
+	}
+}
+
+
 /**
  * Initializes rendering code. Any rendering related configuration settings
  * from LCDd.conf should be read here.
@@ -56,18 +417,13 @@ int
 glcd_render_init(Driver *drvthis)
 {
 	PrivateData *p = drvthis->private_data;
+	RenderConfig *rconf;
+
 	p->cellwidth = GLCD_DEFAULT_CELLWIDTH;
 	p->cellheight = GLCD_DEFAULT_CELLHEIGHT;
 
 	debug(RPT_DEBUG, "%s: render_init()", drvthis->name);
 
-#ifdef HAVE_FT2
-	int rc;
-	const char *tmp;
-	char font_file[255];
-	RenderConfig *rconf;
-	int w, h;
-
 	/* Allocate memory structures */
 	rconf = (RenderConfig *) calloc(1, sizeof(RenderConfig));
 	if (rconf == NULL) {
@@ -76,6 +432,24 @@ glcd_render_init(Driver *drvthis)
 	}
 	p->render_config = rconf;
 
+	/* Select blit functions for the framebuffer layout */
+	if (p->framebuf.layout == FB_TYPE_LINEAR) {
+		rconf->blit = fb_blit_linear;
+		rconf->clear = fb_clear_linear;
+	}
+	else {
+		rconf->blit = fb_blit_vpaged;
+		rconf->clear = fb_clear_vpaged;
+	}
+	glcd_render_prepare_fonts(rconf, p->framebuf.layout);
+
+#ifdef HAVE_FT2
+	int rc;
+	const char *tmp;
+	char font_file[255];
+	int w, h;
+	int tmp_int;
+
 	/* use_ft2 is available in PrivateDate for easy use! */
 	p->use_ft2 = drvthis->config_get_bool(drvthis->name, "useFT2", 0, 1);
 
@@ -109,6 +483,16 @@ glcd_render_init(Driver *drvthis)
 		/* If the font does not have icons use default 5x8 font */
 		rconf->ft_has_icons = drvthis->config_get_bool(drvthis->name, "fontHasIcons", 0, 1);
 
+		/* Memory limit for the glyph cache */
+		tmp_int = drvthis->config_get_int(drvthis->name, "GlyphCacheSize", 0, GLCD_DEFAULT_GLYPH_CACHE);
+		if ((tmp_int < 0) || (tmp_int > 4096)) {
+			report(RPT_WARNING, "%s: GlyphCacheSize must be between 0 and 4096; using default %d",
+			       drvthis->name, GLCD_DEFAULT_GLYPH_CACHE);
+			tmp_int = GLCD_DEFAULT_GLYPH_CACHE;
+		}
+		rconf->cache_limit = tmp_int * 1024L;
+		rconf->ft_font_size = -1;
+
 		/* Read display size in pixels */
 		tmp = drvthis->config_get_string(drvthis->name, "CellSize", 0, "6x8");
 		if ((sscanf(tmp, "%dx%d", &w, &h) != 2)
@@ -144,54 +528,154 @@ err_out:
 void
 glcd_render_close(Driver *drvthis)
 {
-#ifdef HAVE_FT2
 	PrivateData *p = drvthis->private_data;
 	RenderConfig *rconf = p->render_config;
 
 	if (rconf != NULL) {
+#ifdef HAVE_FT2
+		debug(RPT_DEBUG, "%s: glyph cache: %ld hits, %ld misses, %ld bytes",
+		      drvthis->name, rconf->cache_hits, rconf->cache_misses, rconf->cache_used);
+		glyph_cache_flush(rconf);
 		if (rconf->ft_normal_font != NULL)
 			FT_Done_Face(rconf->ft_normal_font);
 		if (rconf->ft_library != NULL)
 			FT_Done_FreeType(rconf->ft_library);
-
+#endif
 		free(rconf);
 		p->render_config = NULL;
 	}
-#endif
 }
 
 
 #ifdef HAVE_FT2
 /**
- * Draws character c to the framebuffer at position x,y using Freetype 2 for
- * font rendering. Top left corner is (1/1).
+ * Compute the hash bucket of a glyph cache key.
+ */
+static inline unsigned int
+glyph_cache_hash(int c, int yscale, int xscale)
+{
+	return ((unsigned int) c * 31 + yscale * 7 + xscale) % GLYPH_CACHE_BUCKETS;
+}
+
+
+/**
+ * Remove an entry from the LRU list.
+ */
+static void
+glyph_cache_unlink(RenderConfig *rconf, GlyphCacheEntry *e)
+{
+	if (e->prev != NULL)
+		e->prev->next = e->next;
+	else
+		rconf->cache_head = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	else
+		rconf->cache_tail = e->prev;
+	e->prev = e->next = NULL;
+}
+
+
+/**
+ * Put an entry at the head of the LRU list.
+ */
+static void
+glyph_cache_push(RenderConfig *rconf, GlyphCacheEntry *e)
+{
+	e->prev = NULL;
+	e->next = rconf->cache_head;
+	if (rconf->cache_head != NULL)
+		rconf->cache_head->prev = e;
+	rconf->cache_head = e;
+	if (rconf->cache_tail == NULL)
+		rconf->cache_tail = e;
+}
+
+
+/**
+ * Look up a glyph in the cache. A found glyph becomes the most recently
+ * used one.
+ *
+ * \return  Pointer to cache entry or NULL if not cached.
+ */
+static GlyphCacheEntry *
+glyph_cache_find(RenderConfig *rconf, int c, int yscale, int xscale)
+{
+	GlyphCacheEntry *e;
+
+	for (e = rconf->cache[glyph_cache_hash(c, yscale, xscale)]; e != NULL; e = e->hnext) {
+		if ((e->c == c) && (e->yscale == yscale) && (e->xscale == xscale)) {
+			if (e != rconf->cache_head) {
+				glyph_cache_unlink(rconf, e);
+				glyph_cache_push(rconf, e);
+			}
+			return e;
+		}
+	}
+	return NULL;
+}
+
+
+/**
+ * Remove the least recently used glyph from the cache and free it.
+ */
+static void
+glyph_cache_evict(RenderConfig *rconf)
+{
+	GlyphCacheEntry *e = rconf->cache_tail;
+	GlyphCacheEntry **pp;
+
+	if (e == NULL)
+		return;
+
+	glyph_cache_unlink(rconf, e);
+	for (pp = &rconf->cache[glyph_cache_hash(e->c, e->yscale, e->xscale)]; *pp != NULL; pp = &(*pp)->hnext) {
+		if (*pp == e) {
+			*pp = e->hnext;
+			break;
+		}
+	}
+	rconf->cache_used -= e->size;
+	free(e);
+}
+
+
+/**
+ * Free all glyphs in the cache.
+ */
+static void
+glyph_cache_flush(RenderConfig *rconf)
+{
+	while (rconf->cache_tail != NULL)
+		glyph_cache_evict(rconf);
+}
+
+
+/**
+ * Render a glyph with Freetype and convert it to the framebuffer's layout.
+ * The result is added to the cache unless it does not fit into the cache's
+ * memory limit. In that case the caller must free() the returned entry.
  *
  * \param drvthis  Pointer to driver structure.
- * \param x        Horizontal character position (column).
- * \param y        Vertical character position (row).
- * \param c        Character that gets written.
+ * \param c        Character to render.
  * \param yscale   Use multiple of cellheight
  * \param xscale   Use multiple of cellwidth
+ * \param cached   Set to 1 if the entry has been added to the cache.
+ * \return         New entry or NULL on error.
  */
-void
-glcd_render_char_unicode(Driver *drvthis, int x, int y, int c, int yscale, int xscale)
+static GlyphCacheEntry *
+glyph_cache_render(Driver *drvthis, int c, int yscale, int xscale, int *cached)
 {
-	static int last_font_size = -1;
 	PrivateData *p = drvthis->private_data;
 	RenderConfig *rconf = p->render_config;
-	int col, row;		/* Position in the font bitmap */
-	int px, py;		/* Pixel position on the display */
 	int r_width, r_height;	/* Size of the cell used to render char into */
-	int rc;
-	FT_Face face;
+	int rc, w, h, pitch, size;
+	unsigned int bucket;
+	FT_Face face = rconf->ft_normal_font;
 	FT_GlyphSlot glyph;
 	FT_Bitmap *bitmap;
-	unsigned char *bitmap_buf;
-
-	if (x < 1 || x > p->width || y < 1 || y > p->height)
-		return;
-
-	x--;			/* convert coordinates to zero-based */
+	GlyphCacheEntry *e;
+	unsigned char *data;
 
 	/*
 	 * Implementation note: This function can be used to render characters
@@ -206,64 +690,147 @@ glcd_render_char_unicode(Driver *drvthis, int x, int y, int c, int yscale, int x
 	 * Set the font size. We set the font pixel width and height to the
 	 * same value (r_height), otherwise characters look too much condensed.
 	 */
-	if (last_font_size != r_height) {
+	if (rconf->ft_font_size != r_height) {
 		debug(RPT_INFO, "%s: Setting font size to %d",  drvthis->name, r_height);
-		rc = FT_Set_Pixel_Sizes(rconf->ft_normal_font, r_height, r_height);
+		rc = FT_Set_Pixel_Sizes(face, r_height, r_height);
 		if (rc != 0) {
 			report(RPT_ERR, "%s: Failed to set pixel size (%dx%x)", drvthis->name,
 			       p->cellwidth, p->cellheight);
-			return;
+			return NULL;
 		}
 
-		last_font_size = r_height;
+		rconf->ft_font_size = r_height;
 	}
 
 	/* load the glyph and render it */
-	rc = FT_Load_Char(rconf->ft_normal_font, c, FT_LOAD_RENDER | FT_LOAD_MONOCHROME);
+	rc = FT_Load_Char(face, c, FT_LOAD_RENDER | FT_LOAD_MONOCHROME);
 	if (rc != 0) {
 		report(RPT_ERR, "%s: loading char '%c' (0x%x) failed", drvthis->name, c, c);
-		return;
+		return NULL;
 	}
+	rconf->cache_misses++;
 
-	/* set some data elements for convenience */
-	face = rconf->ft_normal_font;
-	glyph = rconf->ft_normal_font->glyph;
+	glyph = face->glyph;
 	bitmap = &glyph->bitmap;
-	bitmap_buf = bitmap->buffer;
 
-	/* Clear the cell. */
-	py = max(y * p->cellheight - r_height, 0);
-	for (row = 0; row < r_height; row++, py++) {
-		px = x * p->cellwidth;
-		for (col = 0; col < r_width; col++, px++) {
-			fb_draw_pixel(&(p->framebuf), px, py, 0);
+	w = max(min((int) bitmap->width, r_width), 0);
+	h = max(min((int) bitmap->rows, r_height), 0);
+	if (p->framebuf.layout == FB_TYPE_LINEAR)
+		pitch = (w + 7) / 8;
+	else
+		pitch = (h + 7) / 8;
+	size = sizeof(GlyphCacheEntry) + pitch * ((p->framebuf.layout == FB_TYPE_LINEAR) ? h : w);
+
+	e = malloc(size);
+	if (e == NULL) {
+		report(RPT_ERR, "%s: error allocating glyph", drvthis->name);
+		return NULL;
+	}
+	data = (unsigned char *) (e + 1);
+
+	e->c = c;
+	e->yscale = yscale;
+	e->xscale = xscale;
+	e->size = size;
+	e->mask.width = w;
+	e->mask.height = h;
+	e->mask.pitch = pitch;
+	e->mask.data = data;
+
+	/* Vertical offset of the glyph's top row from the cell's bottom */
+	e->dy = (face->size->metrics.descender >> 6) - glyph->bitmap_top;
+	/*
+	 * Hack: If scales are not the same, ignore Freetype's idea of
+	 * character position, but just center it. Currently only used
+	 * for the ':' of the bignum.
+	 */
+	if (yscale == xscale)
+		e->dx = glyph->bitmap_left;
+	else
+		e->dx = (r_width - (int) bitmap->width) / 2;
+
+	if ((w > 0) && (h > 0)) {
+		if (p->framebuf.layout == FB_TYPE_LINEAR) {
+			int row;
+
+			/* Freetype's monochrome bitmaps already are in linear layout */
+			for (row = 0; row < h; row++)
+				memcpy(data + row * pitch, bitmap->buffer + row * bitmap->pitch, pitch);
 		}
+		else
+			glyph_rows_to_columns(data, bitmap->buffer, bitmap->pitch, w, h);
 	}
 
+	*cached = 0;
+	if (size > rconf->cache_limit)
+		return e;
+
+	while (rconf->cache_used + size > rconf->cache_limit)
+		glyph_cache_evict(rconf);
+
+	bucket = glyph_cache_hash(c, yscale, xscale);
+	e->hnext = rconf->cache[bucket];
+	rconf->cache[bucket] = e;
+	glyph_cache_push(rconf, e);
+	rconf->cache_used += size;
+	*cached = 1;
+
+	return e;
+}
+
+
+/**
+ * Draws character c to the framebuffer at position x,y using Freetype 2 for
+ * font rendering. Top left corner is (1/1). Rendered glyphs are kept in a
+ * cache, only glyphs not drawn recently are rendered by Freetype.
+ *
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column).
+ * \param y        Vertical character position (row).
+ * \param c        Character that gets written.
+ * \param yscale   Use multiple of cellheight
+ * \param xscale   Use multiple of cellwidth
+ */
+void
+glcd_render_char_unicode(Driver *drvthis, int x, int y, int c, int yscale, int xscale)
+{
+	PrivateData *p = drvthis->private_data;
+	RenderConfig *rconf = p->render_config;
+	int r_width, r_height;	/* Size of the cell used to render char into */
+	int cached = 1;
+	GlyphCacheEntry *e;
+
+	if (x < 1 || x > p->width || y < 1 || y > p->height)
+		return;
+
+	x--;			/* convert coordinates to zero-based */
+
+	e = glyph_cache_find(rconf, c, yscale, xscale);
+	if (e != NULL)
+		rconf->cache_hits++;
+	else {
+		e = glyph_cache_render(drvthis, c, yscale, xscale, &cached);
+		if (e == NULL)
+			return;
+	}
+
+	r_height = p->cellheight * yscale;
+	r_width = p->cellwidth * xscale;
+
+	/* Clear the cell. */
+	rconf->clear(&(p->framebuf), x * p->cellwidth, max(y * p->cellheight - r_height, 0),
+		     r_width, r_height);
+
 	/*
 	 * Copy the pixels. Important: The font metrics may result in negative
 	 * py value! So protect it by restricting it to 0.
 	 */
-	py = max(y * p->cellheight + (face->size->metrics.descender >> 6) - glyph->bitmap_top, 0);
-	for (row = 0; (row < bitmap->rows) && (row < r_height); row++) {
-		px = x * p->cellwidth;
-		/*
-		 * Hack: If scales are not the same, ignore Freetype's idea of
-		 * character position, but just center it. Currently only used
-		 * for the ':' of the bignum.
-		 */
-		if (yscale == xscale)
-			px += glyph->bitmap_left;
-		else
-			px += (r_width - bitmap->width)/2;
+	if ((e->mask.width > 0) && (e->mask.height > 0))
+		rconf->blit(&(p->framebuf), x * p->cellwidth + e->dx,
+			    max(y * p->cellheight + e->dy, 0), &e->mask);
 
-		for (col = 0; (col < bitmap->width) && (col < r_width); col++) {
-			fb_draw_pixel(&(p->framebuf), px, py, bitmap_buf[col / 8] >> (7 - (col % 8)) & 1);
-			px++;
-		}
-		bitmap_buf += bitmap->pitch;
-		py++;
-	}
+	if (!cached)
+		free(e);
 }
 #endif
 
@@ -280,8 +847,8 @@ void
 glcd_render_char(Driver *drvthis, int x, int y, unsigned char c)
 {
 	PrivateData *p = drvthis->private_data;
-	int font_x, font_y;	/* Position in the font definition array */
-	int px, py;		/* Pixel position on the display */
+	RenderConfig *rconf = p->render_config;
+	GlyphMask mask;
 
 	if (x < 1 || x > p->width || y < 1 || y > p->height)
 		return;
@@ -290,29 +857,17 @@ glcd_render_char(Driver *drvthis, int x, int y, unsigned char c)
 	y--;
 
 	/*
-	 * Algorithm: For each row in the font definition check if bit (dot)
-	 * at each column is set. If yes, plot a dot into the framebuffer. If
-	 * the bit is not set then clear the dot. Currently it is wrong to
-	 * assume the framebuffer is clear (e.g. the heartbeat does not clear
-	 * it's contents in advance).
+	 * The glyph replaces all pixels of the cell it covers. Currently it
+	 * is wrong to assume the framebuffer is clear (e.g. the heartbeat
+	 * does not clear it's contents in advance).
 	 */
 	/* FIXME: What happens if font is larger than cell size? */
-	py = y * p->cellheight;
-	for (font_y = 0; font_y < GLCD_FONT_HEIGHT; font_y++) {
-		px = x * p->cellwidth;
-		/*
-		 * Note: Initializing font_x with font's width leaves one
-		 * empty column to the left.
-		 */
-		for (font_x = GLCD_FONT_WIDTH; font_x >= 0; font_x--) {
-			if (glcd_iso8859_1[c][font_y] & (1 << font_x))
-				fb_draw_pixel(&(p->framebuf), px, py, 1);
-			else
-				fb_draw_pixel(&(p->framebuf), px, py, 0);
-			px++;
-		}
-		py++;
-	}
+	mask.width = GLCD_FONT_CELLWIDTH;
+	mask.height = GLCD_FONT_HEIGHT;
+	mask.pitch = 1;
+	mask.data = rconf->font[c];
+
+	rconf->blit(&(p->framebuf), x * p->cellwidth, y * p->cellheight, &mask);
 }
 
 
@@ -393,10 +948,9 @@ glcd_render_icon(Driver *drvthis, int x, int y, int icon)
 
 
 /**
- * Draw a big digit (or colon) using the built-in 16x24 font. Although the font
- * is stored in different pixel layout (column format, LSB top) this does not
- * matter as we need to address pixels in frame buffer anyway. The digit is
- * centered vertically.
+ * Draw a big digit (or colon) using the built-in 16x24 font. The font is
+ * stored in column format (LSB top) and has been converted to the layout of
+ * the framebuffer by glcd_render_init(). The digit is centered vertically.
  *
  * \note  Works only for displays with pixel height >= 24! Smaller displays are
  *        not supported and nothing will be drawn.
@@ -409,26 +963,14 @@ void
 glcd_render_bignum(Driver *drvthis, int x, int num)
 {
 	PrivateData *p = drvthis->private_data;
-	int c, z;		/* Column and byte within font definition */
-	int px, py;		/* Pixel coordinates within the frame buffer */
+	RenderConfig *rconf = p->render_config;
 
 	if (p->framebuf.px_height < chr_hgt_NUM)
 		return;
 
 	x--;
 
-	px = x * p->cellwidth;
-	for (c = 0; c < widtbl_NUM[num]; c++) {
-		/* center vertically */
-		py = (p->framebuf.px_height - chr_hgt_NUM) / 2;
-		for (z = 0; z < chr_hgt_NUM; z++) {
-			/* Test if pixel bit is set and draw it */
-			if (chrtbl_NUM[num][c * 3 + z / 8] & (1 << (z % 8)))
-				fb_draw_pixel(&(p->framebuf), px, py, 1);
-			else
-				fb_draw_pixel(&(p->framebuf), px, py, 0);
-			py++;
-		}
-		px++;
-	}
+	/* center vertically */
+	rconf->blit(&(p->framebuf), x * p->cellwidth,
+		    (p->framebuf.px_height - chr_hgt_NUM) / 2, &rconf->bignum_glyph[num]);
 }
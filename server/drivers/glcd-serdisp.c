@@ -126,6 +126,7 @@ glcd_serdisp_init(Driver *drvthis)
 	ct_data->bsbuf.px_height = p->framebuf.px_height;
 	ct_data->bsbuf.bytesPerLine = p->framebuf.bytesPerLine;
 	ct_data->bsbuf.size = p->framebuf.size;
+	ct_data->bsbuf.layout = p->framebuf.layout;
 	ct_data->bsbuf.data = malloc(ct_data->bsbuf.size);
 	if (ct_data->bsbuf.data == NULL) {
 		report(RPT_ERR, "%s: error allocating backing store",
@@ -178,24 +179,64 @@ void
 glcd_serdisp_blit(PrivateData *p)
 {
 	CT_serdisp_data *ct_data = (CT_serdisp_data *) p->ct_data;
-	int px, py;
-	int pixel_new, pixel_old;
+	struct glcd_framebuf *fb = &(p->framebuf);
+	int line, lines, len;
+	int i, bit;
+
+	/* Check if framebufer has changed. If not there's nothing to do */
+	if (memcmp(fb->data, ct_data->bsbuf.data, fb->size) == 0)
+		return;
 
 	/*
-	 * Update method: go through the whole framebuffer line by line and
-	 * compare each pixel with the one in the backing store. If different
-	 * draw to serdisplib.
+	 * Update method: compare the framebuffer with the backing store one
+	 * line of bytes (pixel row or page) at a time and skip unchanged
+	 * lines. In changed lines XOR the bytes to find the changed pixels and
+	 * only draw those to serdisplib.
 	 */
-	for (py = 0; py < p->framebuf.px_height; py++) {
-		for (px = 0; px < p->framebuf.px_width; px++) {
-			pixel_old = fb_get_pixel(&(ct_data->bsbuf), px, py);
-			pixel_new = fb_get_pixel(&(p->framebuf), px, py);
-			if (pixel_old != pixel_new) {
+	if (fb->layout == FB_TYPE_LINEAR) {
+		lines = fb->px_height;
+		len = fb->bytesPerLine;
+	}
+	else {
+		lines = (fb->px_height + 7) / 8;
+		len = fb->px_width;
+	}
+
+	for (line = 0; line < lines; line++) {
+		unsigned char *new = fb->data + line * len;
+		unsigned char *old = ct_data->bsbuf.data + line * len;
+
+		if (memcmp(new, old, len) == 0)
+			continue;
+
+		for (i = 0; i < len; i++) {
+			unsigned char diff = new[i] ^ old[i];
+
+			if (diff == 0)
+				continue;
+
+			for (bit = 0; bit < 8; bit++) {
+				int px, py;
+				unsigned char mask;
+
+				if (fb->layout == FB_TYPE_LINEAR) {
+					mask = 0x80 >> bit;
+					px = i * 8 + bit;
+					py = line;
+				}
+				else {
+					mask = 0x01 << bit;
+					px = i;
+					py = line * 8 + bit;
+				}
+				if (!(diff & mask) || (px >= fb->px_width) || (py >= fb->px_height))
+					continue;
+
 				serdisp_setcolour(ct_data->disp, px, py,
-						  (pixel_new == FB_BLACK) ? SD_COL_BLACK : SD_COL_WHITE);
-				fb_draw_pixel(&(ct_data->bsbuf), px, py, pixel_new);
+						  (new[i] & mask) ? SD_COL_BLACK : SD_COL_WHITE);
 			}
 		}
+		memcpy(old, new, len);
 	}
 	serdisp_update(ct_data->disp);
 }
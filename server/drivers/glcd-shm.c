@@ -0,0 +1,163 @@
+/** \file server/drivers/glcd-shm.c
+ * This connection type publishes the 1bpp framebuffer in a POSIX shared
+ * memory object using the layout of the \c shm driver (see shm-lcd.h).
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lcd.h"
+#include "report.h"
+#include "glcd-low.h"
+#include "shm-lcd.h"
+
+/* Prototypes */
+void glcd_shm_blit(PrivateData *p);
+void glcd_shm_set_backlight(PrivateData *p, int state);
+void glcd_shm_set_contrast(PrivateData *p, int value);
+void glcd_shm_close(PrivateData *p);
+
+/** Private data for the shm connection type */
+typedef struct glcd_shm_data {
+	ShmLcd *shm;		/**< the shared memory segment */
+	int state_changed;	/**< backlight or contrast changed */
+} CT_shm_data;
+
+/**
+ * API: Initialize the connection type driver.
+ * \param drvthis  Pointer to driver structure.
+ * \retval 0       Success.
+ * \retval <0      Error.
+ */
+int
+glcd_shm_init(Driver *drvthis)
+{
+	PrivateData *p = (PrivateData *)drvthis->private_data;
+	CT_shm_data *ct_data;
+	const char *name;
+
+	report(RPT_INFO, "GLCD/shm: intializing");
+
+	/* Set up connection type low-level functions */
+	p->glcd_functions->blit = glcd_shm_blit;
+	p->glcd_functions->set_backlight = glcd_shm_set_backlight;
+	p->glcd_functions->set_contrast = glcd_shm_set_contrast;
+	p->glcd_functions->close = glcd_shm_close;
+
+	/* Allocate memory structures */
+	ct_data = (CT_shm_data *) calloc(1, sizeof(CT_shm_data));
+	if (ct_data == NULL) {
+		report(RPT_ERR, "GLCD/shm: error allocating connection data");
+		return -1;
+	}
+	p->ct_data = ct_data;
+
+	name = drvthis->config_get_string(drvthis->name, "shm_Name", 0, SHM_LCD_DEFAULT_NAME);
+	if ((name[0] != '/') || (strchr(name + 1, '/') != NULL)) {
+		report(RPT_ERR, "GLCD/shm: shm_Name must start with '/' and contain no other '/': %s",
+		       name);
+		return -1;
+	}
+
+	/*
+	 * Readers get the linear layout as the framebuffer uses it by default.
+	 * The cell size is not known before the renderer is set up, it is
+	 * published with the first frame.
+	 */
+	ct_data->shm = shm_lcd_create(name, 0644, SHM_LCD_GRAPHIC,
+				      p->framebuf.px_width, p->framebuf.px_height,
+				      0, 0, p->framebuf.bytesPerLine);
+	if (ct_data->shm == NULL) {
+		report(RPT_ERR, "GLCD/shm: unable to create shared memory %s: %s",
+		       name, strerror(errno));
+		return -1;
+	}
+	ct_data->state_changed = 1;
+
+	report(RPT_INFO, "GLCD/shm: publishing %dx%d framebuffer as %s",
+	       p->framebuf.px_width, p->framebuf.px_height, name);
+	debug(RPT_DEBUG, "GLCD/shm: init() done");
+
+	return 0;
+}
+
+/**
+ * API: Publish the framebuffer if it or the backlight state has changed.
+ * \param p  Pointer to glcd driver's private date structure.
+ */
+void
+glcd_shm_blit(PrivateData *p)
+{
+	CT_shm_data *ct_data = (CT_shm_data *) p->ct_data;
+	ShmLcdHeader *hdr = ct_data->shm->hdr;
+
+	/* We are the only writer, so the segment can be compared without lock */
+	if (!ct_data->state_changed
+	    && (memcmp(shm_lcd_data(hdr), p->framebuf.data, p->framebuf.size) == 0))
+		return;
+
+	shm_lcd_write_begin(hdr);
+	memcpy(shm_lcd_data(hdr), p->framebuf.data, p->framebuf.size);
+	hdr->backlight = (p->backlightstate == BACKLIGHT_OFF) ? BACKLIGHT_OFF : BACKLIGHT_ON;
+	hdr->brightness = (hdr->backlight == BACKLIGHT_ON) ? p->brightness : p->offbrightness;
+	hdr->contrast = p->contrast;
+	hdr->cellwidth = p->cellwidth;
+	hdr->cellheight = p->cellheight;
+	shm_lcd_write_end(hdr);
+
+	ct_data->state_changed = 0;
+}
+
+/**
+ * API: Note a backlight change. It is published with the next frame.
+ * \param p      Pointer to glcd driver's private date structure.
+ * \param state  New backlight state.
+ */
+void
+glcd_shm_set_backlight(PrivateData *p, int state)
+{
+	CT_shm_data *ct_data = (CT_shm_data *) p->ct_data;
+
+	ct_data->state_changed = 1;
+}
+
+/**
+ * API: Note a contrast change. It is published with the next frame.
+ * \param p      Pointer to glcd driver's private date structure.
+ * \param value  New contrast value in promille.
+ */
+void
+glcd_shm_set_contrast(PrivateData *p, int value)
+{
+	CT_shm_data *ct_data = (CT_shm_data *) p->ct_data;
+
+	ct_data->state_changed = 1;
+}
+
+/**
+ * API: Release low-level resources.
+ * \param p  Pointer to glcd driver's private date structure.
+ */
+void
+glcd_shm_close(PrivateData *p)
+{
+	if (p->ct_data != NULL) {
+		CT_shm_data *ct_data = (CT_shm_data *) p->ct_data;
+
+		shm_lcd_destroy(ct_data->shm);
+
+		free(p->ct_data);
+		p->ct_data = NULL;
+	}
+}
@@ -135,37 +135,30 @@ void
 glcd_t6963_blit(PrivateData *p)
 {
 	CT_t6963_data *ct_data = (CT_t6963_data *) p->ct_data;
-	int x, y;
+	int bpl = p->framebuf.bytesPerLine;
+	int start, end, y;
 
 	for (y = 0; y < p->framebuf.px_height; y++) {
 		/* set pointers to start of the line */
-		unsigned char *sp = p->framebuf.data + (y * p->framebuf.bytesPerLine);
-		unsigned char *sq = ct_data->backingstore + (y * p->framebuf.bytesPerLine);
-
-		/* set pointers to end of the line */
-		unsigned char *ep = sp + (p->framebuf.bytesPerLine - 1);
-		unsigned char *eq = sq + (p->framebuf.bytesPerLine - 1);
+		unsigned char *sp = p->framebuf.data + (y * bpl);
+		unsigned char *sq = ct_data->backingstore + (y * bpl);
 
 		/* find begin and end of differences */
-		x = 0;
-		while ((sp <= ep) && (*sp == *sq)) {
-			sp++, sq++, x++;
-		}
-		while ((ep >= sp) && (*ep == *eq)) {
-			ep--, eq--;
-		}
+		start = fb_diff_span(sp, sq, 0, bpl, bpl, &end);
 
 		/* there are differences, ... */
-		if (sp <= ep) {
+		if (start >= 0) {
+			int x;
+
 			t6963_low_command_word(ct_data->port_config, SET_ADDRESS_POINTER,
-				  GRAPHIC_BASE + (y * p->framebuf.bytesPerLine) + x);
+					       GRAPHIC_BASE + (y * bpl) + start);
 			t6963_low_command(ct_data->port_config, AUTO_WRITE);
-			while (sp <= ep) {
-				t6963_low_auto_write(ct_data->port_config, *sp);
-				/* Update backing store and advance */
-				*sq++ = *sp++;
-			}
+			for (x = start; x < end; x++)
+				t6963_low_auto_write(ct_data->port_config, sp[x]);
 			t6963_low_command(ct_data->port_config, AUTO_RESET);
+
+			/* Update backing store */
+			memcpy(sq + start, sp + start, end - start);
 		}
 	}
 }
@@ -3,6 +3,10 @@
  * Written to mimic X11 driver written for lcd4linux. Except this one does not
  * have graphical buttons or cell gaps.  Written to represent a graphical LCD
  * only.
+ *
+ * The LCD area is rendered into an XImage, which is kept in shared memory if
+ * the X server supports the MIT-SHM extension. Only rectangles covering the
+ * changed pixel rows are sent to the X server.
  */
 
 /*-
@@ -17,6 +21,7 @@
 #endif
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <errno.h>
 #include <stdio.h>
 #include <sys/stat.h>
@@ -27,6 +32,11 @@
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xresource.h>
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
 
 #include "lcd.h"
 #include "report.h"
@@ -58,6 +68,15 @@ typedef struct glcd_x11_data {
 	Atom wmDeleteMessage;	/** Atom identifier for closing the window */
 
 	unsigned char *backingstore;	/** Holds a copy of the LCD screen data */
+
+	XImage *image;		/** Image of the LCD area (without border) */
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+	XShmSegmentInfo shminfo;	/** Shared memory holding the image data */
+	int use_shm;		/** Image is sent using MIT-SHM */
+#endif
+	unsigned long img_fgc;	/** Pixel color the image was drawn with */
+	unsigned long img_bgc;	/** Backlight color the image was drawn with */
+	int redraw;		/** Draw the whole image with the next blit */
 } CT_x11_data;
 
 /* Prototypes */
@@ -67,35 +86,185 @@ unsigned char glcd_x11_pollkeys(PrivateData *p);
 void glcd_x11_set_backlight(PrivateData *p, int state);
 static void x11w_adj_contrast_brightness(unsigned long *pfgc, unsigned long *pbgc, int contrast,
 					 int brightness);
-static void x11w_draw_pixel(CT_x11_data * ct_data, int x, int y, unsigned long fgc,
-			    unsigned long bgc);
+static int x11w_create_image(CT_x11_data * ct_data, int width, int height);
+static void x11w_fill_image(CT_x11_data * ct_data, unsigned long bgc);
+static void x11w_draw_row(CT_x11_data * ct_data, struct glcd_framebuf *fb, int y,
+			  unsigned long fgc, unsigned long bgc);
+static void x11w_put_image(CT_x11_data * ct_data, int x, int y, int width, int height);
+
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+/** Set by x11w_error_handler if attaching the shared memory failed. */
+static int x11w_shm_error;
+
+/**
+ * Catches the error of XShmAttach if the X server cannot access our shared
+ * memory (e.g. it runs on a different machine).
+ */
+static int
+x11w_error_handler(Display *dp, XErrorEvent *ev)
+{
+	x11w_shm_error = 1;
+	return 0;
+}
+#endif
 
 /**
- * Draws a single LCD pixel in the X11 window.
+ * Creates the image the LCD area is rendered to. Shared memory is used if
+ * the X server supports it, otherwise the image is held in client memory.
  * \param ct_data  Connection type's private data.
- * \param x        LCD x position.
+ * \param width    Width of the LCD area in screen pixels.
+ * \param height   Height of the LCD area in screen pixels.
+ * \retval 0       Success.
+ * \retval <0      Error.
+ */
+static int
+x11w_create_image(CT_x11_data * ct_data, int width, int height)
+{
+	int depth = DefaultDepth(ct_data->dp, ct_data->sc);
+
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+	if (XShmQueryExtension(ct_data->dp)) {
+		XShmSegmentInfo *si = &ct_data->shminfo;
+
+		ct_data->image = XShmCreateImage(ct_data->dp, ct_data->vi, depth, ZPixmap,
+						 NULL, si, width, height);
+		if (ct_data->image != NULL) {
+			si->shmid = shmget(IPC_PRIVATE, ct_data->image->bytes_per_line * height,
+					   IPC_CREAT | 0600);
+			si->shmaddr = (si->shmid < 0) ? (char *) -1 : shmat(si->shmid, NULL, 0);
+
+			if (si->shmaddr != (char *) -1) {
+				XErrorHandler old_handler;
+
+				ct_data->image->data = si->shmaddr;
+				si->readOnly = False;
+
+				x11w_shm_error = 0;
+				old_handler = XSetErrorHandler(x11w_error_handler);
+				XShmAttach(ct_data->dp, si);
+				XSync(ct_data->dp, False);
+				XSetErrorHandler(old_handler);
+
+				if (!x11w_shm_error)
+					ct_data->use_shm = 1;
+				else
+					shmdt(si->shmaddr);
+			}
+			/* Segment is released after both sides have detached */
+			if (si->shmid >= 0)
+				shmctl(si->shmid, IPC_RMID, NULL);
+
+			if (ct_data->use_shm)
+				return 0;
+
+			XDestroyImage(ct_data->image);
+			ct_data->image = NULL;
+		}
+	}
+#endif
+
+	ct_data->image = XCreateImage(ct_data->dp, ct_data->vi, depth, ZPixmap, 0, NULL,
+				      width, height, 32, 0);
+	if (ct_data->image == NULL)
+		return -1;
+
+	ct_data->image->data = malloc(ct_data->image->bytes_per_line * height);
+	if (ct_data->image->data == NULL) {
+		XDestroyImage(ct_data->image);
+		ct_data->image = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Fills the whole image with the background color. This draws the gaps
+ * between LCD pixels which are not touched by x11w_draw_row().
+ * \param ct_data  Connection type's private data.
+ * \param bgc      Background color.
+ */
+static void
+x11w_fill_image(CT_x11_data * ct_data, unsigned long bgc)
+{
+	XImage *img = ct_data->image;
+	int x, y;
+
+	for (x = 0; x < img->width; x++)
+		XPutPixel(img, x, 0, bgc);
+	for (y = 1; y < img->height; y++)
+		memcpy(img->data + y * img->bytes_per_line, img->data, img->bytes_per_line);
+}
+
+/**
+ * Renders one row of LCD pixels into the image. Only the screen pixels of
+ * the LCD dots are written, the gaps keep the background color.
+ * \param ct_data  Connection type's private data.
+ * \param fb       Framebuffer (linear layout).
  * \param y        LCD y position.
  * \param fgc      Foreground color.
  * \param bgc      Background color.
  */
 static void
-x11w_draw_pixel(CT_x11_data * ct_data, int x, int y, unsigned long fgc, unsigned long bgc)
+x11w_draw_row(CT_x11_data * ct_data, struct glcd_framebuf *fb, int y,
+	      unsigned long fgc, unsigned long bgc)
 {
+	static const int one = 1;
+	XImage *img = ct_data->image;
 	int pxlsize = ct_data->pixel + ct_data->pgap;
-	int xoffset = ct_data->border + (x * pxlsize);
-	int yoffset = ct_data->border + (y * pxlsize);
-
-	/* This basically erases the area beneath LCD pixel being drawn. */
-	XSetForeground(ct_data->dp, ct_data->gc, bgc);
-	XFillRectangle(ct_data->dp, ct_data->w, ct_data->gc, xoffset, yoffset, pxlsize, pxlsize);
-
-	/* Only draw if foreground color is different from background color.
-	 * No need to draw the same area twice. */
-	if (fgc != bgc) {
-		XSetForeground(ct_data->dp, ct_data->gc, fgc);
-		XFillRectangle(ct_data->dp, ct_data->w, ct_data->gc, xoffset,
-			       yoffset, ct_data->pixel, ct_data->pixel);
+	char *line = img->data + (y * pxlsize) * img->bytes_per_line;
+	unsigned char *src = fb->data + y * fb->bytesPerLine;
+	int x, i;
+
+	/* Draw the first screen row of the LCD row */
+	if ((img->bits_per_pixel == 32)
+	    && (img->byte_order == ((*(const char *) &one) ? LSBFirst : MSBFirst))) {
+		/* Common TrueColor case: write pixel values directly */
+		uint32_t *dst = (uint32_t *) line;
+
+		for (x = 0; x < fb->px_width; x++) {
+			int on = ((src[x / 8] & (0x80 >> (x % 8))) != 0) ^ ct_data->inverted;
+			uint32_t c = on ? fgc : bgc;
+
+			for (i = 0; i < ct_data->pixel; i++)
+				dst[i] = c;
+			dst += pxlsize;
+		}
 	}
+	else {
+		for (x = 0; x < fb->px_width; x++) {
+			int on = ((src[x / 8] & (0x80 >> (x % 8))) != 0) ^ ct_data->inverted;
+
+			for (i = 0; i < ct_data->pixel; i++)
+				XPutPixel(img, x * pxlsize + i, y * pxlsize, on ? fgc : bgc);
+		}
+	}
+
+	/* Copy it to the other screen rows of the LCD dots */
+	for (i = 1; i < ct_data->pixel; i++)
+		memcpy(line + i * img->bytes_per_line, line, img->bytes_per_line);
+}
+
+/**
+ * Sends a rectangle of the image to the X server.
+ * \param ct_data  Connection type's private data.
+ * \param x        Left edge in the image.
+ * \param y        Top edge in the image.
+ * \param width    Width of the rectangle.
+ * \param height   Height of the rectangle.
+ */
+static void
+x11w_put_image(CT_x11_data * ct_data, int x, int y, int width, int height)
+{
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+	if (ct_data->use_shm) {
+		XShmPutImage(ct_data->dp, ct_data->w, ct_data->gc, ct_data->image, x, y,
+			     ct_data->border + x, ct_data->border + y, width, height, False);
+		return;
+	}
+#endif
+	XPutImage(ct_data->dp, ct_data->w, ct_data->gc, ct_data->image, x, y,
+		  ct_data->border + x, ct_data->border + y, width, height);
 }
 
 /**
@@ -275,6 +444,17 @@ glcd_x11_init(Driver *drvthis)
 			break;
 	}
 
+	if (x11w_create_image(ct_data, p->framebuf.px_width * (ct_data->pixel + ct_data->pgap),
+			      p->framebuf.px_height * (ct_data->pixel + ct_data->pgap)) < 0) {
+		report(RPT_ERR, "GLCD/x11: unable to create image");
+		return -1;
+	}
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+	report(RPT_INFO, "GLCD/x11: %s", ct_data->use_shm ? "using MIT-SHM"
+	       : "MIT-SHM not available, using XPutImage");
+#endif
+	ct_data->redraw = 1;
+
 	debug(RPT_DEBUG, "GLCD/x11: init() done");
 
 	return 0;
@@ -288,16 +468,12 @@ void
 glcd_x11_blit(PrivateData *p)
 {
 	CT_x11_data *ct_data = (CT_x11_data *) p->ct_data;
-
-	/* Check if frame buffer has changed. If not there's nothing to do */
-	if (memcmp(p->framebuf.data, ct_data->backingstore, p->framebuf.size)
-	    == 0)
-		return;
-
+	struct glcd_framebuf *fb = &p->framebuf;
+	int pxlsize = ct_data->pixel + ct_data->pgap;
 	unsigned long fgc = ct_data->fgcolor;
 	unsigned long bgc = ct_data->bgcolor;
+	int full, first, lo, hi;
 	int y;
-	int x;
 
 	/* Adjust colors for contrast and brightness */
 	if (p->backlightstate == 0) {
@@ -307,19 +483,79 @@ glcd_x11_blit(PrivateData *p)
 		x11w_adj_contrast_brightness(&fgc, &bgc, p->contrast, p->brightness);
 	}
 
-	/* Draw each LCD pixel on the X11 window. */
-	for (y = 0; y < p->framebuf.px_height; y++) {
-		for (x = 0; x < p->framebuf.px_width; x++) {
-			if ((fb_get_pixel(&p->framebuf, x, y) ^ ct_data->inverted) == FB_BLACK)
-				x11w_draw_pixel(ct_data, x, y, fgc, bgc);
-			else
-				x11w_draw_pixel(ct_data, x, y, bgc, bgc);
+	/* Colors changed or window was cleared: draw everything */
+	full = ct_data->redraw || (fgc != ct_data->img_fgc) || (bgc != ct_data->img_bgc);
+
+	/* Check if frame buffer has changed. If not there's nothing to do */
+	if (!full && (memcmp(fb->data, ct_data->backingstore, fb->size) == 0))
+		return;
+
+	if (full)
+		x11w_fill_image(ct_data, bgc);
+
+	/*
+	 * Render changed LCD rows into the image. Runs of changed rows are sent
+	 * as one rectangle covering the changed bytes of these rows.
+	 */
+	first = -1;
+	lo = hi = 0;
+	for (y = 0; y <= fb->px_height; y++) {
+		if (y < fb->px_height) {
+			unsigned char *new = fb->data + y * fb->bytesPerLine;
+			unsigned char *old = ct_data->backingstore + y * fb->bytesPerLine;
+			int l = 0, h = fb->bytesPerLine - 1;
+
+			if (full || (memcmp(new, old, fb->bytesPerLine) != 0)) {
+				if (!full) {
+					while (new[l] == old[l])
+						l++;
+					while (new[h] == old[h])
+						h--;
+				}
+				x11w_draw_row(ct_data, fb, y, fgc, bgc);
+
+				if (first < 0) {
+					first = y;
+					lo = l;
+					hi = h;
+				}
+				else {
+					if (l < lo)
+						lo = l;
+					if (h > hi)
+						hi = h;
+				}
+				continue;
+			}
+		}
+
+		/* Row unchanged or end of display: flush pending run */
+		if (first >= 0) {
+			int x1 = lo * 8 * pxlsize;
+			int x2 = (hi + 1) * 8;
+
+			if (x2 > fb->px_width)
+				x2 = fb->px_width;
+			x2 *= pxlsize;
+
+			x11w_put_image(ct_data, x1, first * pxlsize, x2 - x1,
+				       (y - first) * pxlsize);
+			first = -1;
 		}
 	}
 
-	XFlush(ct_data->dp);
-	memcpy(ct_data->backingstore, p->framebuf.data, p->framebuf.size);
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+	/* The image must not be changed before the server has read it */
+	if (ct_data->use_shm)
+		XSync(ct_data->dp, False);
+	else
+#endif
+		XFlush(ct_data->dp);
 
+	memcpy(ct_data->backingstore, fb->data, fb->size);
+	ct_data->img_fgc = fgc;
+	ct_data->img_bgc = bgc;
+	ct_data->redraw = 0;
 }
 
 /**
@@ -332,6 +568,18 @@ glcd_x11_close(PrivateData *p)
 	if (p->ct_data != NULL) {
 		CT_x11_data *ct_data = (CT_x11_data *) p->ct_data;
 
+		if (ct_data->image != NULL) {
+#ifdef HAVE_X11_EXTENSIONS_XSHM_H
+			if (ct_data->use_shm) {
+				XShmDetach(ct_data->dp, &ct_data->shminfo);
+				XDestroyImage(ct_data->image);
+				shmdt(ct_data->shminfo.shmaddr);
+			}
+			else
+#endif
+				XDestroyImage(ct_data->image);
+		}
+
 		if (ct_data->dp != NULL) {
 			XCloseDisplay(ct_data->dp);
 		}
@@ -357,6 +605,13 @@ glcd_x11_pollkeys(PrivateData *p)
 	XEvent ev;
 	KeySym key;
 
+	/* Restore exposed parts of the LCD area from the image */
+	while (XCheckWindowEvent(ct_data->dp, ct_data->w, ExposureMask, &ev)) {
+		if (!ct_data->redraw)
+			x11w_put_image(ct_data, 0, 0, ct_data->image->width,
+				       ct_data->image->height);
+	}
+
 	if (XCheckWindowEvent(ct_data->dp, ct_data->w, KeyPressMask |
 			      KeyReleaseMask | ButtonPressMask | ButtonReleaseMask, &ev) == 0
 	    && XCheckTypedWindowEvent(ct_data->dp, ct_data->w, ClientMessage, &ev) == 0)
@@ -434,6 +689,7 @@ glcd_x11_set_backlight(PrivateData *p, int state)
 		XSetWindowBackground(ct_data->dp, ct_data->w, bgc);
 	}
 
+	/* This clears the LCD area as well, it is drawn again by the next blit */
 	XClearWindow(ct_data->dp, ct_data->w);
-	memset(ct_data->backingstore, 0, p->framebuf.size);
+	ct_data->redraw = 1;
 }
@@ -38,6 +38,7 @@
 #include "glk.h"
 #include "glkproto.h"
 #include "report.h"
+#include "lcd_lib.h"
 #include "adv_bignum.h"
 
 #define GLK_DEFAULT_DEVICE	"/dev/lcd"
@@ -45,6 +46,7 @@
 #define GLK_DEFAULT_CONTRAST	560
 #define GLK_DEFAULT_CELLWIDTH	6
 #define GLK_DEFAULT_CELLHEIGHT	8
+#define GLK_MOVE_COST		4	/* # bytes for the set-cursor command */
 
 
 /** private data for the \c glk driver */
@@ -369,38 +371,25 @@ glk_flush(Driver *drvthis)
 {
   PrivateData *p = drvthis->private_data;
 
-  unsigned char *pf = p->framebuf;
-  unsigned char *qf = p->backingstore;
-  int x, y;
-  unsigned char *ps = NULL;
+  int y, i;
 
   debug(RPT_DEBUG, "flush()");
 
   for (y = 0; y < p->height; ++y) {
-    int xs = -1;  /* XStart not set */
-
-    for (x = 0; x < p->width; ++x) {
-      if ((*qf == *pf) && (xs >= 0)) {
-        /* Write accumulated string */
-        glkputl(p->fd, GLKCommand, 0x79, xs * p->cellwidth + 1, y * p->cellheight, EOF);
-        glkputa(p->fd, x - xs, ps);
-        debug(RPT_DEBUG, "flush: Writing at (%d,%d) for %d", xs, y, x - xs);
-        xs = -1;
-      }
-      else if ((*qf != *pf) && (xs < 0)) {
-        /* Start new string of changes */
-        ps = pf;
-        xs = x;
-      }
-      *qf++ = *pf++;  /* Update p->backingstore from p->framebuf */
-    }
-    if (xs >= 0) {
-      /* Write accumulated line */
-      glkputl(p->fd, GLKCommand, 0x79, xs * p->cellwidth + 1, y * p->cellheight, EOF);
-      glkputa(p->fd, p->width - xs, ps);
-      debug(RPT_DEBUG, "flush: Writing at (%d,%d) for %d", xs, y, p->width - xs);
+    unsigned char *pf = p->framebuf + (y * p->width);
+    unsigned char *qf = p->backingstore + (y * p->width);
+    LibDiffRun runs[LCD_MAX_WIDTH / 2 + 1];
+    int count = lib_diff_row(pf, qf, p->width, GLK_MOVE_COST, runs);
+
+    for (i = 0; i < count; i++) {
+      glkputl(p->fd, GLKCommand, 0x79, runs[i].x * p->cellwidth + 1, y * p->cellheight, EOF);
+      glkputa(p->fd, runs[i].len, pf + runs[i].x);
+      debug(RPT_DEBUG, "flush: Writing at (%d,%d) for %d", runs[i].x, y, runs[i].len);
     }
   }
+
+  /* Update p->backingstore from p->framebuf */
+  memcpy(p->backingstore, p->framebuf, p->width * p->height);
 }
 
 
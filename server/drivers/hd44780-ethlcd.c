@@ -6,6 +6,11 @@
  * and ENC28J60 ethernet controller. The device is connected via ethernet, has
  * its own IP address and is available via TCP protocol. More info at project
  * homepage: http://manio.skyboo.net/ethlcd/
+ *
+ * Every command sent to the device is answered by the device. Without
+ * batching each byte for the display costs a full network round trip. With
+ * batching enabled (option \c EthlcdBatch) the commands of a flush are
+ * collected and sent in a single TCP frame, the answers are read afterwards.
  */
 
 /*-
@@ -29,11 +34,14 @@
 
 
 void ethlcd_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char flags, unsigned char ch);
+void ethlcd_HD44780_flush(PrivateData *p);
 unsigned char ethlcd_HD44780_scankeypad(PrivateData *p);
 void ethlcd_HD44780_backlight(PrivateData *p, unsigned char state);
 void ethlcd_HD44780_close(PrivateData *p);
 
-/* helper function */
+/* helper functions */
+static int ethlcd_connect(PrivateData *p);
+static void ethlcd_reconnect(PrivateData *p);
 static void ethlcd_send_low(PrivateData *p, unsigned char *data, int length);
 
 /* fake pause function (pausing is handled by ethlcd device itself) */
@@ -51,56 +59,45 @@ ethlcd_HD44780_uPause(PrivateData *p, int usecs)
 int
 hd_init_ethlcd(Driver *drvthis)
 {
-	char hostname[256];
-	unsigned long flags = 0;
-	struct timeval tv;
-
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 	HD44780_functions *hd44780_functions = p->hd44780_functions;
 
 	hd44780_functions->senddata = ethlcd_HD44780_senddata;
+	hd44780_functions->flush = ethlcd_HD44780_flush;
 	hd44780_functions->backlight = ethlcd_HD44780_backlight;
 	hd44780_functions->scankeypad = ethlcd_HD44780_scankeypad;
 	hd44780_functions->uPause = ethlcd_HD44780_uPause;
 	hd44780_functions->close = ethlcd_HD44780_close;
 
 	/* reading configuration file */
-	strncpy(hostname, drvthis->config_get_string(drvthis->name, "Device", 0, "ethlcd"), sizeof(hostname));
-	hostname[sizeof(hostname) - 1] = '\0';
-
-	p->sock = sock_connect(hostname, DEFAULT_ETHLCD_PORT);
-	if (p->sock < 0) {
-		report(RPT_ERR, "%s[%s]: Connecting to %s:%d failed",
-			drvthis->name, ETHLCD_DRV_NAME, hostname, DEFAULT_ETHLCD_PORT);
+	p->hostname = strdup(drvthis->config_get_string(drvthis->name, "Device", 0, "ethlcd"));
+	if (p->hostname == NULL) {
+		report(RPT_ERR, "%s[%s]: Unable to allocate memory",
+			drvthis->name, ETHLCD_DRV_NAME);
 		return -1;
 	}
 
-	/* we need to have a blocking read back again: */
-	if (fcntl(p->sock, F_GETFL, &flags) < 0) {
-		report(RPT_ERR, "%s[%s]: Cannot obtain current flags: %s",
-			drvthis->name, ETHLCD_DRV_NAME, strerror(errno));
-		return -1;
-	}
-	flags &= ~O_NONBLOCK;
-	if (fcntl(p->sock, F_SETFL, flags) < 0) {
-		report(RPT_ERR, "%s[%s]: Unable to change socket to O_NONBLOCK: %s",
-			drvthis->name, ETHLCD_DRV_NAME, strerror(errno));
-		return -1;
+	p->batch = drvthis->config_get_int(drvthis->name, "EthlcdBatch", 0, DEFAULT_ETHLCD_BATCH);
+	if ((p->batch < 1) || (p->batch > MAX_ETHLCD_BATCH)) {
+		report(RPT_WARNING, "%s[%s]: EthlcdBatch must be between 1 and %d; using default %d",
+			drvthis->name, ETHLCD_DRV_NAME, MAX_ETHLCD_BATCH, DEFAULT_ETHLCD_BATCH);
+		p->batch = DEFAULT_ETHLCD_BATCH;
 	}
+	p->reconnected = 0;
 
-	/* setting timeouts */
-	tv.tv_sec = ETHLCD_TIMEOUT;
-	tv.tv_usec = 0;
-	if (setsockopt(p->sock, SOL_SOCKET, SO_RCVTIMEO, (void *)&tv, sizeof(struct timeval)) < 0) {
-		report(RPT_ERR, "%s[%s]: Cannot set receive timeout: %s",
-			drvthis->name, ETHLCD_DRV_NAME, strerror(errno));
+	/* each queued command takes two bytes */
+	p->tx_buf.buffer = malloc(2 * p->batch);
+	if (p->tx_buf.buffer == NULL) {
+		report(RPT_ERR, "%s[%s]: Unable to allocate memory",
+			drvthis->name, ETHLCD_DRV_NAME);
 		return -1;
 	}
-	if (setsockopt(p->sock, SOL_SOCKET, SO_SNDTIMEO, (void *)&tv, sizeof(struct timeval)) < 0) {
-		report(RPT_ERR, "%s[%s]: Cannot set send timeout: %s",
-			drvthis->name, ETHLCD_DRV_NAME, strerror(errno));
+	p->tx_buf.type = 0;
+	p->tx_buf.use_count = 0;
+
+	p->sock = ethlcd_connect(p);
+	if (p->sock < 0)
 		return -1;
-	}
 
 	/* Set up two-line, small character (5x8) mode */
 	hd44780_functions->senddata(p, 0, RS_INSTR, FUNCSET | IF_4BIT | TWOLINE | SMALLCHAR);
@@ -112,12 +109,16 @@ hd_init_ethlcd(Driver *drvthis)
 		p->stuckinputs = 0;
 	}
 
+	report(RPT_INFO, "%s[%s]: sending up to %d commands per frame",
+		drvthis->name, ETHLCD_DRV_NAME, p->batch);
+
 	return 0;
 }
 
 
 /**
- * Send data or commands to the display.
+ * Send data or commands to the display. If batching is enabled the command
+ * is queued and sent with the next flush or once the queue is full.
  * \param p          Pointer to driver's private data structure.
  * \param displayID  ID of the display (or 0 for all) to send data to.
  * \param flags      Defines whether to end a command or data.
@@ -126,7 +127,7 @@ hd_init_ethlcd(Driver *drvthis)
 void
 ethlcd_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char flags, unsigned char ch)
 {
-	static unsigned char buff[2];
+	unsigned char *buff = p->tx_buf.buffer + p->tx_buf.use_count;
 
 	if (flags == RS_INSTR)
 		buff[0] = ETHLCD_SEND_INSTR;
@@ -134,7 +135,72 @@ ethlcd_HD44780_senddata(PrivateData *p, unsigned char displayID, unsigned char f
 		buff[0] = ETHLCD_SEND_DATA;
 	buff[1] = ch;
 
-	ethlcd_send_low(p, buff, 2);
+	if (p->batch <= 1) {
+		ethlcd_send_low(p, buff, 2);
+		return;
+	}
+
+	p->tx_buf.use_count += 2;
+	if (p->tx_buf.use_count >= 2 * p->batch)
+		ethlcd_HD44780_flush(p);
+}
+
+
+/**
+ * Send all queued commands to the device in one frame and collect the
+ * answers. If the connection had to be re-established since the last call
+ * the whole display is marked for redraw.
+ * \param p  Pointer to driver's private data structure.
+ *
+ * \todo  This functions makes LCDd exit on fatal error without any clean-up.
+ *        There is currently no way to make LCDd exit cleanly in those cases.
+ */
+void
+ethlcd_HD44780_flush(PrivateData *p)
+{
+	unsigned char reply[MAX_ETHLCD_BATCH];
+	int count = p->tx_buf.use_count / 2;
+	int got, len, i;
+
+	if (count > 0) {
+		p->tx_buf.use_count = 0;
+
+		len = sock_send(p->sock, p->tx_buf.buffer, 2 * count);
+		if (len <= 0) {
+			p->hd44780_functions->drv_report(RPT_WARNING, "%s: Write to socket failed: %s",
+						  ETHLCD_DRV_NAME, strerror(errno));
+			ethlcd_reconnect(p);
+			return;
+		}
+
+		/* The device answers each command with its command byte */
+		for (got = 0; got < count; got += len) {
+			len = sock_recv(p->sock, reply + got, count - got);
+			if (len <= 0) {
+				p->hd44780_functions->drv_report(RPT_WARNING, "%s: Read from socket failed: %s",
+							  ETHLCD_DRV_NAME, (len < 0) ? strerror(errno) : "connection closed");
+				ethlcd_reconnect(p);
+				return;
+			}
+		}
+
+		for (i = 0; i < count; i++) {
+			if (reply[i] != p->tx_buf.buffer[2 * i]) {
+				p->hd44780_functions->drv_report(RPT_CRIT, "%s: Invalid device response (want 0x%02X, got 0x%02X). Exiting",
+							     ETHLCD_DRV_NAME, p->tx_buf.buffer[2 * i], reply[i]);
+				exit(-1);
+			}
+		}
+	}
+
+	if (p->reconnected) {
+		/* Device state is unknown, let the next flush redraw everything */
+		for (i = 0; i < p->width * p->height; i++)
+			p->backingstore[i] = ~p->framebuf[i];
+		for (i = 0; i < NUM_CCs; i++)
+			p->cc[i].clean = 0;
+		p->reconnected = 0;
+	}
 }
 
 
@@ -147,7 +213,9 @@ unsigned char
 ethlcd_HD44780_scankeypad(PrivateData *p)
 {
 	unsigned char readval;
-	static unsigned char buff[2];
+	unsigned char buff[2];
+
+	ethlcd_HD44780_flush(p);
 
 	buff[0] = ETHLCD_GET_BUTTONS;
 
@@ -184,7 +252,9 @@ ethlcd_HD44780_scankeypad(PrivateData *p)
 void
 ethlcd_HD44780_backlight(PrivateData *p, unsigned char state)
 {
-	static unsigned char buff[2];
+	unsigned char buff[2];
+
+	ethlcd_HD44780_flush(p);
 
 	buff[0] = ETHLCD_SET_BACKLIGHT;
 
@@ -207,15 +277,108 @@ ethlcd_HD44780_backlight(PrivateData *p, unsigned char state)
  */
 void
 ethlcd_HD44780_close(PrivateData *p)
+{
+	if (p->sock >= 0) {
+		ethlcd_HD44780_flush(p);
+		sock_close(p->sock);
+	}
+	if (p->tx_buf.buffer != NULL) {
+		free(p->tx_buf.buffer);
+		p->tx_buf.buffer = NULL;
+	}
+	if (p->hostname != NULL) {
+		free(p->hostname);
+		p->hostname = NULL;
+	}
+}
+
+
+/**
+ * Open the TCP connection to the ethlcd device and set it up for blocking
+ * I/O with timeouts.
+ * \param p  Pointer to driver's private data structure.
+ * \return   Socket file descriptor, or -1 on error.
+ */
+static int
+ethlcd_connect(PrivateData *p)
+{
+	unsigned long flags = 0;
+	struct timeval tv;
+	int sock;
+
+	sock = sock_connect(p->hostname, DEFAULT_ETHLCD_PORT);
+	if (sock < 0) {
+		p->hd44780_functions->drv_report(RPT_ERR, "%s: Connecting to %s:%d failed",
+					  ETHLCD_DRV_NAME, p->hostname, DEFAULT_ETHLCD_PORT);
+		return -1;
+	}
+
+	/* we need to have a blocking read back again: */
+	if (fcntl(sock, F_GETFL, &flags) < 0) {
+		p->hd44780_functions->drv_report(RPT_ERR, "%s: Cannot obtain current flags: %s",
+					  ETHLCD_DRV_NAME, strerror(errno));
+		sock_close(sock);
+		return -1;
+	}
+	flags &= ~O_NONBLOCK;
+	if (fcntl(sock, F_SETFL, flags) < 0) {
+		p->hd44780_functions->drv_report(RPT_ERR, "%s: Unable to change socket to O_NONBLOCK: %s",
+					  ETHLCD_DRV_NAME, strerror(errno));
+		sock_close(sock);
+		return -1;
+	}
+
+	/* setting timeouts */
+	tv.tv_sec = ETHLCD_TIMEOUT;
+	tv.tv_usec = 0;
+	if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (void *)&tv, sizeof(struct timeval)) < 0) {
+		p->hd44780_functions->drv_report(RPT_ERR, "%s: Cannot set receive timeout: %s",
+					  ETHLCD_DRV_NAME, strerror(errno));
+		sock_close(sock);
+		return -1;
+	}
+	if (setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (void *)&tv, sizeof(struct timeval)) < 0) {
+		p->hd44780_functions->drv_report(RPT_ERR, "%s: Cannot set send timeout: %s",
+					  ETHLCD_DRV_NAME, strerror(errno));
+		sock_close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+
+/**
+ * Re-establish a lost connection to the device. Queued commands are
+ * dropped; the display is redrawn by the next flush instead.
+ * \param p  Pointer to driver's private data structure.
+ *
+ * \todo  This functions makes LCDd exit on fatal error without any clean-up.
+ *        There is currently no way to make LCDd exit cleanly in those cases.
+ */
+static void
+ethlcd_reconnect(PrivateData *p)
 {
 	sock_close(p->sock);
+	p->tx_buf.use_count = 0;
+
+	p->sock = ethlcd_connect(p);
+	if (p->sock < 0) {
+		p->hd44780_functions->drv_report(RPT_CRIT, "%s: Reconnect failed. Exiting",
+					  ETHLCD_DRV_NAME);
+		exit(-1);
+	}
+	p->hd44780_functions->drv_report(RPT_NOTICE, "%s: Reconnected to %s",
+				  ETHLCD_DRV_NAME, p->hostname);
+	p->reconnected = 1;
 }
 
 
 /**
- * Send the data to ethlcd device.
+ * Send a single command to ethlcd device and wait for its answer. If the
+ * connection is lost it is re-established once and the command repeated.
  * \param p       Pointer to driver's private data structure.
- * \param data    Pointer to buffer with data to send.
+ * \param data    Pointer to buffer with data to send. Receives the answer.
  * \param length  Number of bytes to send.
  *
  * \todo  This functions makes LCDd exit on fatal error without any clean-up.
@@ -224,17 +387,14 @@ ethlcd_HD44780_close(PrivateData *p)
 static void
 ethlcd_send_low(PrivateData *p, unsigned char *data, int length)
 {
+	unsigned char request[2];
 	int response_len, len;
+	int retry;
 	unsigned char cmd;
 
-	/* Send data to device */
-	cmd = data[0];		/* store command byte for verification */
-	len = sock_send(p->sock, data, length);
-	if (len <= 0) {
-		p->hd44780_functions->drv_report(RPT_CRIT, "%s: Write to socket failed: %s. Exiting",
-					  ETHLCD_DRV_NAME, strerror(errno));
-		exit(-1);
-	}
+	/* keep the request, the answer overwrites data */
+	memcpy(request, data, length);
+	cmd = request[0];	/* store command byte for verification */
 
 	/* Check if this is a command with reply */
 	if (cmd == ETHLCD_GET_BUTTONS)
@@ -242,11 +402,29 @@ ethlcd_send_low(PrivateData *p, unsigned char *data, int length)
 	else
 		response_len = 1;
 
-	/* Wait for reply */
-	len = sock_recv(p->sock, data, response_len);
-	if (len <= 0) {
-		p->hd44780_functions->drv_report(RPT_CRIT, "%s: Read from socket failed: %s. Exiting",
-					  ETHLCD_DRV_NAME, strerror(errno));
+	for (retry = 1; retry >= 0; retry--) {
+		/* Send data to device */
+		len = sock_send(p->sock, request, length);
+		if (len <= 0) {
+			p->hd44780_functions->drv_report(RPT_WARNING, "%s: Write to socket failed: %s",
+						  ETHLCD_DRV_NAME, strerror(errno));
+			ethlcd_reconnect(p);
+			continue;
+		}
+
+		/* Wait for reply */
+		len = sock_recv(p->sock, data, response_len);
+		if (len <= 0) {
+			p->hd44780_functions->drv_report(RPT_WARNING, "%s: Read from socket failed: %s",
+						  ETHLCD_DRV_NAME, (len < 0) ? strerror(errno) : "connection closed");
+			ethlcd_reconnect(p);
+			continue;
+		}
+		break;
+	}
+	if (retry < 0) {
+		p->hd44780_functions->drv_report(RPT_CRIT, "%s: Device does not answer. Exiting",
+					  ETHLCD_DRV_NAME);
 		exit(-1);
 	}
 
@@ -7,6 +7,8 @@ int hd_init_ethlcd(Driver *drvthis);
 #define ETHLCD_DRV_NAME      "ethlcd"
 #define DEFAULT_ETHLCD_PORT  2425
 #define ETHLCD_TIMEOUT       5
+#define DEFAULT_ETHLCD_BATCH 1
+#define MAX_ETHLCD_BATCH     64
 
 /* ethlcd protocol constants: */
 #define ETHLCD_SEND_INSTR               0x01
@@ -25,6 +25,8 @@
 # endif
 #endif
 
+#include "lcd_lib.h"
+
 #ifdef HAVE_LIBFTDI
 # include <ftdi.h>
 #endif
@@ -158,6 +160,9 @@ typedef struct hd44780_private_data {
 
 #ifdef WITH_ETHLCD
 	int sock;		/**< socket for TCP devices */
+	char *hostname;		/**< TCP device host, kept for reconnecting */
+	int batch;		/**< max. number of commands sent in one frame */
+	int reconnected;	/**< connection was re-established, redraw all */
 #endif
 #ifdef WITH_RASPBERRYPI
 	struct rpi_gpio_map *rpi_gpio;	/**< GPIO pin mapping for Raspberry Pi */
@@ -173,6 +178,7 @@ typedef struct hd44780_private_data {
 
 	CGram cc[NUM_CCs];	/**< the custom character cache */
 	CGmode ccmode;		/**< character mode of the current screen */
+	LibCCAlloc cca;		/**< allocates custom characters to bars and icons */
 
 	/* Connection type data */
 	int connectiontype;
@@ -158,6 +158,7 @@ HD44780_init(Driver *drvthis)
 				 * property !!! */
 	p->cellwidth = 5;
 	p->ccmode = standard;
+	lib_cc_init(&p->cca, NUM_CCs, p->cellwidth, p->cellheight);
 	p->backlightstate = -1;	/* Init to invalid value */
 	p->fd = -1;
 
@@ -624,8 +625,6 @@ HD44780_position(Driver *drvthis, int x, int y)
 	}
 	p->hd44780_functions->senddata(p, dispID, RS_INSTR, POSITION | DDaddr);
 	p->hd44780_functions->uPause(p, 40);  /* Minimum exec time for all commands */
-	if (p->hd44780_functions->flush != NULL)
-		p->hd44780_functions->flush(p);
 }
 
 
@@ -740,6 +739,7 @@ HD44780_clear(Driver *drvthis)
 
 	memset(p->framebuf, ' ', p->width * p->height);
 	p->ccmode = standard;
+	lib_cc_frame(&p->cca);
 }
 
 
@@ -917,28 +917,14 @@ HD44780_vbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 
-	if (p->ccmode != vbar) {
-		unsigned char vBar[p->cellheight];
-		int i;
-
-		if (p->ccmode != standard) {
-			/* Not supported(yet) */
-			report(RPT_WARNING, "%s: vbar: cannot combine two modes using user-defined characters",
-				drvthis->name);
-			return;
-		}
-		p->ccmode = vbar;
-
-		memset(vBar, 0x00, sizeof(vBar));
-
-		for (i = 1; i < p->cellheight; i++) {
-			/* add pixel line per pixel line ... */
-			vBar[p->cellheight - i] = 0xFF;
-			HD44780_set_char(drvthis, i, vBar);
-		}
+	if (p->ccmode == bignum) {
+		/* Not supported(yet) */
+		report(RPT_WARNING, "%s: vbar: cannot combine two modes using user-defined characters",
+			drvthis->name);
+		return;
 	}
 
-	lib_vbar_static(drvthis, x, y, len, promille, options, p->cellheight, 0);
+	lib_vbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellheight);
 }
 
 
@@ -956,27 +942,14 @@ HD44780_hbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
 
-	if (p->ccmode != hbar) {
-		unsigned char hBar[p->cellheight];
-		int i;
-
-		if (p->ccmode != standard) {
-			/* Not supported(yet) */
-			report(RPT_WARNING, "%s: hbar: cannot combine two modes using user-defined characters",
-			      drvthis->name);
-			return;
-		}
-
-		p->ccmode = hbar;
-
-		for (i = 1; i <= p->cellwidth; i++) {
-			/* fill pixel columns from left to right. */
-			memset(hBar, 0xFF & ~((1 << (p->cellwidth - i)) - 1), sizeof(hBar));
-			HD44780_set_char(drvthis, i, hBar);
-		}
+	if (p->ccmode == bignum) {
+		/* Not supported(yet) */
+		report(RPT_WARNING, "%s: hbar: cannot combine two modes using user-defined characters",
+		      drvthis->name);
+		return;
 	}
 
-	lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+	lib_hbar_cc(drvthis, &p->cca, x, y, len, promille, options, p->cellwidth);
 }
 
 
@@ -996,14 +969,16 @@ HD44780_num(Driver *drvthis, int x, int num)
 		return;
 
 	if (p->ccmode != bignum) {
-		if (p->ccmode != standard) {
+		if (lib_cc_in_use(&p->cca) > 0) {
 			/* Not supported (yet) */
 			report(RPT_WARNING, "%s: num: cannot combine two modes using user-defined characters",
 					drvthis->name);
 			return;
 		}
 
+		/* Big numbers define the custom characters by themselves */
 		p->ccmode = bignum;
+		lib_cc_reset(&p->cca);
 
 		do_init = 1;
 	}
@@ -1072,6 +1047,8 @@ MODULE_EXPORT int
 HD44780_icon(Driver *drvthis, int x, int y, int icon)
 {
 	PrivateData *p = (PrivateData *) drvthis->private_data;
+	unsigned char *bitmap;
+	int n;
 
 	static unsigned char heart_open[] =
 		{ b__XXXXX,
@@ -1156,72 +1133,46 @@ HD44780_icon(Driver *drvthis, int x, int y, int icon)
 		return 0;
 	}
 
-	/* The full block works except if ccmode=bignum */
-	if (icon == ICON_BLOCK_FILLED) {
-		if (p->ccmode != bignum) {
-			HD44780_set_char(drvthis, 0, block_filled);
-			HD44780_chr(drvthis, x, y, 0);
-			return 0;
-		}
-		else {
-			return -1;
-		}
-	}
-
-	/* The heartbeat icons do not work in bignum and vbar mode */
-	if ((icon == ICON_HEART_FILLED) || (icon == ICON_HEART_OPEN)) {
-		if ((p->ccmode != bignum) && (p->ccmode != vbar)) {
-			switch (icon) {
-			    case ICON_HEART_FILLED:
-				HD44780_set_char(drvthis, 7, heart_filled);
-				HD44780_chr(drvthis, x, y, 7);
-				return 0;
-			    case ICON_HEART_OPEN:
-				HD44780_set_char(drvthis, 7, heart_open);
-				HD44780_chr(drvthis, x, y, 7);
-				return 0;
-			}
-		}
-		else {
-			return -1;
-		}
-	}
-
-	/* All other icons work only in the standard or icon ccmode */
-	if (p->ccmode != icons) {
-		if (p->ccmode != standard) {
-			/* Not supported (yet) */
-			report(RPT_WARNING, "%s: num: cannot combine two modes using user-defined characters",
-					drvthis->name);
-			return -1;
-		}
-		p->ccmode = icons;
-	}
+	/* Other icons need custom characters, which big numbers use up */
+	if (p->ccmode == bignum)
+		return -1;
 
 	switch (icon) {
+		case ICON_BLOCK_FILLED:
+			bitmap = block_filled;
+			break;
+		case ICON_HEART_FILLED:
+			bitmap = heart_filled;
+			break;
+		case ICON_HEART_OPEN:
+			bitmap = heart_open;
+			break;
 		case ICON_ARROW_UP:
-			HD44780_set_char(drvthis, 1, arrow_up);
-			HD44780_chr(drvthis, x, y, 1);
+			bitmap = arrow_up;
 			break;
 		case ICON_ARROW_DOWN:
-			HD44780_set_char(drvthis, 2, arrow_down);
-			HD44780_chr(drvthis, x, y, 2);
+			bitmap = arrow_down;
 			break;
 		case ICON_CHECKBOX_OFF:
-			HD44780_set_char(drvthis, 3, checkbox_off);
-			HD44780_chr(drvthis, x, y, 3);
+			bitmap = checkbox_off;
 			break;
 		case ICON_CHECKBOX_ON:
-			HD44780_set_char(drvthis, 4, checkbox_on);
-			HD44780_chr(drvthis, x, y, 4);
+			bitmap = checkbox_on;
 			break;
 		case ICON_CHECKBOX_GRAY:
-			HD44780_set_char(drvthis, 5, checkbox_gray);
-			HD44780_chr(drvthis, x, y, 5);
+			bitmap = checkbox_gray;
 			break;
 		default:
 			return -1;	/* Let the core do other icons */
 	}
+
+	/* Let the core draw a substitute if all custom characters are in use */
+	n = lib_cc_get(&p->cca, bitmap);
+	if (n < 0)
+		return -1;
+
+	HD44780_set_char(drvthis, n, bitmap);
+	HD44780_chr(drvthis, x, y, n);
 	return 0;
 }
 
@@ -120,6 +120,9 @@ joy_init (Driver *drvthis)
 	ioctl(p->fd, JSIOCGBUTTONS, &p->buttons);
 	ioctl(p->fd, JSIOCGNAME(JOY_NAMELENGTH), p->jsname);
 
+	/* Only get called when there are joystick events */
+	drvthis->register_input_fd(drvthis, p->fd);
+
 	report(RPT_NOTICE, "%s: Joystick (%s) has %d axes and %d buttons. Driver version is %d.%d.%d",
 		drvthis->name, p->jsname, p->axes, p->buttons,
 		p->jsversion >> 16, (p->jsversion >> 8) & 0xff, p->jsversion & 0xff);
@@ -217,6 +220,11 @@ joy_get_key (Driver *drvthis)
 	int err;
 
 	if ((err = read(p->fd, &js, sizeof(struct js_event))) <= 0) {
+		/* The device stays readable once it is gone, fall back to polling */
+		if ((err < 0) && (errno != EAGAIN)
+		    && (drvthis->unregister_input_fd(drvthis, p->fd) == 0))
+			report(RPT_ERR, "%s: error reading joystick: %s",
+			       drvthis->name, strerror(errno));
 		return NULL;
 	}
 	if (err != sizeof(struct js_event)) {
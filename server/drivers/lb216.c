@@ -44,6 +44,7 @@ typedef struct LB216_private_data {
 	int speed;
 	int fd;
 	char *framebuf;
+	LibSerialBuffer *sb;
 	int width;
 	int height;
 	int cellwidth;
@@ -86,6 +87,7 @@ LB216_init(Driver *drvthis)
   p->speed = LB216_DEFAULT_SPEED;
   p->fd = -1;
   p->framebuf = NULL;
+  p->sb = NULL;
   p->width = LCD_DEFAULT_WIDTH;
   p->height = LCD_DEFAULT_HEIGHT;
   p->cellwidth = LCD_DEFAULT_CELLWIDTH;
@@ -163,6 +165,13 @@ LB216_init(Driver *drvthis)
   }
   memset(p->framebuf, ' ', p->width * p->height);
 
+  // ... and the output buffer used for flushing
+  p->sb = lib_serbuf_new(p->fd, p->width * p->height + 2 * (p->height + 1), 0);
+  if (p->sb == NULL) {
+     report(RPT_ERR, "%s: unable to create output buffer", drvthis->name);
+     return -1;
+  }
+
   // Set display-specific stuff..
   if (reboot) {
     report(RPT_INFO, "%s: rebooting LCD...", drvthis->name);
@@ -196,6 +205,8 @@ LB216_close(Driver *drvthis)
     if (p->framebuf)
       free(p->framebuf);
 
+    lib_serbuf_free(p->sb);
+
     free(p);
   }
   drvthis->store_private_ptr(drvthis, NULL);
@@ -267,21 +278,21 @@ LB216_flush(Driver *drvthis)
 {
   PrivateData *p = drvthis->private_data;
   char out[LCD_MAX_WIDTH * LCD_MAX_HEIGHT];
-  int i, j;
+  int j;
 
   snprintf(out, sizeof(out), "%c%c", 254, 80);
-  write(p->fd, out, 2);
+  lib_serbuf_write(p->sb, out, 2);
 
   for (j = 0; j < p->height; j++) {
     if (j >= 2)
       snprintf(out, sizeof(out), "%c%c", 254, 148 + (64 * (j - 2)));
     else
       snprintf(out, sizeof(out), "%c%c", 254, 128 + (64 * j));
-    write(p->fd, out, 2);
+    lib_serbuf_write(p->sb, out, 2);
 
-    for (i = 0; i < p->width; i++)
-      write(p->fd, &p->framebuf[i + (j * p->width)], 1);
+    lib_serbuf_write(p->sb, &p->framebuf[j * p->width], p->width);
   }
+  lib_serbuf_flush(p->sb);
 }
 
 
@@ -419,7 +430,7 @@ LB216_hbar(Driver *drvthis, int x, int y, int len, int promille, int options)
         LB216_set_char(drvthis, i + 1, hbar_char[i]);
     p->custom = hbar;
   }
-  lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+  lib_hbar_string(drvthis, x, y, len, promille, options, p->cellwidth, 0, 0xFF);
 }
 
 
@@ -41,6 +41,9 @@
 #define LCD_DEFAULT_CELLWIDTH 5
 #define LCD_DEFAULT_CELLHEIGHT 8
 
+/* Maximum number of input file descriptors per driver */
+#define MAX_INPUT_FDS 4
+
 /* Backlight data */
 #define BACKLIGHT_OFF 0
 #define BACKLIGHT_ON  1
@@ -214,6 +217,20 @@ typedef struct lcd_logical_driver {
 	int (*request_display_width) ();
 	int (*request_display_height) ();
 
+	/* Input event function (for input drivers that have a file descriptor) */
+	int (*register_input_fd) (struct lcd_logical_driver *driver, int fd);
+	int (*unregister_input_fd) (struct lcd_logical_driver *driver, int fd);
+	/* Tell the server that get_key only needs to be called when fd is
+	 * readable. A driver reading input in its own thread can register the
+	 * read end of a pipe that it writes to. Unregister an fd that stays
+	 * readable because of an error. */
+
+	/******** Variables in server core, not for use by drivers ********/
+
+	int input_fds[MAX_INPUT_FDS];	/* Registered by register_input_fd() */
+	int num_input_fds;
+	int input_pending;		/* An input fd was readable, get_key has not returned NULL since */
+
 } Driver;
 
 #endif
@@ -8,7 +8,15 @@
  *       the height of hbars, etc.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+
 #include "lcd.h"
+#include "lcd_lib.h"
 
 #ifdef HAVE_CONFIG_H
 # include "config.h"
@@ -83,3 +91,485 @@ lib_vbar_static (Driver *drvthis, int x, int y, int len, int promille, int optio
 		}
 	}
 }
+
+/**
+ * This function places a hbar using the v0.5 API format like
+ * lib_hbar_static(), but builds the whole bar as one string and writes it
+ * with a single call of the driver's string() function. The driver's full
+ * block character is passed in \c block, so this is for drivers that show
+ * the full block icon with a fixed character code and whose string()
+ * treats all codes like chr() does.
+ *
+ * Neither \c block nor any custom char (cc_offset + 1 ...) may be 0, as
+ * that would terminate the string.
+ */
+void
+lib_hbar_string (Driver *drvthis, int x, int y, int len, int promille, int options, int cellwidth, int cc_offset, int block)
+{
+	int total_pixels  = ((long) 2 * len * cellwidth + 1 ) * promille / 2000;
+	char bar[(len > 0) ? len + 1 : 1];
+	int pos;
+
+#if defined(SEAMLESS_HBARS)
+	block = cellwidth + cc_offset;
+#endif
+
+	for (pos = 0; pos < len; pos ++ ) {
+
+		int pixels = total_pixels - cellwidth * pos;
+
+		if ( pixels >= cellwidth ) {
+			/* a "full" block... */
+			bar[pos] = block;
+		}
+		else if ( pixels > 0 ) {
+			/* a partial block ends the bar */
+			bar[pos++] = pixels + cc_offset;
+			break;
+		}
+		else {
+			break; /* write nothing (not even a space) */
+		}
+	}
+	bar[pos] = '\0';
+
+	if (pos > 0)
+		drvthis->string (drvthis, x, y, bar);
+}
+
+/**
+ * Initialize a custom character allocator. All slots start empty.
+ * \param cca         Allocator to initialize.
+ * \param num         Number of custom characters of the display
+ *                    (at most LIB_CC_MAX).
+ * \param cellwidth   Number of pixels per row (at most 8).
+ * \param cellheight  Number of pixel rows per character
+ *                    (at most LIB_CC_MAX_HEIGHT).
+ */
+void
+lib_cc_init (LibCCAlloc *cca, int num, int cellwidth, int cellheight)
+{
+	memset(cca, 0, sizeof(LibCCAlloc));
+	cca->num = (num > LIB_CC_MAX) ? LIB_CC_MAX : num;
+	cca->cellwidth = cellwidth;
+	cca->cellheight = (cellheight > LIB_CC_MAX_HEIGHT) ? LIB_CC_MAX_HEIGHT : cellheight;
+	cca->frame = 1;
+}
+
+/**
+ * Start a new frame. Glyphs used by the previous frame may be replaced from
+ * now on. Drivers call this from their clear() function.
+ * \param cca  Custom character allocator.
+ */
+void
+lib_cc_frame (LibCCAlloc *cca)
+{
+	cca->frame++;
+}
+
+/**
+ * Forget all glyphs, e.g. because another user (like big numbers) has
+ * reprogrammed the custom characters without the allocator.
+ * \param cca  Custom character allocator.
+ */
+void
+lib_cc_reset (LibCCAlloc *cca)
+{
+	int i;
+
+	for (i = 0; i < cca->num; i++)
+		cca->slot[i].last_used = 0;
+}
+
+/**
+ * Count the slots used by the current frame.
+ * \param cca  Custom character allocator.
+ * \return  Number of slots handed out since the last lib_cc_frame().
+ */
+int
+lib_cc_in_use (LibCCAlloc *cca)
+{
+	int i, count = 0;
+
+	for (i = 0; i < cca->num; i++) {
+		if (cca->slot[i].last_used == cca->frame)
+			count++;
+	}
+	return count;
+}
+
+/**
+ * Get a custom character showing \c bitmap. If a slot already holds the
+ * glyph it is reused, otherwise an empty or the least recently used slot
+ * is assigned. Slots used in the current frame are never replaced.
+ *
+ * The caller has to define the character with its set_char() function
+ * afterwards, which should only send it to the display if it changed.
+ *
+ * \param cca     Custom character allocator.
+ * \param bitmap  Pixel rows of the glyph (\c cellheight bytes).
+ * \return  Number of the custom character, -1 if all are in use. In that
+ *          case the caller should fall back to a substitute.
+ */
+int
+lib_cc_get (LibCCAlloc *cca, const unsigned char *bitmap)
+{
+	unsigned int hash = 2166136261U;	/* FNV-1a */
+	int victim = -1;
+	int i;
+
+	for (i = 0; i < cca->cellheight; i++)
+		hash = (hash ^ bitmap[i]) * 16777619U;
+
+	for (i = 0; i < cca->num; i++) {
+		LibCCSlot *slot = &cca->slot[i];
+
+		if ((slot->last_used != 0) && (slot->hash == hash)
+		    && (memcmp(slot->bitmap, bitmap, cca->cellheight) == 0)) {
+			slot->last_used = cca->frame;
+			return i;
+		}
+		/* empty slots have last_used 0 and thus are taken first */
+		if ((slot->last_used != cca->frame)
+		    && ((victim < 0) || (slot->last_used < cca->slot[victim].last_used)))
+			victim = i;
+	}
+
+	if (victim < 0) {
+		cca->fallbacks++;
+		return -1;
+	}
+
+	memcpy(cca->slot[victim].bitmap, bitmap, cca->cellheight);
+	cca->slot[victim].hash = hash;
+	cca->slot[victim].last_used = cca->frame;
+	return victim;
+}
+
+/**
+ * Get a custom character from the allocator and define it.
+ * \return  Number of the custom character, -1 if none was available.
+ */
+static int
+lib_cc_define (Driver *drvthis, LibCCAlloc *cca, unsigned char *bitmap)
+{
+	int n = lib_cc_get(cca, bitmap);
+
+	if (n >= 0)
+		drvthis->set_char(drvthis, n, bitmap);
+	return n;
+}
+
+/**
+ * Get the custom character of a full block (all pixels set).
+ * \return  Number of the custom character, -1 if none was available.
+ */
+static int
+lib_cc_block (Driver *drvthis, LibCCAlloc *cca)
+{
+	unsigned char block[LIB_CC_MAX_HEIGHT];
+
+	memset(block, (1 << cca->cellwidth) - 1, sizeof(block));
+	return lib_cc_define(drvthis, cca, block);
+}
+
+/**
+ * This function places a hbar using the v0.5 API format. Full and partial
+ * blocks are taken from the custom character allocator, so bars can be
+ * combined with icons and other bars on the same screen. The bar is written
+ * with one call of the driver's string() function if possible. If no custom
+ * character is left, full blocks are shown as '#' and a partial block as '-'.
+ *
+ * The driver's custom characters 0 .. num-1 must be shown by the
+ * corresponding character codes.
+ */
+void
+lib_hbar_cc (Driver *drvthis, LibCCAlloc *cca, int x, int y, int len, int promille, int options, int cellwidth)
+{
+	int total_pixels  = ((long) 2 * len * cellwidth + 1 ) * promille / 2000;
+	int full = total_pixels / cellwidth;
+	int pixels = total_pixels % cellwidth;
+	int block = -1, partial = -1;
+	char bar[(len > 0) ? len + 1 : 1];
+	int pos, n = 0;
+
+	if (len <= 0)
+		return;
+	if (full > len) {
+		full = len;
+		pixels = 0;
+	}
+
+	if (full > 0)
+		block = lib_cc_block(drvthis, cca);
+	if (pixels > 0) {
+		/* fill pixel columns from the left */
+		unsigned char glyph[LIB_CC_MAX_HEIGHT];
+
+		memset(glyph, ((1 << cellwidth) - 1) & ~((1 << (cellwidth - pixels)) - 1), sizeof(glyph));
+		partial = lib_cc_define(drvthis, cca, glyph);
+	}
+
+	for (pos = 0; pos < full; pos++)
+		bar[n++] = (block < 0) ? '#' : block;
+	if (pixels > 0)
+		bar[n++] = (partial < 0) ? '-' : partial;
+	bar[n] = '\0';
+
+	/* custom character 0 cannot be part of a string */
+	if ((block != 0) && (partial != 0)) {
+		if (n > 0)
+			drvthis->string(drvthis, x, y, bar);
+	}
+	else {
+		for (pos = 0; pos < n; pos++)
+			drvthis->chr(drvthis, x + pos, y, bar[pos]);
+	}
+}
+
+/**
+ * This function places a vbar using the v0.5 API format. Full and partial
+ * blocks are taken from the custom character allocator, see lib_hbar_cc().
+ * If no custom character is left, full blocks are shown as '#' and a partial
+ * block as '|'.
+ */
+void
+lib_vbar_cc (Driver *drvthis, LibCCAlloc *cca, int x, int y, int len, int promille, int options, int cellheight)
+{
+	int total_pixels = ((long) 2 * len * cellheight + 1 ) * promille / 2000;
+	int block = -1;
+	int pos;
+
+	for (pos = 0; pos < len; pos ++ ) {
+
+		int pixels = total_pixels - cellheight * pos;
+
+		if ( pixels >= cellheight ) {
+			/* write a "full" block to the screen... */
+			if (pos == 0)
+				block = lib_cc_block(drvthis, cca);
+			drvthis->chr (drvthis, x, y-pos, (block < 0) ? '#' : block);
+		}
+		else if ( pixels > 0 ) {
+			/* write a partial block: fill pixel rows from the bottom */
+			unsigned char glyph[LIB_CC_MAX_HEIGHT];
+			int n;
+
+			memset(glyph, 0x00, sizeof(glyph));
+			memset(glyph + cellheight - pixels, (1 << cca->cellwidth) - 1, pixels);
+			n = lib_cc_define(drvthis, cca, glyph);
+			drvthis->chr (drvthis, x, y-pos, (n < 0) ? '|' : n);
+			break;
+		}
+		else {
+			; /* write nothing (not even a space) */
+		}
+	}
+}
+
+/**
+ * Compare one row of the frame buffer with the backing store and compute the
+ * spans of cells that need to be sent to the display.
+ *
+ * Unchanged leading and trailing cells are skipped. Two changed spans are
+ * merged into one if the unchanged gap between them is shorter than
+ * \c move_cost, i.e. if re-sending the gap is cheaper than positioning the
+ * cursor again.
+ *
+ * \param frame      Start of the row in the frame buffer.
+ * \param backing    Start of the row in the backing store.
+ * \param width      Number of cells in the row.
+ * \param move_cost  Cost of a cursor positioning command in cells (bytes).
+ * \param runs       Array receiving the spans; must have room for at
+ *                   least (width + 1) / 2 entries.
+ * \return  Number of spans stored in \c runs (0 if the row is unchanged).
+ */
+int
+lib_diff_row (const unsigned char *frame, const unsigned char *backing, int width, int move_cost, LibDiffRun *runs)
+{
+	int count = 0;
+	int x = 0;
+
+	while (x < width) {
+		int start, end;
+
+		/* skip over identical cells */
+		while ((x < width) && (frame[x] == backing[x]))
+			x++;
+		if (x >= width)
+			break;
+
+		/* collect changed cells */
+		start = x;
+		while ((x < width) && (frame[x] != backing[x]))
+			x++;
+		end = x;
+
+		/* merge with previous span if the gap is cheaper than a goto */
+		if ((count > 0) && (start - (runs[count-1].x + runs[count-1].len) < move_cost)) {
+			runs[count-1].len = end - runs[count-1].x;
+		}
+		else {
+			runs[count].x = start;
+			runs[count].len = end - start;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+
+/** Number of times lib_serbuf_flush() waits for a busy device before giving up. */
+#define SERBUF_RETRIES		10
+/** Time in ms to wait for a busy device to accept more data. */
+#define SERBUF_WAIT		100
+
+/**
+ * Create an output buffer for a serial device.
+ *
+ * Drivers append everything they want to send during a flush with
+ * lib_serbuf_write() and hand it to the device with a single write()
+ * in lib_serbuf_flush().
+ *
+ * Displays with a small input buffer may set \c chunk: the data is then
+ * written in pieces of at most \c chunk bytes and tcdrain() is called
+ * between the pieces, pacing the output to the configured baud rate.
+ *
+ * \param fd     File descriptor of the (already opened) device.
+ * \param size   Initial buffer size; the buffer grows when needed.
+ * \param chunk  Max. number of bytes per write(), 0 for no limit.
+ * \return  Pointer to the new buffer, or NULL on error.
+ */
+LibSerialBuffer *
+lib_serbuf_new (int fd, int size, int chunk)
+{
+	LibSerialBuffer *sb;
+
+	if (size <= 0)
+		return NULL;
+
+	sb = (LibSerialBuffer *) calloc(1, sizeof(LibSerialBuffer));
+	if (sb == NULL)
+		return NULL;
+
+	sb->data = (unsigned char *) malloc(size);
+	if (sb->data == NULL) {
+		free(sb);
+		return NULL;
+	}
+	sb->fd = fd;
+	sb->size = size;
+	sb->chunk = (chunk > 0) ? chunk : 0;
+
+	return sb;
+}
+
+
+/**
+ * Free an output buffer. Data not yet flushed is discarded.
+ * \param sb  Buffer to free (may be NULL).
+ */
+void
+lib_serbuf_free (LibSerialBuffer *sb)
+{
+	if (sb != NULL) {
+		free(sb->data);
+		free(sb);
+	}
+}
+
+
+/**
+ * Append data to the output buffer.
+ * \param sb    Output buffer.
+ * \param data  Bytes to append.
+ * \param len   Number of bytes to append.
+ * \return  Number of bytes appended, -1 if out of memory.
+ */
+int
+lib_serbuf_write (LibSerialBuffer *sb, const void *data, int len)
+{
+	if (len <= 0)
+		return 0;
+
+	if (sb->used + len > sb->size) {
+		int size = sb->size;
+		unsigned char *tmp;
+
+		while (sb->used + len > size)
+			size *= 2;
+		tmp = (unsigned char *) realloc(sb->data, size);
+		if (tmp == NULL)
+			return -1;
+		sb->data = tmp;
+		sb->size = size;
+	}
+
+	memcpy(sb->data + sb->used, data, len);
+	sb->used += len;
+
+	return len;
+}
+
+
+/**
+ * Send the buffered data to the device and empty the buffer.
+ *
+ * Partial writes are continued; if the device does not accept data
+ * (non-blocking descriptor) we wait for it to become writable a few times
+ * before giving up and dropping the rest of the frame.
+ *
+ * \param sb  Output buffer.
+ * \return  Number of bytes sent, -1 on error.
+ */
+int
+lib_serbuf_flush (LibSerialBuffer *sb)
+{
+	int done = 0;
+	int retries = SERBUF_RETRIES;
+
+	if (sb->used == 0) {
+		sb->frame_bytes = 0;
+		return 0;
+	}
+
+	while (done < sb->used) {
+		int len = sb->used - done;
+		int rc;
+
+		if ((sb->chunk > 0) && (len > sb->chunk))
+			len = sb->chunk;
+
+		rc = write(sb->fd, sb->data + done, len);
+		if (rc > 0) {
+			done += rc;
+			/* give displays with small buffers time to catch up */
+			if ((sb->chunk > 0) && (done < sb->used))
+				tcdrain(sb->fd);
+		}
+		else if ((rc < 0) && (errno == EINTR)) {
+			continue;
+		}
+		else if ((rc == 0) || (errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+			struct pollfd pfd;
+
+			if (--retries <= 0)
+				break;
+			pfd.fd = sb->fd;
+			pfd.events = POLLOUT;
+			pfd.revents = 0;
+			poll(&pfd, 1, SERBUF_WAIT);
+		}
+		else {
+			break;
+		}
+	}
+
+	sb->used = 0;
+	sb->frame_bytes = done;
+	sb->bytes += done;
+	sb->frames++;
+
+	return (done > 0) ? done : -1;
+}
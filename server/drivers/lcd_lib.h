@@ -5,8 +5,71 @@
 #include "lcd.h"
 #endif
 
+/** A span of cells that has to be (re)sent to the display, see lib_diff_row(). */
+typedef struct lib_diff_run {
+	int x;		/**< First column of the span (0-based). */
+	int len;	/**< Number of cells in the span. */
+} LibDiffRun;
+
+/** Output buffer that collects the bytes of a frame for a serial device. */
+typedef struct lib_serial_buffer {
+	int fd;			/**< File descriptor of the serial device. */
+	unsigned char *data;	/**< Buffer memory. */
+	int size;		/**< Allocated size of \c data. */
+	int used;		/**< Number of bytes waiting in \c data. */
+	int chunk;		/**< Max. bytes per write() before waiting for
+				 *   the UART to drain (0 = no limit). */
+	unsigned long frames;	/**< Number of flushes that sent data. */
+	unsigned long bytes;	/**< Total number of bytes sent. */
+	int frame_bytes;	/**< Number of bytes sent by the last flush. */
+} LibSerialBuffer;
+
+/** Maximum number of custom characters handled by a LibCCAlloc. */
+#define LIB_CC_MAX		16
+/** Maximum character cell height handled by a LibCCAlloc. */
+#define LIB_CC_MAX_HEIGHT	16
+
+/** One custom character slot of a LibCCAlloc. */
+typedef struct lib_cc_slot {
+	unsigned char bitmap[LIB_CC_MAX_HEIGHT];	/**< Pixel rows of the glyph. */
+	unsigned int hash;		/**< Hash of \c bitmap. */
+	unsigned long last_used;	/**< Frame the slot was last used in
+					 *   (0 = slot is empty). */
+} LibCCSlot;
+
+/**
+ * Allocator for the custom characters (CGRAM) of a display, shared by bars,
+ * icons and other users. Identical glyphs share one slot; if all slots are
+ * taken, the least recently used slot not needed by the current frame is
+ * replaced.
+ */
+typedef struct lib_cc_alloc {
+	int num;		/**< Number of custom characters of the display. */
+	int cellwidth;		/**< Number of pixels per row. */
+	int cellheight;		/**< Number of pixel rows per character. */
+	unsigned long frame;	/**< Number of the current frame. */
+	unsigned long fallbacks;	/**< Requests that could not be served. */
+	LibCCSlot slot[LIB_CC_MAX];	/**< The custom character slots. */
+} LibCCAlloc;
+
 void lib_hbar_static (Driver *drvthis, int x, int y, int len, int promille, int options, int cellwidth, int cc_offset);
 void lib_vbar_static (Driver *drvthis, int x, int y, int len, int promille, int options, int cellheight, int cc_offset);
+void lib_hbar_string (Driver *drvthis, int x, int y, int len, int promille, int options, int cellwidth, int cc_offset, int block);
+
+void lib_cc_init (LibCCAlloc *cca, int num, int cellwidth, int cellheight);
+void lib_cc_frame (LibCCAlloc *cca);
+void lib_cc_reset (LibCCAlloc *cca);
+int lib_cc_in_use (LibCCAlloc *cca);
+int lib_cc_get (LibCCAlloc *cca, const unsigned char *bitmap);
+void lib_hbar_cc (Driver *drvthis, LibCCAlloc *cca, int x, int y, int len, int promille, int options, int cellwidth);
+void lib_vbar_cc (Driver *drvthis, LibCCAlloc *cca, int x, int y, int len, int promille, int options, int cellheight);
+
+int lib_diff_row (const unsigned char *frame, const unsigned char *backing, int width, int move_cost, LibDiffRun *runs);
+
+LibSerialBuffer *lib_serbuf_new (int fd, int size, int chunk);
+void lib_serbuf_free (LibSerialBuffer *sb);
+int lib_serbuf_write (LibSerialBuffer *sb, const void *data, int len);
+int lib_serbuf_flush (LibSerialBuffer *sb);
 
 #endif
 
@@ -153,6 +153,9 @@ lircin_init (Driver *drvthis)
 		}
 	fcntl (p->lircin_fd, F_SETFD, FD_CLOEXEC);
 
+	/* Only get called when lircd sent something */
+	drvthis->register_input_fd(drvthis, p->lircin_fd);
+
 	report(RPT_DEBUG, "%s: init() done", drvthis->name);
 
 	return 0;
@@ -205,13 +208,20 @@ lircin_get_key (Driver *drvthis)
         PrivateData * p = drvthis->private_data;
 
 	char *code = NULL, *cmd = NULL;
+	int ret = 0;
 
-	if ((lirc_nextcode(&code) == 0) && (code != NULL)) {
+	/* The lirc library buffers codes, try all of them before giving up */
+	while ((cmd == NULL) && ((ret = lirc_nextcode(&code)) == 0) && (code != NULL)) {
 		if ((lirc_code2char(p->lircin_irconfig,code,&cmd)==0) && (cmd!=NULL)) {
 			report(RPT_DEBUG, "%s: \"%s\"", drvthis->name, cmd);
 		}
 		free(code);
+		code = NULL;
 	}
 
+	/* The socket stays readable once lircd is gone, fall back to polling */
+	if ((ret < 0) && (drvthis->unregister_input_fd(drvthis, p->lircin_fd) == 0))
+		report(RPT_ERR, "%s: lost connection to lircd", drvthis->name);
+
 	return cmd;
 }
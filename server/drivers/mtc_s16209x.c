@@ -500,7 +500,7 @@ MTC_S16209X_hbar (Driver *drvthis, int x, int y, int len, int promille, int opti
 
   MTC_S16209X_init_hbar(drvthis);
 
-  lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+  lib_hbar_string(drvthis, x, y, len, promille, options, p->cellwidth, 0, 0xFF);
 }
 
 
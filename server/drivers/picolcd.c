@@ -113,6 +113,28 @@ typedef struct usb_transfer_data {
 	/** data buffer for the USB transfer */
 	unsigned char buffer[PICOLCD_MAX_DATA_LEN];
 }UsbTransferData;
+
+/**
+ * Output to the display is sent using asynchronous transfers, too. They are
+ * queued in a ring and completed by the same event handling that services
+ * input, so a slow USB write never blocks the main loop. A full update of a
+ * 20x4 display including all custom characters takes 24 transfers.
+ */
+#define USB_OUT_BUFFERS 32
+
+/**
+ * This structure holds the data for an output USB transfer.
+ */
+typedef struct usb_output_data {
+	/** structure for the details of the asynchronous USB transfer */
+	struct libusb_transfer *transfer;
+	/** set while the transfer is submitted but not yet completed */
+	int busy;
+	/** Pointer to driver private data */
+	Driver *drvthis;
+	/** data buffer for the USB transfer */
+	unsigned char buffer[PICOLCD_MAX_OUT_LEN];
+}UsbOutputData;
 #endif
 
 /** Private data for the picoLCD driver */
@@ -151,6 +173,9 @@ typedef struct picolcd_private_data {
 	libusb_context *lib_ctx;
 	/* structure for the details of the USB transfer */
 	UsbTransferData input_transfer[USB_BUFFERS];
+	/* ring of output transfers */
+	UsbOutputData output_transfer[USB_OUT_BUFFERS];
+	int output_next;	/* Next output transfer to use */
 	/* buffer for the key press data */
 	keys key_buffer[KEY_BUFFER_SIZE];
 	int key_read_index;	/* Read index in the key_buffer */
@@ -165,18 +190,19 @@ typedef struct picolcd_private_data {
 } PrivateData;
 
 /* Private function definitions */
-static void picolcd_send(USB_DEVICE_HANDLE *lcd, unsigned char *data, int size);
-static void picolcd_20x2_write(USB_DEVICE_HANDLE *lcd, const int row, const int col, const unsigned char *data);
-static void picolcd_20x4_write(USB_DEVICE_HANDLE *lcd, const int row, const int col, const unsigned char *data);
+static void picolcd_send(Driver *drvthis, unsigned char *data, int size);
+static void picolcd_20x2_write(Driver *drvthis, const int row, const int col, const unsigned char *data);
+static void picolcd_20x4_write(Driver *drvthis, const int row, const int col, const unsigned char *data);
 static void picolcd_20x2_set_char(Driver *drvthis, int n, unsigned char *dat);
 static void picolcd_20x4_set_char(Driver *drvthis, int n, unsigned char *dat);
-static void set_key_lights(USB_DEVICE_HANDLE *lcd, int keys[], int state);
+static void set_key_lights(Driver *drvthis, int keys[], int state);
 static void picolcd_lircsend(Driver *drvthis);
 static void ir_transcode(Driver *drvthis, unsigned char *data, unsigned int cbdata);
 #ifdef HAVE_LIBUSB_1_0
 static void free_usb_transfers(Driver *drvthis);
 static void key_buffer_put(Driver *drvthis, unsigned char high_key, unsigned char low_key);
 static void usb_cb_input(struct libusb_transfer *transfer);
+static void usb_cb_output(struct libusb_transfer *transfer);
 #else
 static void get_key_event(USB_DEVICE_HANDLE *lcd, lcd_packet *packet, int timeout);
 #endif
@@ -341,6 +367,8 @@ picoLCD_init(Driver *drvthis)
 	/* Set-up USB input transfer data structures */
 	for (i = 0; i < USB_BUFFERS; i++)
 		p->input_transfer[i].transfer = NULL;
+	for (i = 0; i < USB_OUT_BUFFERS; i++)
+		p->output_transfer[i].transfer = NULL;
 	for (i = 0; i < USB_BUFFERS; i++)
 	{
 		UsbTransferData *utdp = &p->input_transfer[i];
@@ -369,6 +397,21 @@ picoLCD_init(Driver *drvthis)
 		}
 	}
 
+	/* Set-up USB output transfer ring */
+	for (i = 0; i < USB_OUT_BUFFERS; i++) {
+		UsbOutputData *uodp = &p->output_transfer[i];
+
+		uodp->drvthis = drvthis;
+		uodp->busy = 0;
+		uodp->transfer = libusb_alloc_transfer(0);
+		if (uodp->transfer == NULL) {
+			report(RPT_ERR, "%s: libusb_alloc_transfer failed", drvthis->name);
+			free_usb_transfers(drvthis);
+			return -1;
+		}
+	}
+	p->output_next = 0;
+
 #else				/* The libusb 0.1 way */
 
 	/* Try to find picolcd device */
@@ -427,7 +470,7 @@ done:
 #endif	/* HAVE_LIBUSB_1_0 */
 
 	/* if the device has a init sequence send it to device */
-	picolcd_send(p->lcd, p->device->initseq, PICOLCD_MAX_DATA_LEN);
+	picolcd_send(drvthis, p->device->initseq, PICOLCD_MAX_DATA_LEN);
 
 	p->width = p->device->width;
 	p->height = p->device->height;
@@ -544,9 +587,9 @@ done:
 		picoLCD_backlight(drvthis, 0);
 
 	if (p->keylights)
-		set_key_lights(p->lcd, p->key_light, 1);
+		set_key_lights(drvthis, p->key_light, 1);
 	else
-		set_key_lights(p->lcd, p->key_light, 0);
+		set_key_lights(drvthis, p->key_light, 0);
 
 	picoLCD_set_contrast(drvthis, p->contrast);
 
@@ -756,7 +799,7 @@ picoLCD_flush(Driver *drvthis)
 		for (i = 0; i < p->width; i++) {
 			if (*fb++ != *lf++) {
 				strncpy((char *)text, (char *)p->framebuf + offset, p->width);
-				p->device->write(p->lcd, line, 0, text);
+				p->device->write(drvthis, line, 0, text);
 				memcpy(p->lstframe + offset, p->framebuf + offset, p->width);
 
 				debug(RPT_DEBUG, "%s: flush wrote line %d (%s)",
@@ -767,6 +810,15 @@ picoLCD_flush(Driver *drvthis)
 		}
 	}
 
+#ifdef HAVE_LIBUSB_1_0
+	{
+		/* Get the queued transfers going, do not wait for them */
+		struct timeval timeout = { 0, 0 };
+
+		libusb_handle_events_timeout(p->lib_ctx, &timeout);
+	}
+#endif
+
 	debug(RPT_DEBUG, "%s: flush complete\n\t(%s)\n\t(%s)",
 		drvthis->name, p->framebuf, p->lstframe);
 }
@@ -1505,7 +1557,7 @@ picoLCD_set_contrast(Driver *drvthis, int promille)
 		packet[1] = p->device->contrast_max;
 	}
 
-	picolcd_send(p->lcd, packet, 2);
+	picolcd_send(drvthis, packet, 2);
 }
 
 
@@ -1562,11 +1614,11 @@ picoLCD_backlight(Driver *drvthis, int state)
 		if (s > p->device->bklight_max)
 			s = p->device->bklight_max;
 		packet[1] = (unsigned char) s;
-		picolcd_send(p->lcd, packet, 2);
+		picolcd_send(drvthis, packet, 2);
 		if (p->linklights) {
 			/* Only enable key lights if enabled by user */
 			if (p->keylights)
-				set_key_lights(p->lcd, p->key_light, state);
+				set_key_lights(drvthis, p->key_light, state);
 		}
 	}
 	else if (state == BACKLIGHT_OFF) {
@@ -1574,10 +1626,10 @@ picoLCD_backlight(Driver *drvthis, int state)
 		if (s > p->device->bklight_min)
 			s = p->device->bklight_min;
 		packet[1] = (unsigned char) s;
-		picolcd_send(p->lcd, packet, 2);
+		picolcd_send(drvthis, packet, 2);
 		if (p->linklights) {
 			/* Always turn key lights off */
-			set_key_lights(p->lcd, p->key_light, state);
+			set_key_lights(drvthis, p->key_light, state);
 		}
 	}
 }
@@ -1598,7 +1650,7 @@ picoLCD_output(Driver *drvthis, int state)
 	for (x = 0, m = 1; x < KEYPAD_LIGHTS; x++, m <<= 1) {
 		p->key_light[x] = state & m;
 	}
-	set_key_lights(p->lcd, p->key_light, 1);
+	set_key_lights(drvthis, p->key_light, 1);
 }
 
 
@@ -1863,41 +1915,76 @@ picolcd_lircsend(Driver *drvthis)
 
 
 /**
- * Send raw data to the display using low level usb_interrupt_write.
- * \param lcd   pointer to device handle
- * \param data  pointer to data packet to send
- * \param size  number of bytes to send
+ * Send raw data to the display.
+ *
+ * With libusb-1.0 the data is copied into the next free transfer of the
+ * output ring and submitted asynchronously; only if the ring is full we
+ * wait for the oldest transfer to complete. With libusb 0.1 it is sent
+ * using the blocking usb_interrupt_write.
+ *
+ * \param drvthis  Pointer to driver structure.
+ * \param data     pointer to data packet to send
+ * \param size     number of bytes to send
  */
 static void
-picolcd_send(USB_DEVICE_HANDLE * lcd, unsigned char *data, int size)
+picolcd_send(Driver *drvthis, unsigned char *data, int size)
 {
-	if ((lcd == NULL) && (data == NULL))
+	PrivateData *p = drvthis->private_data;
+
+	if ((p->lcd == NULL) || (data == NULL))
 		return;
 #ifdef HAVE_LIBUSB_1_0
-	int error = 0;
-	int transferred = 0;
-	unsigned int timeout = 1000;	/* milliseconds */
-	error = libusb_interrupt_transfer(lcd, LIBUSB_ENDPOINT_OUT + 1, data, size, &transferred, timeout);
+	UsbOutputData *uodp = &p->output_transfer[p->output_next];
+	int error;
+	int loop;
+
+	if (size > PICOLCD_MAX_OUT_LEN)
+		size = PICOLCD_MAX_OUT_LEN;
+
+	/* Ring is full: process USB events until the oldest transfer is done */
+	for (loop = 10; uodp->busy && (loop > 0); loop--) {
+		struct timeval timeout = { 0, 100000 };
+
+		libusb_handle_events_timeout(p->lib_ctx, &timeout);
+	}
+	if (uodp->busy) {
+		report(RPT_ERR, "%s: output transfer queue stalled, dropping %d bytes",
+			drvthis->name, size);
+		return;
+	}
+
+	memcpy(uodp->buffer, data, size);
+	libusb_fill_interrupt_transfer(uodp->transfer,
+			p->lcd,
+			LIBUSB_ENDPOINT_OUT + 1,
+			uodp->buffer,
+			size,
+			usb_cb_output,
+			(void *)uodp,
+			1000);
+	error = libusb_submit_transfer(uodp->transfer);
 	if (error) {
-		/* can't use report here */
-		fprintf(stderr, "libusb_interrupt_transfer error %d, sent %d of %d bytes\n",
-			error, transferred, size);
+		report(RPT_ERR, "%s: output transfer submit status %d", drvthis->name, error);
+		return;
 	}
+	uodp->busy = 1;
+
+	p->output_next = (p->output_next + 1) % USB_OUT_BUFFERS;
 #else
-	usb_interrupt_write(lcd, USB_ENDPOINT_OUT + 1, (char *)data, size, 1000);
+	usb_interrupt_write(p->lcd, USB_ENDPOINT_OUT + 1, (char *)data, size, 1000);
 #endif
 }
 
 
 /**
  * Write function for 20x4 desktop displays.
- * \param lcd   pointer to device handle
- * \param row   Row to place the string at
- * \param col   ignored
- * \param data  pointer to NUL terminated string
+ * \param drvthis  Pointer to driver structure
+ * \param row      Row to place the string at
+ * \param col      ignored
+ * \param data     pointer to NUL terminated string
  */
 static void
-picolcd_20x4_write(USB_DEVICE_HANDLE * lcd, const int row, const int col, const unsigned char *data)
+picolcd_20x4_write(Driver *drvthis, const int row, const int col, const unsigned char *data)
 {
 	unsigned char packet[64] = {0x95, 0x01, 0x00, 0x01};
 	unsigned char lineset[4][6] = {
@@ -1915,38 +2002,38 @@ picolcd_20x4_write(USB_DEVICE_HANDLE * lcd, const int row, const int col, const
 	/* Send command to select row */
 	switch (row) {
 	    case 0:
-		picolcd_send(lcd, lineset[0], 6);
+		picolcd_send(drvthis, lineset[0], 6);
 		break;
 	    case 1:
-		picolcd_send(lcd, lineset[1], 6);
+		picolcd_send(drvthis, lineset[1], 6);
 		break;
 	    case 2:
-		picolcd_send(lcd, lineset[2], 6);
+		picolcd_send(drvthis, lineset[2], 6);
 		break;
 	    case 3:
-		picolcd_send(lcd, lineset[3], 6);
+		picolcd_send(drvthis, lineset[3], 6);
 		break;
 	    default:
-		picolcd_send(lcd, lineset[0], 6);
+		picolcd_send(drvthis, lineset[0], 6);
 		break;
 	}
 
 	/* Fill in an send packet */
 	packet[4] = len;
 	memcpy(packet + 5, data, len);
-	picolcd_send(lcd, packet, 5 + len);
+	picolcd_send(drvthis, packet, 5 + len);
 }
 
 
 /**
  * Write function for 20x2 OEM displays.
- * \param lcd   pointer to device handle
- * \param row   Row to place the string at
- * \param col   Column to place the string at
- * \param data  pointer to NUL terminated string
+ * \param drvthis  Pointer to driver structure
+ * \param row      Row to place the string at
+ * \param col      Column to place the string at
+ * \param data     pointer to NUL terminated string
  */
 static void
-picolcd_20x2_write(USB_DEVICE_HANDLE * lcd, const int row, const int col, const unsigned char *data)
+picolcd_20x2_write(Driver *drvthis, const int row, const int col, const unsigned char *data)
 {
 	unsigned char packet[64] = {0x98};
 	int len = strlen((char *)data);
@@ -1965,7 +2052,7 @@ picolcd_20x2_write(USB_DEVICE_HANDLE * lcd, const int row, const int col, const
 
 	memcpy(packet + 4, data, len);
 
-	picolcd_send(lcd, packet, 4 + len);
+	picolcd_send(drvthis, packet, 4 + len);
 }
 
 
@@ -1994,7 +2081,7 @@ picolcd_20x2_set_char(Driver *drvthis, int n, unsigned char *dat)
 		packet[row + 2] = dat[row] & mask;
 	}
 
-	picolcd_send(p->lcd, packet, 10);
+	picolcd_send(drvthis, packet, 10);
 }
 
 
@@ -2007,8 +2094,6 @@ picolcd_20x2_set_char(Driver *drvthis, int n, unsigned char *dat)
 static void
 picolcd_20x4_set_char(Driver *drvthis, int n, unsigned char *dat)
 {
-	PrivateData *p = drvthis->private_data;
-
 	if ((n < 0) || (n >= NUM_CCs))
 		return;
 	if (dat == NULL)
@@ -2023,8 +2108,8 @@ picolcd_20x4_set_char(Driver *drvthis, int n, unsigned char *dat)
 		dat[4], dat[5], dat[6], dat[7]
 	};			/* 0x95 */
 
-	picolcd_send(p->lcd, command, 6);
-	picolcd_send(p->lcd, data, 13);
+	picolcd_send(drvthis, command, 6);
+	picolcd_send(drvthis, data, 13);
 }
 
 #ifndef HAVE_LIBUSB_1_0
@@ -2063,13 +2148,13 @@ get_key_event(usb_dev_handle * lcd, lcd_packet * packet, int timeout)
 
 /**
  * Set lights for individual keys.
- * \param lcd    Pointer to device handle
- * \param keys   Array indicating which key number to turn on
- * \param state  0 to turn all LEDs off, 1 to turn them on according to
- *               values set in 'keys' array
+ * \param drvthis  Pointer to driver structure
+ * \param keys     Array indicating which key number to turn on
+ * \param state    0 to turn all LEDs off, 1 to turn them on according to
+ *                 values set in 'keys' array
  */
 static void
-set_key_lights(USB_DEVICE_HANDLE * lcd, int keys[], int state)
+set_key_lights(Driver *drvthis, int keys[], int state)
 {
 	unsigned char packet[2] = {0x81};	/* set led */
 	unsigned int leds = 0;
@@ -2089,7 +2174,7 @@ set_key_lights(USB_DEVICE_HANDLE * lcd, int keys[], int state)
 	}
 
 	packet[1] = leds;
-	picolcd_send(lcd, packet, 2);
+	picolcd_send(drvthis, packet, 2);
 }
 
 
@@ -2129,6 +2214,33 @@ free_usb_transfers(Driver *drvthis)
 			}
 		}
 	}
+
+	for (i = 0; i < USB_OUT_BUFFERS; i++) {
+		UsbOutputData *uodp = &p->output_transfer[i];
+		int loop;
+
+		if (uodp->transfer == NULL)
+			continue;
+		/* Give pending output a chance to reach the display */
+		for (loop = 10; uodp->busy && (loop > 0); loop--) {
+			struct timeval timeout = { 0, 100000 };
+
+			libusb_handle_events_timeout(p->lib_ctx, &timeout);
+		}
+		if (uodp->busy) {
+			report(RPT_INFO, "%s: cancelling output transfer %d", drvthis->name, i);
+			libusb_cancel_transfer(uodp->transfer);
+			for (loop = 10; uodp->busy && (loop > 0); loop--) {
+				struct timeval timeout = { 0, 100000 };
+
+				libusb_handle_events_timeout(p->lib_ctx, &timeout);
+			}
+		}
+		/* A transfer still in flight must not be freed */
+		if (!uodp->busy)
+			libusb_free_transfer(uodp->transfer);
+		uodp->transfer = NULL;
+	}
 }
 
 /**
@@ -2161,6 +2273,12 @@ key_buffer_put(Driver *drvthis, unsigned char high_key, unsigned char low_key)
 	}
 }
 
+/** Names of the libusb transfer status codes */
+static const char *usb_status[] = {
+	"COMPLETED", "ERROR", "TIMED_OUT", "CANCELLED", "STALL",
+	"NO_DEVICE", "OVERFLOW"
+};
+
 /**
  * Call-back for USB input. Either calls key_buffer_put to process key events
  * or ir_trancode to process events from IR receiver.
@@ -2170,16 +2288,12 @@ key_buffer_put(Driver *drvthis, unsigned char high_key, unsigned char low_key)
 static void
 usb_cb_input(struct libusb_transfer *transfer)
 {
-	static const char *status[] = {
-		"COMPLETED", "ERROR", "TIMED_OUT", "CANCELLED", "STALL",
-		"NO_DEVICE", "OVERFLOW"
-	};
 	UsbTransferData *p = (UsbTransferData *)transfer->user_data;
 	Driver *drvthis = p->drvthis;
 	PrivateData *p_data = drvthis->private_data;
 
 	if (transfer->status != LIBUSB_TRANSFER_COMPLETED) {
-		report(RPT_ERR, "%s: input transfer status: %s", drvthis->name, status[transfer->status]);
+		report(RPT_ERR, "%s: input transfer status: %s", drvthis->name, usb_status[transfer->status]);
 		p->status = transfer->status;
 		libusb_free_transfer(transfer);
 		p->transfer = NULL;
@@ -2206,6 +2320,27 @@ usb_cb_input(struct libusb_transfer *transfer)
 	if (p->status != LIBUSB_SUCCESS)
 		report(RPT_ERR, "%s: input transfer submit status %d", drvthis->name, p->status);
 }
+
+/**
+ * Call-back for USB output. Reports failed transfers and releases the
+ * transfer for reuse by picolcd_send().
+ *
+ * \param transfer  Structure containing the USB data
+ */
+static void
+usb_cb_output(struct libusb_transfer *transfer)
+{
+	UsbOutputData *uodp = (UsbOutputData *)transfer->user_data;
+	Driver *drvthis = uodp->drvthis;
+
+	if (transfer->status != LIBUSB_TRANSFER_COMPLETED)
+		report(RPT_ERR, "%s: output transfer status: %s", drvthis->name, usb_status[transfer->status]);
+	else if (transfer->actual_length != transfer->length)
+		report(RPT_WARNING, "%s: output transfer short write %d of %d bytes",
+			drvthis->name, transfer->actual_length, transfer->length);
+
+	uodp->busy = 0;
+}
 #endif
 
 /* EOF */
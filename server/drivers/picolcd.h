@@ -34,6 +34,7 @@
 #define OUT_REPORT_DATA		0x95
 
 #define PICOLCD_MAX_DATA_LEN	24
+#define PICOLCD_MAX_OUT_LEN	64
 
 #define DEFAULT_LIRCPORT	8765
 #define DEFAULT_LIRC_TIME_us	0	/* false */
@@ -68,7 +69,7 @@ typedef struct _picolcd_device {
 	int width;                  /* width of lcd screen */
 	int height;                 /* height of lcd screen */
 	/* Pointer to function that writes data to the LCD format */
-	void (*write) (USB_DEVICE_HANDLE *lcd, const int row, const int col, const unsigned char *data);
+	void (*write) (Driver *drvthis, const int row, const int col, const unsigned char *data);
 	/* Pointer to function that defines a custom character */
 	void (*cchar) (Driver *drvthis, int n, unsigned char *dat);
 } picolcd_device;
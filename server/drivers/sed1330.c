@@ -70,6 +70,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "lcd.h"
 #include "sed1330.h"
@@ -122,6 +123,12 @@
 #define SCR2_H 0x06
 
 
+/** Range of changed bytes within one line of a framebuffer */
+typedef struct {
+	int first;		/**< first changed byte, -1 if line is clean */
+	int last;		/**< last changed byte */
+} DirtyRange;
+
 /** private data for the \c sed1330 driver */
 typedef struct sed1330_private_data {
 	int type;		/**< display type */
@@ -137,6 +144,12 @@ typedef struct sed1330_private_data {
 	unsigned char *lcd_contents_text;
 	unsigned char *framebuf_graph;
 	unsigned char *lcd_contents_graph;
+	DirtyRange *dirty_text;		/**< changed bytes per text line */
+	DirtyRange *dirty_graph;	/**< changed bytes per raster line */
+
+	int full_refresh;	/**< rewrite everything on next flush */
+	int refreshdisplay;	/**< seconds after which a full refresh is forced */
+	time_t nextrefresh;	/**< time when the next full refresh is due */
 
 	int width, height;
 	int cellwidth, cellheight;
@@ -188,6 +201,8 @@ MODULE_EXPORT char *symbol_prefix = "sed1330_";
 void sed1330_command(PrivateData * p, char command, int datacount, unsigned char *data);
 void sed1330_rect(PrivateData * p, int x1, int y1, int x2, int y2, char pattern);
 inline void sed1330_set_pixel(PrivateData * p, int x, int y, int value);
+static void sed1330_mark_dirty(DirtyRange *dirty, int lines, int linelen, int line, int first, int last);
+static void sed1330_mark_all_dirty(PrivateData * p);
 unsigned char sed1330_scankeypad(PrivateData * p);
 unsigned char sed1330_readkeypad(PrivateData * p, unsigned int YData);
 
@@ -216,6 +231,8 @@ sed1330_init(Driver * drvthis)
 	p->lcd_contents_text = NULL;
 	p->framebuf_graph = NULL;
 	p->lcd_contents_graph = NULL;
+	p->dirty_text = NULL;
+	p->dirty_graph = NULL;
 
 	/* READ THE CONFIG FILE */
 
@@ -395,6 +412,24 @@ sed1330_init(Driver * drvthis)
 	}
 	memset(p->lcd_contents_graph, 0xFF, p->bytesperline * p->graph_height);
 
+	/* Allocate per line change tracking, everything is written on first flush */
+	p->dirty_text = (DirtyRange *)malloc(p->textlines_in_memory * sizeof(DirtyRange));
+	p->dirty_graph = (DirtyRange *)malloc(p->graph_height * sizeof(DirtyRange));
+	if ((p->dirty_text == NULL) || (p->dirty_graph == NULL)) {
+		report(RPT_ERR, "%s: error allocating dirty ranges", drvthis->name);
+		return -1;
+	}
+	sed1330_mark_all_dirty(p);
+	p->full_refresh = 1;
+
+	/* Force a full refresh every n seconds. Default: 0 (never) */
+	p->refreshdisplay = drvthis->config_get_int(drvthis->name, "RefreshDisplay", 0, 0);
+	if (p->refreshdisplay < 0) {
+		report(RPT_WARNING, "%s: RefreshDisplay value invalid, disabling", drvthis->name);
+		p->refreshdisplay = 0;
+	}
+	p->nextrefresh = 0;
+
 	/* Arrange for access to port */
 	debug(RPT_DEBUG, "%s: getting port access", __FUNCTION__);
 	if (port_access_multiple(p->port, 3)) {
@@ -547,6 +582,10 @@ sed1330_close(Driver * drvthis)
 			free(p->framebuf_graph);
 		if (p->lcd_contents_graph != NULL)
 			free(p->lcd_contents_graph);
+		if (p->dirty_text != NULL)
+			free(p->dirty_text);
+		if (p->dirty_graph != NULL)
+			free(p->dirty_graph);
 
 		free(p);
 	}
@@ -626,6 +665,7 @@ sed1330_clear(Driver * drvthis)
 
 	memset(p->framebuf_text, ' ', p->bytesperline * p->textlines_in_memory);
 	memset(p->framebuf_graph, '\0', p->bytesperline * p->graph_height);
+	sed1330_mark_all_dirty(p);
 }
 
 
@@ -662,7 +702,11 @@ sed1330_string(Driver * drvthis, int x, int y, char *str)
 	dest = p->framebuf_text + (y - 1) * p->bytesperline + (x - 1);
 
 	/* And write */
-	memcpy(dest, str, len);
+	if (len > 0) {
+		memcpy(dest, str, len);
+		sed1330_mark_dirty(p->dirty_text, p->textlines_in_memory, p->bytesperline,
+				   y - 1, x - 1, x + len - 2);
+	}
 }
 
 
@@ -680,65 +724,150 @@ sed1330_chr(Driver * drvthis, int x, int y, char c)
 		return;		/* outside framebuf */
 	}
 	p->framebuf_text[(y - 1) * p->bytesperline + (x - 1)] = c;
+	sed1330_mark_dirty(p->dirty_text, p->textlines_in_memory, p->bytesperline,
+			   y - 1, x - 1, x - 1);
+}
+
+
+/**
+ * Records that bytes first to last of a framebuffer line were written.
+ * \param dirty    Dirty ranges of the framebuffer
+ * \param lines    Number of lines in the framebuffer
+ * \param linelen  Number of bytes per line
+ * \param line     Line written to (0-based)
+ * \param first    First byte written (0-based)
+ * \param last     Last byte written (0-based)
+ */
+static void
+sed1330_mark_dirty(DirtyRange *dirty, int lines, int linelen, int line, int first, int last)
+{
+	if ((line < 0) || (line >= lines))
+		return;
+	if (first < 0)
+		first = 0;
+	if (last >= linelen)
+		last = linelen - 1;
+	if (first > last)
+		return;
+
+	if ((dirty[line].first < 0) || (first < dirty[line].first))
+		dirty[line].first = first;
+	if (last > dirty[line].last)
+		dirty[line].last = last;
+}
+
+
+/**
+ * Marks the whole text and graphic framebuffers as changed.
+ * \param p  Pointer to driver's private data
+ */
+static void
+sed1330_mark_all_dirty(PrivateData * p)
+{
+	int i;
+
+	for (i = 0; i < p->textlines_in_memory; i++) {
+		p->dirty_text[i].first = 0;
+		p->dirty_text[i].last = p->bytesperline - 1;
+	}
+	for (i = 0; i < p->graph_height; i++) {
+		p->dirty_graph[i].first = 0;
+		p->dirty_graph[i].last = p->bytesperline - 1;
+	}
+}
+
+
+/**
+ * Writes the changed bytes of one framebuffer to display memory. Only the
+ * dirty range of each line is compared to the display contents; runs of
+ * changed bytes are written with one MWRITE each.
+ * \param p         Pointer to driver's private data
+ * \param fb        Framebuffer to write
+ * \param contents  Copy of the display memory
+ * \param dirty     Dirty ranges of the framebuffer, reset on return
+ * \param lines     Number of lines in the framebuffer
+ * \param base      Display memory address of the framebuffer
+ * \param full      Write the whole framebuffer regardless of its contents
+ */
+static void
+sed1330_flush_buffer(PrivateData * p, unsigned char *fb, unsigned char *contents,
+		     DirtyRange *dirty, int lines, unsigned int base, int full)
+{
+	unsigned int pos, start_pos, end_pos, nr_equal, len, cursor_pos;
+	unsigned char csrloc[2];
+	int line;
+
+	if (full) {
+		len = p->bytesperline * lines;
+		csrloc[0] = base % 256;
+		csrloc[1] = base / 256;
+		sed1330_command(p, CMD_CSRW, 2, csrloc);
+		sed1330_command(p, CMD_MWRITE, len, fb);
+		memcpy(contents, fb, len);
+	}
+
+	for (line = 0; line < lines; line++) {
+		if (dirty[line].first < 0)
+			continue;
+
+		if (!full) {
+			end_pos = line * p->bytesperline + dirty[line].last + 1;
+			for (pos = line * p->bytesperline + dirty[line].first; pos < end_pos;) {
+				start_pos = pos;
+				for (nr_equal = 0; pos < end_pos && nr_equal < 4; pos++) {
+					if (contents[pos] == fb[pos]) {
+						nr_equal++;
+					}
+					else {
+						nr_equal = 0;
+					}
+				}
+				len = pos - start_pos - nr_equal;
+				if (len > 0) {
+					cursor_pos = start_pos + base;
+					csrloc[0] = cursor_pos % 256;
+					csrloc[1] = cursor_pos / 256;
+					sed1330_command(p, CMD_CSRW, 2, csrloc);
+					sed1330_command(p, CMD_MWRITE, len, fb + start_pos);
+					memcpy(contents + start_pos, fb + start_pos, len);
+				}
+			}
+		}
+		dirty[line].first = -1;
+		dirty[line].last = -1;
+	}
 }
 
 
 /**
  * API: Flush the framebuffer to the display. On call to this function
- * both framebuffers (text and graphic) are written to the display.
+ * the changed parts of both framebuffers (text and graphic) are written to
+ * the display. If RefreshDisplay is set, both framebuffers are rewritten
+ * completely every RefreshDisplay seconds.
  */
 MODULE_EXPORT void
 sed1330_flush(Driver * drvthis)
 {
 	PrivateData *p = drvthis->private_data;
-	unsigned int pos, start_pos, nr_equal, fblen, len, cursor_pos;
-	unsigned char csrloc[2];
+	int full;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	fblen = p->bytesperline * p->textlines_in_memory;
-	for (pos = 0; pos < fblen;) {
-		start_pos = pos;
-		for (nr_equal = 0; pos < fblen && nr_equal < 4; pos++) {
-			if (p->lcd_contents_text[pos] == p->framebuf_text[pos]) {
-				nr_equal++;
-			}
-			else {
-				nr_equal = 0;
-			}
-		}
-		len = pos - start_pos - nr_equal;
-		if (len > 0) {
-			cursor_pos = start_pos + 256 * SCR1_H + SCR1_L;
-			csrloc[0] = cursor_pos % 256;
-			csrloc[1] = cursor_pos / 256;
-			sed1330_command(p, CMD_CSRW, 2, csrloc);
-			sed1330_command(p, CMD_MWRITE, len, p->framebuf_text + start_pos);
-			memcpy(p->lcd_contents_text + start_pos, p->framebuf_text + start_pos, len);
-		}
-	}
+	full = p->full_refresh;
+	if (p->refreshdisplay > 0) {
+		time_t now = time(NULL);
 
-	fblen = p->bytesperline * p->graph_height;
-	for (pos = 0; pos < fblen;) {
-		start_pos = pos;
-		for (nr_equal = 0; pos < fblen && nr_equal < 4; pos++) {
-			if (p->lcd_contents_graph[pos] == p->framebuf_graph[pos]) {
-				nr_equal++;
-			}
-			else {
-				nr_equal = 0;
-			}
-		}
-		len = pos - start_pos - nr_equal;
-		if (len > 0) {
-			cursor_pos = start_pos + 256 * SCR2_H + SCR2_L;
-			csrloc[0] = cursor_pos % 256;
-			csrloc[1] = cursor_pos / 256;
-			sed1330_command(p, CMD_CSRW, 2, csrloc);
-			sed1330_command(p, CMD_MWRITE, len, p->framebuf_graph + start_pos);
-			memcpy(p->lcd_contents_graph + start_pos, p->framebuf_graph + start_pos, len);
+		if (now > p->nextrefresh) {
+			full = 1;
+			p->nextrefresh = now + p->refreshdisplay;
 		}
 	}
+	p->full_refresh = 0;
+
+	sed1330_flush_buffer(p, p->framebuf_text, p->lcd_contents_text, p->dirty_text,
+			     p->textlines_in_memory, 256 * SCR1_H + SCR1_L, full);
+	sed1330_flush_buffer(p, p->framebuf_graph, p->lcd_contents_graph, p->dirty_graph,
+			     p->graph_height, 256 * SCR2_H + SCR2_L, full);
 }
 
 
@@ -774,6 +903,10 @@ sed1330_rect(PrivateData * p, int x1, int y1, int x2, int y2, char pattern)
 			sed1330_set_pixel(p, x, y, pattern);
 		}
 	}
+	for (y = y1; y <= y2; y++) {
+		sed1330_mark_dirty(p->dirty_graph, p->graph_height, p->bytesperline,
+				   y, x1 / p->cellwidth, x2 / p->cellwidth);
+	}
 }
 
 
@@ -879,6 +1012,7 @@ sed1330_heartbeat(Driver * drvthis, int type)
 
 	pos = p->width - 1;	/* Draw into top right corner */
 	p->framebuf_text[pos] = ' ';	/* Clear the text framebuffer there */
+	sed1330_mark_dirty(p->dirty_text, p->textlines_in_memory, p->bytesperline, 0, pos, pos);
 
 	/* Draw the bouncing ball based on timer into graphic framebuffer */
 	for (n = 0; n < p->cellheight; n++) {
@@ -889,6 +1023,8 @@ sed1330_heartbeat(Driver * drvthis, int type)
 		else {
 			p->framebuf_graph[pos] = 0;
 		}
+		sed1330_mark_dirty(p->dirty_graph, p->graph_height, p->bytesperline,
+				   n, p->width - 1, p->width - 1);
 		pos += p->bytesperline;
 	}
 
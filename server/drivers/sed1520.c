@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
 
 #include "lcd.h"
 #include "sed1520.h"
@@ -61,6 +62,12 @@ typedef struct sed1520_private_data {
     unsigned char colStartAdd;
 
     unsigned char *framebuf;
+    unsigned char *backingstore;	/**< Data last written to the display */
+    int dirty_first[HEIGHT];	/**< First changed column per page, -1 if clean */
+    int dirty_last[HEIGHT];	/**< Last changed column per page */
+    int full_refresh;		/**< Rewrite the whole display on next flush */
+    int refreshdisplay;		/**< Seconds after which a full refresh is forced */
+    time_t nextrefresh;		/**< Time when the next full refresh is due */
 } PrivateData;
 
 
@@ -201,19 +208,77 @@ selectcolumn(PrivateData *p, int column, int chip)
  * right to left (inverted mapping).
  */
 
+/**
+ * Extends the range of changed columns of a page.
+ * \param p      Pointer to private data structure
+ * \param page   Page (=row) number (0-3)
+ * \param first  First column written
+ * \param last   Last column written
+ */
+static void
+mark_dirty(PrivateData *p, int page, int first, int last)
+{
+    if (first < 0)
+	first = 0;
+    if (last >= PIXELWIDTH)
+	last = PIXELWIDTH - 1;
+    if (first > last)
+	return;
+
+    if ((p->dirty_first[page] < 0) || (first < p->dirty_first[page]))
+	p->dirty_first[page] = first;
+    if (last > p->dirty_last[page])
+	p->dirty_last[page] = last;
+}
+
+/**
+ * Writes the changed part of columns first to last of one page to the
+ * controller chip driving them and updates the backing store.
+ * \param p      Pointer to private data structure
+ * \param page   Page (=row) number (0-3)
+ * \param first  First column to consider (display coordinates)
+ * \param last   Last column to consider (display coordinates)
+ * \param chip   Controller driving these columns
+ * \param full   Write all columns even if unchanged
+ */
+static void
+flush_span(PrivateData *p, int page, int first, int last, int chip, int full)
+{
+    unsigned char *fb = p->framebuf + (page * PIXELWIDTH);
+    unsigned char *bs = p->backingstore + (page * PIXELWIDTH);
+    int offset = (chip == CS1) ? 0 : PIXELWIDTH / 2;
+    int j;
+
+    if (!full) {
+	/* Skip columns that already show the right data */
+	while ((first <= last) && (fb[first] == bs[first]))
+	    first++;
+	while ((last >= first) && (fb[last] == bs[last]))
+	    last--;
+    }
+    if (first > last)
+	return;
+
+    selectcolumn(p, p->colStartAdd + first - offset, chip);
+    for (j = first; j <= last; j++)
+	writedata(p, fb[j], chip);
+    memcpy(bs + first, fb + first, last - first + 1);
+}
+
 /**
  * Draws character z from fontmap to the framebuffer at position x,y.
  * The fontmap is stored in rows while the framebuffer is stored in columns,
  * so we need a little conversion.
  *
- * \param framebuf  Pointer to framebuffer
- * \param x         Character column (zero-based)
- * \param y         Line (zero-based)
- * \param z         Character index in fontmap
+ * \param p  Pointer to private data structure
+ * \param x  Character column (zero-based)
+ * \param y  Line (zero-based)
+ * \param z  Character index in fontmap
  */
 static void
-drawchar2fb(unsigned char *framebuf, int x, int y, unsigned char z)
+drawchar2fb(PrivateData *p, int x, int y, unsigned char z)
 {
+    unsigned char *framebuf = p->framebuf;
     int i, j;
 
     if ((x < 0) || (x >= WIDTH) || (y < 0) || (y >= HEIGHT))
@@ -230,6 +295,7 @@ drawchar2fb(unsigned char *framebuf, int x, int y, unsigned char z)
 	/* And store it in framebuffer pixel column */
 	framebuf[(y * PIXELWIDTH) + (x * CELLWIDTH) + (CELLWIDTH - i)] = k;
     }
+    mark_dirty(p, y, x * CELLWIDTH, x * CELLWIDTH + CELLWIDTH - 1);
 }
 
 /**
@@ -240,6 +306,7 @@ sed1520_init(Driver * drvthis)
 {
     PrivateData *p;
     char inverted;
+    int i;
 
     /* Allocate and store private data */
     p = (PrivateData *) calloc(1, sizeof(PrivateData));
@@ -274,6 +341,24 @@ sed1520_init(Driver * drvthis)
     /* Clear screen */
     memset(p->framebuf, '\0', PIXELWIDTH * HEIGHT);
 
+    /* Allocate backing store, its content is unknown until the first flush */
+    p->backingstore = (unsigned char *) calloc(PIXELWIDTH * HEIGHT, sizeof(unsigned char));
+    if (p->backingstore == NULL) {
+	report(RPT_ERR, "%s: unable to allocate backing store", drvthis->name);
+	return -1;
+    }
+    for (i = 0; i < HEIGHT; i++)
+	p->dirty_first[i] = -1;
+    p->full_refresh = 1;
+
+    /* Force a full refresh every n seconds */
+    p->refreshdisplay = drvthis->config_get_int(drvthis->name, "RefreshDisplay", 0, 0);
+    if (p->refreshdisplay < 0) {
+	report(RPT_WARNING, "%s: RefreshDisplay value invalid, disabling", drvthis->name);
+	p->refreshdisplay = 0;
+    }
+    p->nextrefresh = 0;
+
     /* Open port */
     if (port_access_multiple(p->port, 3)) {
 	report(RPT_ERR, "%s: unable to access port 0x%03X", drvthis->name, p->port);
@@ -330,6 +415,8 @@ sed1520_close(Driver * drvthis)
     if (p != NULL) {
 	if (p->framebuf != NULL)
 	    free(p->framebuf);
+	if (p->backingstore != NULL)
+	    free(p->backingstore);
 
 	free(p);
     }
@@ -379,33 +466,61 @@ MODULE_EXPORT void
 sed1520_clear(Driver * drvthis)
 {
     PrivateData *p = drvthis->private_data;
+    int i;
 
     memset(p->framebuf, '\0', PIXELWIDTH * HEIGHT);
+    for (i = 0; i < HEIGHT; i++)
+	mark_dirty(p, i, 0, PIXELWIDTH - 1);
 }
 
 /**
  * API: Flushes all output to the lcd. No conversion needed here as
- * framebuffer is prepared by \c drawchar2fb.
+ * framebuffer is prepared by \c drawchar2fb. Only the columns of each page
+ * that were drawn to since the last flush and differ from the backing store
+ * are sent, unless a full refresh is due.
  */
 MODULE_EXPORT void
 sed1520_flush(Driver * drvthis)
 {
     PrivateData *p = drvthis->private_data;
-    int i, j;
+    int i, first, last, full;
+
+    full = p->full_refresh;
+    if (p->refreshdisplay > 0) {
+	time_t now = time(NULL);
+
+	if (now > p->nextrefresh) {
+	    full = 1;
+	    p->nextrefresh = now + p->refreshdisplay;
+	}
+    }
+    p->full_refresh = 0;
 
     for (i = 0; i < HEIGHT; i++) {
+	if (full) {
+	    first = 0;
+	    last = PIXELWIDTH - 1;
+	}
+	else if (p->dirty_first[i] < 0) {
+	    continue;
+	}
+	else {
+	    first = p->dirty_first[i];
+	    last = p->dirty_last[i];
+	}
+	p->dirty_first[i] = -1;
+	p->dirty_last[i] = -1;
+
 	/* select line/page */
 	selectpage(p, i);
 
 	/* update left half of display */
-	selectcolumn(p, p->colStartAdd, CS1);
-	for (j = 0; j < PIXELWIDTH / 2; j++)
-	    writedata(p, p->framebuf[j + (i * PIXELWIDTH)], CS1);
+	if (first < PIXELWIDTH / 2)
+	    flush_span(p, i, first, (last < PIXELWIDTH / 2) ? last : PIXELWIDTH / 2 - 1, CS1, full);
 
 	/* update right half of display */
-	selectcolumn(p, p->colStartAdd, CS2);
-	for (j = PIXELWIDTH / 2; j < PIXELWIDTH; j++)
-	    writedata(p, p->framebuf[j + (i * PIXELWIDTH)], CS2);
+	if (last >= PIXELWIDTH / 2)
+	    flush_span(p, i, (first >= PIXELWIDTH / 2) ? first : PIXELWIDTH / 2, last, CS2, full);
     }
 }
 
@@ -423,7 +538,7 @@ sed1520_string(Driver * drvthis, int x, int y, const char string[])
     y--;
 
     for (i = 0; string[i] != '\0'; i++)
-	drawchar2fb(p->framebuf, x + i, y, string[i]);
+	drawchar2fb(p, x + i, y, string[i]);
 }
 
 /**
@@ -437,7 +552,7 @@ sed1520_chr(Driver * drvthis, int x, int y, char c)
 
     y--;
     x--;
-    drawchar2fb(p->framebuf, x, y, c);
+    drawchar2fb(p, x, y, c);
 }
 
 /**
@@ -469,6 +584,7 @@ sed1520_num(Driver * drvthis, int x, int num)
 		    chrtbl_NUM[num][c * 3 + z];
 	    }
 	}
+	mark_dirty(p, z + 1, x * CELLWIDTH, x * CELLWIDTH + widtbl_NUM[num] - 1);
     }
 }
 
@@ -528,6 +644,7 @@ sed1520_vbar(Driver *drvthis, int x, int y, int len, int promille, int options)
 	p->framebuf[((3 - j) * PIXELWIDTH) + (x * CELLWIDTH) + 3] = k;
 	p->framebuf[((3 - j) * PIXELWIDTH) + (x * CELLWIDTH) + 4] = k;
 	p->framebuf[((3 - j) * PIXELWIDTH) + (x * CELLWIDTH) + 5] = 0;
+	mark_dirty(p, 3 - j, x * CELLWIDTH, x * CELLWIDTH + 5);
 
 	pixels -= CELLHEIGHT;
     }
@@ -558,6 +675,7 @@ sed1520_hbar(Driver *drvthis, int x, int y, int len, int promille, int options)
      */
     for (i = 0; i < pixels; i++)
 	p->framebuf[(y * PIXELWIDTH) + (x * CELLWIDTH) + i] = 0x7C;
+    mark_dirty(p, y, x * CELLWIDTH, x * CELLWIDTH + pixels - 1);
 }
 
 /**
@@ -0,0 +1,141 @@
+/** \file server/drivers/shm-lcd.c
+ * Creation and removal of the shared memory segment used by the \c shm
+ * driver and the \c shm connection type of the \c glcd driver.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "shm-lcd.h"
+
+/** Round up to multiple of 8 to keep all parts of the segment aligned. */
+#define ALIGN8(x)	(((x) + 7) & ~7)
+
+/**
+ * Create the shared memory object \c name, map it and fill in the header.
+ * An existing object of that name is replaced.
+ * \param name            Name of the shared memory object (starting with '/').
+ * \param mode            Access permissions of the object.
+ * \param type            SHM_LCD_TEXT or SHM_LCD_GRAPHIC.
+ * \param width           Width in characters (text) or pixels (graphic).
+ * \param height          Height in characters (text) or pixels (graphic).
+ * \param cellwidth       Character cell width in pixels.
+ * \param cellheight      Character cell height in pixels.
+ * \param bytes_per_line  Bytes per row of screen data.
+ * \return  Pointer to the new handle, NULL on error (errno is set).
+ */
+ShmLcd *
+shm_lcd_create(const char *name, int mode, int type, int width, int height,
+	       int cellwidth, int cellheight, int bytes_per_line)
+{
+	ShmLcd *shm;
+	ShmLcdHeader *hdr;
+	size_t data_size, chars_size, size;
+	int fd, err;
+
+	data_size = (size_t) bytes_per_line * height;
+	chars_size = (type == SHM_LCD_TEXT) ? SHM_LCD_CUSTOM_CHARS * cellheight : 0;
+	size = ALIGN8(sizeof(ShmLcdHeader)) + ALIGN8(data_size) + ALIGN8(chars_size);
+
+	shm = calloc(1, sizeof(ShmLcd));
+	if (shm == NULL)
+		return NULL;
+	shm->name = strdup(name);
+	if (shm->name == NULL) {
+		free(shm);
+		return NULL;
+	}
+
+	/* Start with a new object, readers may still have the old one mapped. */
+	shm_unlink(name);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, mode);
+	if (fd < 0)
+		goto err_out;
+	/* shm_open honours the umask, readers may need more */
+	fchmod(fd, mode);
+
+	if (ftruncate(fd, size) < 0) {
+		err = errno;
+		close(fd);
+		shm_unlink(name);
+		errno = err;
+		goto err_out;
+	}
+
+	hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	err = errno;
+	close(fd);
+	if (hdr == MAP_FAILED) {
+		shm_unlink(name);
+		errno = err;
+		goto err_out;
+	}
+
+	/* ftruncate zero-filled the segment */
+	hdr->version = SHM_LCD_VERSION;
+	hdr->size = size;
+	hdr->type = type;
+	hdr->writer_pid = getpid();
+	hdr->width = width;
+	hdr->height = height;
+	hdr->cellwidth = cellwidth;
+	hdr->cellheight = cellheight;
+	hdr->bytes_per_line = bytes_per_line;
+	hdr->data_offset = ALIGN8(sizeof(ShmLcdHeader));
+	hdr->data_size = data_size;
+	hdr->chars_offset = (chars_size > 0) ? hdr->data_offset + ALIGN8(data_size) : 0;
+	hdr->chars_size = chars_size;
+	if (type == SHM_LCD_TEXT)
+		memset(shm_lcd_data(hdr), ' ', data_size);
+	__sync_synchronize();
+	/* Readers check the magic last */
+	hdr->magic = SHM_LCD_MAGIC;
+
+	shm->hdr = hdr;
+	shm->size = size;
+	return shm;
+
+err_out:
+	err = errno;
+	free(shm->name);
+	free(shm);
+	errno = err;
+	return NULL;
+}
+
+/**
+ * Unmap and remove the shared memory object. Readers that still have it
+ * mapped see \c writer_pid set to 0 and keep the last frame.
+ * \param shm  Handle returned by shm_lcd_create().
+ */
+void
+shm_lcd_destroy(ShmLcd *shm)
+{
+	if (shm == NULL)
+		return;
+
+	if (shm->hdr != NULL) {
+		shm_lcd_write_begin(shm->hdr);
+		shm->hdr->writer_pid = 0;
+		shm_lcd_write_end(shm->hdr);
+		munmap(shm->hdr, shm->size);
+		shm_unlink(shm->name);
+	}
+	free(shm->name);
+	free(shm);
+}
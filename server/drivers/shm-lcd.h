@@ -0,0 +1,198 @@
+/** \file server/drivers/shm-lcd.h
+ * Layout of the shared memory segment written by the \c shm driver and the
+ * \c shm connection type of the \c glcd driver.
+ *
+ * The segment starts with a ShmLcdHeader followed by the screen data and the
+ * custom character bitmaps at the offsets given in the header. All fields
+ * are in host byte order, the segment is meant for processes on the same
+ * machine only.
+ *
+ * Consistency is ensured by a sequence lock: the writer increments \c seq
+ * before and after each update, so it is odd while an update is in progress.
+ * A reader copies what it needs and retries if \c seq was odd or has changed
+ * meanwhile:
+ *
+ * \code
+ * do {
+ *	seq = shm_lcd_read_begin(hdr);
+ *	memcpy(screen, (char *) hdr + hdr->data_offset, hdr->data_size);
+ * } while (shm_lcd_read_retry(hdr, seq));
+ * \endcode
+ *
+ * Readers wait for the next frame with shm_lcd_wait(), which sleeps on a
+ * futex on Linux and falls back to polling elsewhere. Readers only need to
+ * map the segment read-only.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifndef SHM_LCD_H
+#define SHM_LCD_H
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+
+#ifdef HAVE_LINUX_FUTEX_H
+# include <limits.h>
+# include <sys/syscall.h>
+# include <linux/futex.h>
+#endif
+
+/** Default name of the shared memory object */
+#define SHM_LCD_DEFAULT_NAME	"/lcdproc"
+
+#define SHM_LCD_MAGIC		0x4C434470	/**< 'LCDp' */
+#define SHM_LCD_VERSION		1
+
+/** Screen data is one byte per character cell, row by row */
+#define SHM_LCD_TEXT		0
+/** Screen data is 1 bit per pixel, MSB left, rows of \c bytes_per_line */
+#define SHM_LCD_GRAPHIC		1
+
+/** Number of custom characters in the segment (text type only) */
+#define SHM_LCD_CUSTOM_CHARS	8
+
+/** Header of the shared memory segment */
+typedef struct shm_lcd_header {
+	uint32_t magic;		/**< SHM_LCD_MAGIC */
+	uint32_t version;	/**< SHM_LCD_VERSION */
+	uint32_t size;		/**< total size of the segment in bytes */
+	uint32_t type;		/**< SHM_LCD_TEXT or SHM_LCD_GRAPHIC */
+
+	volatile uint32_t seq;		/**< sequence lock, odd during update */
+	volatile uint32_t frame;	/**< number of frames published */
+	volatile int32_t writer_pid;	/**< pid of LCDd, 0 after it exited */
+	uint32_t pad;
+
+	uint32_t width;		/**< width in characters or pixels */
+	uint32_t height;	/**< height in characters or pixels */
+	uint32_t cellwidth;	/**< character cell width in pixels */
+	uint32_t cellheight;	/**< character cell height in pixels */
+	uint32_t bytes_per_line;	/**< bytes per row of screen data */
+
+	uint32_t data_offset;	/**< offset of the screen data */
+	uint32_t data_size;	/**< size of the screen data */
+	uint32_t chars_offset;	/**< offset of the custom characters, 0 if none */
+	uint32_t chars_size;	/**< SHM_LCD_CUSTOM_CHARS * cellheight bytes */
+
+	int32_t cursor_x;	/**< 1-based cursor column */
+	int32_t cursor_y;	/**< 1-based cursor row */
+	int32_t cursor_type;	/**< CURSOR_* value from lcd.h */
+	int32_t backlight;	/**< BACKLIGHT_ON or BACKLIGHT_OFF */
+	int32_t brightness;	/**< current brightness in promille */
+	int32_t contrast;	/**< contrast in promille */
+
+	uint32_t reserved[8];
+} ShmLcdHeader;
+
+/** Writer handle of a shared memory segment */
+typedef struct shm_lcd {
+	char *name;		/**< name of the shared memory object */
+	ShmLcdHeader *hdr;	/**< the mapped segment */
+	size_t size;		/**< size of the mapping */
+} ShmLcd;
+
+ShmLcd *shm_lcd_create(const char *name, int mode, int type, int width, int height,
+		       int cellwidth, int cellheight, int bytes_per_line);
+void shm_lcd_destroy(ShmLcd *shm);
+
+/** Pointer to the screen data of a segment. */
+#define shm_lcd_data(hdr)	((unsigned char *) (hdr) + (hdr)->data_offset)
+/** Pointer to the custom character bitmaps of a segment. */
+#define shm_lcd_chars(hdr)	((unsigned char *) (hdr) + (hdr)->chars_offset)
+
+
+/**
+ * Start an update of the segment. Must be paired with shm_lcd_write_end().
+ * \param hdr  Segment header.
+ */
+static inline void
+shm_lcd_write_begin(ShmLcdHeader *hdr)
+{
+	hdr->seq++;
+	__sync_synchronize();
+}
+
+/**
+ * Finish an update of the segment, publish it as a new frame and wake up
+ * waiting readers.
+ * \param hdr  Segment header.
+ */
+static inline void
+shm_lcd_write_end(ShmLcdHeader *hdr)
+{
+	hdr->frame++;
+	__sync_synchronize();
+	hdr->seq++;
+	__sync_synchronize();
+#ifdef HAVE_LINUX_FUTEX_H
+	/* Cheap if nobody waits; readers cannot announce themselves read-only */
+	syscall(SYS_futex, &hdr->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+/**
+ * Start reading the segment.
+ * \param hdr  Segment header.
+ * \return     Sequence number to pass to shm_lcd_read_retry().
+ */
+static inline uint32_t
+shm_lcd_read_begin(const ShmLcdHeader *hdr)
+{
+	uint32_t seq;
+
+	while ((seq = hdr->seq) & 1)
+		sched_yield();
+	__sync_synchronize();
+	return seq;
+}
+
+/**
+ * Check whether data read since shm_lcd_read_begin() is consistent.
+ * \param hdr  Segment header.
+ * \param seq  Value returned by shm_lcd_read_begin().
+ * \retval 0   Data is consistent.
+ * \retval 1   Writer interfered, read again.
+ */
+static inline int
+shm_lcd_read_retry(const ShmLcdHeader *hdr, uint32_t seq)
+{
+	__sync_synchronize();
+	return (hdr->seq != seq);
+}
+
+/**
+ * Wait until a frame newer than the one read with sequence number \c seq
+ * has been published.
+ * \param hdr         Segment header.
+ * \param seq         Sequence number of the last frame read.
+ * \param timeout_ms  Maximum time to wait in milliseconds.
+ */
+static inline void
+shm_lcd_wait(const ShmLcdHeader *hdr, uint32_t seq, int timeout_ms)
+{
+#ifdef HAVE_LINUX_FUTEX_H
+	struct timespec ts;
+
+	ts.tv_sec = timeout_ms / 1000;
+	ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+	if (hdr->seq == seq)
+		syscall(SYS_futex, &hdr->seq, FUTEX_WAIT, seq, &ts, NULL, 0);
+#else
+	while ((hdr->seq == seq) && (timeout_ms > 0)) {
+		usleep(10000);
+		timeout_ms -= 10;
+	}
+#endif
+}
+
+#endif
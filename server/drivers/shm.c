@@ -0,0 +1,468 @@
+/** \file server/drivers/shm.c
+ * LCDd \c shm driver publishing the display contents in shared memory.
+ *
+ * The character grid, the custom characters, cursor and backlight state are
+ * written to a POSIX shared memory object on each flush that changes
+ * anything. Local programs (OSD overlays, status pages, test scripts) map
+ * the object and read the frames directly. See shm-lcd.h for the layout
+ * and the locking protocol.
+ */
+
+/*-
+ * This file is released under the GNU General Public License. Refer to the
+ * COPYING file distributed with this package.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "lcd.h"
+#include "shm.h"
+#include "shm-lcd.h"
+#include "report.h"
+
+
+/** private data for the \c shm driver */
+typedef struct shm_private_data {
+	int width;		/**< display width in characters */
+	int height;		/**< display height in characters */
+	int cellwidth;		/**< character cell width */
+	int cellheight;		/**< character cell height */
+	char *framebuf;		/**< frame buffer */
+
+	unsigned char custom_chars[SHM_LCD_CUSTOM_CHARS * SHMDRV_DEFAULT_CELLHEIGHT];
+	int cursor_x;		/**< cursor column */
+	int cursor_y;		/**< cursor row */
+	int cursor_type;	/**< cursor appearance */
+	int backlight;		/**< backlight state */
+	int contrast;		/**< current contrast */
+	int brightness;		/**< current brightness (for backlight on) */
+	int offbrightness;	/**< current brightness (for backlight off) */
+	int state_changed;	/**< anything but the framebuffer changed */
+
+	ShmLcd *shm;		/**< the shared memory segment */
+} PrivateData;
+
+
+/* Vars for the server core */
+MODULE_EXPORT char *api_version = API_VERSION;
+MODULE_EXPORT int stay_in_foreground = 0;
+MODULE_EXPORT int supports_multiple = 1;
+MODULE_EXPORT char *symbol_prefix = "shm_";
+
+
+/**
+ * Initialize the driver.
+ * \param drvthis  Pointer to driver structure.
+ * \retval 0       Success.
+ * \retval <0      Error.
+ */
+MODULE_EXPORT int
+shm_init (Driver *drvthis)
+{
+	PrivateData *p;
+	char buf[256];
+	const char *name;
+
+	/* Allocate and store private data */
+	p = (PrivateData *) calloc(1, sizeof(PrivateData));
+	if (p == NULL)
+		return -1;
+	if (drvthis->store_private_ptr(drvthis, p))
+		return -1;
+
+	/* initialize private data */
+	p->cellwidth = SHMDRV_DEFAULT_CELLWIDTH;
+	p->cellheight = SHMDRV_DEFAULT_CELLHEIGHT;
+	p->cursor_type = CURSOR_OFF;
+	p->backlight = BACKLIGHT_ON;
+	p->contrast = SHMDRV_DEFAULT_CONTRAST;
+	p->brightness = SHMDRV_DEFAULT_BRIGHTNESS;
+	p->offbrightness = SHMDRV_DEFAULT_OFFBRIGHTNESS;
+
+	// Set display sizes
+	if ((drvthis->request_display_width() > 0)
+	    && (drvthis->request_display_height() > 0)) {
+		// Use size from primary driver
+		p->width = drvthis->request_display_width();
+		p->height = drvthis->request_display_height();
+	}
+	else {
+		/* Use our own size from config file */
+		strncpy(buf, drvthis->config_get_string(drvthis->name, "Size", 0, SHMDRV_DEFAULT_SIZE), sizeof(buf));
+		buf[sizeof(buf)-1] = '\0';
+		if ((sscanf(buf , "%dx%d", &p->width, &p->height) != 2)
+		    || (p->width <= 0) || (p->width > LCD_MAX_WIDTH)
+		    || (p->height <= 0) || (p->height > LCD_MAX_HEIGHT)) {
+			report(RPT_WARNING, "%s: cannot read Size: %s; using default %s",
+					drvthis->name, buf, SHMDRV_DEFAULT_SIZE);
+			sscanf(SHMDRV_DEFAULT_SIZE, "%dx%d", &p->width, &p->height);
+		}
+	}
+
+	// Allocate the framebuffer
+	p->framebuf = malloc(p->width * p->height);
+	if (p->framebuf == NULL) {
+		report(RPT_ERR, "%s: unable to create framebuffer", drvthis->name);
+		return -1;
+	}
+	memset(p->framebuf, ' ', p->width * p->height);
+
+	/* Create the shared memory segment */
+	name = drvthis->config_get_string(drvthis->name, "Name", 0, SHM_LCD_DEFAULT_NAME);
+	if ((name[0] != '/') || (strchr(name + 1, '/') != NULL)) {
+		report(RPT_ERR, "%s: Name must start with '/' and contain no other '/': %s",
+				drvthis->name, name);
+		return -1;
+	}
+	p->shm = shm_lcd_create(name, 0644, SHM_LCD_TEXT, p->width, p->height,
+				p->cellwidth, p->cellheight, p->width);
+	if (p->shm == NULL) {
+		report(RPT_ERR, "%s: unable to create shared memory %s: %s",
+				drvthis->name, name, strerror(errno));
+		return -1;
+	}
+	p->state_changed = 1;
+
+	report(RPT_INFO, "%s: publishing %dx%d display as %s",
+			drvthis->name, p->width, p->height, name);
+	report(RPT_DEBUG, "%s: init() done", drvthis->name);
+
+	return 0;
+}
+
+
+/**
+ * Close the driver (do necessary clean-up).
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+shm_close (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if (p != NULL) {
+		shm_lcd_destroy(p->shm);
+
+		if (p->framebuf != NULL)
+			free(p->framebuf);
+
+		free(p);
+	}
+	drvthis->store_private_ptr(drvthis, NULL);
+}
+
+
+/**
+ * Return the display width in characters.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of characters the display is wide.
+ */
+MODULE_EXPORT int
+shm_width (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->width;
+}
+
+
+/**
+ * Return the display height in characters.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of characters the display is high.
+ */
+MODULE_EXPORT int
+shm_height (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->height;
+}
+
+
+/**
+ * Return the width of a character in pixels.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of pixel columns a character cell is wide.
+ */
+MODULE_EXPORT int
+shm_cellwidth (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->cellwidth;
+}
+
+
+/**
+ * Return the height of a character in pixels.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Number of pixel lines a character cell is high.
+ */
+MODULE_EXPORT int
+shm_cellheight (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->cellheight;
+}
+
+
+/**
+ * Clear the screen.
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+shm_clear (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	memset(p->framebuf, ' ', p->width * p->height);
+}
+
+
+/**
+ * Publish the screen in shared memory. Nothing is written (and readers are
+ * not woken up) if neither the screen nor any other state has changed.
+ * \param drvthis  Pointer to driver structure.
+ */
+MODULE_EXPORT void
+shm_flush (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+	ShmLcdHeader *hdr = p->shm->hdr;
+
+	/* We are the only writer, so the segment can be compared without lock */
+	if (!p->state_changed
+	    && (memcmp(shm_lcd_data(hdr), p->framebuf, p->width * p->height) == 0))
+		return;
+
+	shm_lcd_write_begin(hdr);
+	memcpy(shm_lcd_data(hdr), p->framebuf, p->width * p->height);
+	memcpy(shm_lcd_chars(hdr), p->custom_chars, hdr->chars_size);
+	hdr->cursor_x = p->cursor_x;
+	hdr->cursor_y = p->cursor_y;
+	hdr->cursor_type = p->cursor_type;
+	hdr->backlight = p->backlight;
+	hdr->brightness = (p->backlight == BACKLIGHT_ON) ? p->brightness : p->offbrightness;
+	hdr->contrast = p->contrast;
+	shm_lcd_write_end(hdr);
+
+	p->state_changed = 0;
+}
+
+
+/**
+ * Print a string on the screen at position (x,y).
+ * The upper-left corner is (1,1), the lower-right corner is (p->width, p->height).
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column).
+ * \param y        Vertical character position (row).
+ * \param string   String that gets written.
+ */
+MODULE_EXPORT void
+shm_string (Driver *drvthis, int x, int y, const char string[])
+{
+	PrivateData *p = drvthis->private_data;
+	int i;
+
+	x--; y--; // Convert 1-based coords to 0-based...
+
+	if ((y < 0) || (y >= p->height))
+		return;
+
+	for (i = 0; (string[i] != '\0') && (x < p->width); i++, x++) {
+		if (x >= 0)	// no write left of left border
+			p->framebuf[(y * p->width) + x] = string[i];
+	}
+}
+
+
+/**
+ * Print a character on the screen at position (x,y).
+ * The upper-left corner is (1,1), the lower-right corner is (p->width, p->height).
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal character position (column).
+ * \param y        Vertical character position (row).
+ * \param c        Character that gets written.
+ */
+MODULE_EXPORT void
+shm_chr (Driver *drvthis, int x, int y, char c)
+{
+	PrivateData *p = drvthis->private_data;
+
+	y--; x--;
+
+	if ((x >= 0) && (y >= 0) && (x < p->width) && (y < p->height))
+		p->framebuf[(y * p->width) + x] = c;
+}
+
+
+/**
+ * Set cursor position and state.
+ * \param drvthis  Pointer to driver structure.
+ * \param x        Horizontal cursor position (column).
+ * \param y        Vertical cursor position (row).
+ * \param type     Appearance of the cursor
+ */
+MODULE_EXPORT void
+shm_cursor (Driver *drvthis, int x, int y, int type)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if ((p->cursor_x != x) || (p->cursor_y != y) || (p->cursor_type != type)) {
+		p->cursor_x = x;
+		p->cursor_y = y;
+		p->cursor_type = type;
+		p->state_changed = 1;
+	}
+}
+
+
+/**
+ * Define a custom character.
+ * \param drvthis  Pointer to driver structure.
+ * \param n        Custom character to define [0 - (NUM_CCs-1)].
+ * \param dat      Array of 8 (=cellheight) bytes, each representing a pixel row
+ *                 starting from the top to bottom.
+ *                 The bits in each byte represent the pixels where the LSB
+ *                 (least significant bit) is the rightmost pixel in each pixel row.
+ */
+MODULE_EXPORT void
+shm_set_char (Driver *drvthis, int n, char *dat)
+{
+	PrivateData *p = drvthis->private_data;
+	unsigned char mask = (1 << p->cellwidth) - 1;
+	int row;
+
+	if ((n < 0) || (n >= SHM_LCD_CUSTOM_CHARS) || (dat == NULL))
+		return;
+
+	for (row = 0; row < p->cellheight; row++) {
+		unsigned char letter = dat[row] & mask;
+
+		if (p->custom_chars[n * p->cellheight + row] != letter) {
+			p->custom_chars[n * p->cellheight + row] = letter;
+			p->state_changed = 1;
+		}
+	}
+}
+
+
+/**
+ * Get total number of custom characters available.
+ * \param drvthis  Pointer to driver structure.
+ * \return  Number of custom characters.
+ */
+MODULE_EXPORT int
+shm_get_free_chars (Driver *drvthis)
+{
+	return SHM_LCD_CUSTOM_CHARS;
+}
+
+
+/**
+ * Get current contrast.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Stored contrast in promille.
+ */
+MODULE_EXPORT int
+shm_get_contrast (Driver *drvthis)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return p->contrast;
+}
+
+
+/**
+ * Change the contrast. It is only passed on to the readers.
+ * \param drvthis  Pointer to driver structure.
+ * \param promille New contrast value in promille.
+ */
+MODULE_EXPORT void
+shm_set_contrast (Driver *drvthis, int promille)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if ((promille < 0) || (promille > 1000) || (promille == p->contrast))
+		return;
+
+	p->contrast = promille;
+	p->state_changed = 1;
+}
+
+
+/**
+ * Retrieve brightness.
+ * \param drvthis  Pointer to driver structure.
+ * \param state    Brightness state (on/off) for which we want the value.
+ * \return         Stored brightness in promille.
+ */
+MODULE_EXPORT int
+shm_get_brightness (Driver *drvthis, int state)
+{
+	PrivateData *p = drvthis->private_data;
+
+	return (state == BACKLIGHT_ON) ? p->brightness : p->offbrightness;
+}
+
+
+/**
+ * Set on/off brightness. It is only passed on to the readers.
+ * \param drvthis  Pointer to driver structure.
+ * \param state    Brightness state (on/off) for which we want to store the value.
+ * \param promille New brightness in promille.
+ */
+MODULE_EXPORT void
+shm_set_brightness (Driver *drvthis, int state, int promille)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if ((promille < 0) || (promille > 1000))
+		return;
+
+	if (state == BACKLIGHT_ON)
+		p->brightness = promille;
+	else
+		p->offbrightness = promille;
+	p->state_changed = 1;
+}
+
+
+/**
+ * Turn the backlight on or off.
+ * \param drvthis  Pointer to driver structure.
+ * \param on       New backlight status.
+ */
+MODULE_EXPORT void
+shm_backlight (Driver *drvthis, int on)
+{
+	PrivateData *p = drvthis->private_data;
+
+	if (p->backlight != on) {
+		p->backlight = on;
+		p->state_changed = 1;
+	}
+}
+
+
+/**
+ * Provide some information about this driver.
+ * \param drvthis  Pointer to driver structure.
+ * \return         Constant string with information.
+ */
+MODULE_EXPORT const char *
+shm_get_info (Driver *drvthis)
+{
+	static char *info_string = "Shared memory driver";
+
+	return info_string;
+}
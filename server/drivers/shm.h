@@ -0,0 +1,31 @@
+#ifndef LCD_SHM_H
+#define LCD_SHM_H
+
+MODULE_EXPORT int  shm_init (Driver *drvthis);
+MODULE_EXPORT void shm_close (Driver *drvthis);
+MODULE_EXPORT int  shm_width (Driver *drvthis);
+MODULE_EXPORT int  shm_height (Driver *drvthis);
+MODULE_EXPORT int  shm_cellwidth (Driver *drvthis);
+MODULE_EXPORT int  shm_cellheight (Driver *drvthis);
+MODULE_EXPORT void shm_clear (Driver *drvthis);
+MODULE_EXPORT void shm_flush (Driver *drvthis);
+MODULE_EXPORT void shm_string (Driver *drvthis, int x, int y, const char string[]);
+MODULE_EXPORT void shm_chr (Driver *drvthis, int x, int y, char c);
+MODULE_EXPORT void shm_cursor (Driver *drvthis, int x, int y, int type);
+MODULE_EXPORT void shm_set_char (Driver *drvthis, int n, char *dat);
+MODULE_EXPORT int  shm_get_free_chars (Driver *drvthis);
+MODULE_EXPORT int  shm_get_contrast (Driver *drvthis);
+MODULE_EXPORT void shm_set_contrast (Driver *drvthis, int promille);
+MODULE_EXPORT int  shm_get_brightness (Driver *drvthis, int state);
+MODULE_EXPORT void shm_set_brightness (Driver *drvthis, int state, int promille);
+MODULE_EXPORT void shm_backlight (Driver *drvthis, int on);
+MODULE_EXPORT const char * shm_get_info (Driver *drvthis);
+
+#define SHMDRV_DEFAULT_SIZE		"20x4"
+#define SHMDRV_DEFAULT_CELLWIDTH	5
+#define SHMDRV_DEFAULT_CELLHEIGHT	8
+#define SHMDRV_DEFAULT_CONTRAST		500
+#define SHMDRV_DEFAULT_BRIGHTNESS	1000
+#define SHMDRV_DEFAULT_OFFBRIGHTNESS	0
+
+#endif
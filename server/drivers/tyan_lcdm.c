@@ -434,7 +434,7 @@ tyan_lcdm_hbar (Driver *drvthis, int x, int y, int len, int promille, int option
 		}
 	}
 
-	lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+	lib_hbar_string(drvthis, x, y, len, promille, options, p->cellwidth, 0, 0xFF);
 }
 
 
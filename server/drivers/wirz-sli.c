@@ -373,7 +373,7 @@ sli_hbar (Driver *drvthis, int x, int y, int len, int promille, int options)
 
 	sli_init_hbar(drvthis);
 
-	lib_hbar_static(drvthis, x, y, len, promille, options, p->cellwidth, 0);
+	lib_hbar_string(drvthis, x, y, len, promille, options, p->cellwidth, 0, 0xFF);
 }
 
 /////////////////////////////////////////////////////////////////
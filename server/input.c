@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 
 #include "shared/sockets.h"
 #include "shared/report.h"
@@ -31,8 +32,46 @@
 #include "input.h"
 #include "render.h" /* For server_msg* */
 
+/** Size of the key event queue */
+#define KEY_QUEUE_SIZE		64
+/** Maximum number of keys read from one driver per call of handle_input() */
+#define KEY_READS_PER_DRIVER	16
+/** Maximum length of a key name (including terminating 0) */
+#define KEY_NAME_LEN		64
+
+/** A key event read from an input driver */
+typedef struct KeyEvent {
+	char key[KEY_NAME_LEN];	/**< name of the key */
+	Client *target;		/**< client it is sent to, NULL for the server */
+} KeyEvent;
+
+/** Key events read by input_read_keys(), in dispatch order */
+static KeyEvent key_queue[KEY_QUEUE_SIZE];
+static int key_queue_len;
+
+/** Number of buckets of the key name hash table (power of 2) */
+#define KEY_HASH_SIZE		64
+/** Number of buckets of the per client reservation index (power of 2) */
+#define CLIENT_HASH_SIZE	64
+
+/** A key name interned by input_intern_key() */
+typedef struct KeyName {
+	char *name;		/**< name of the key */
+	unsigned int hash;	/**< hash of the name */
+	int id;			/**< index into key_ids */
+	int refs;		/**< number of reservations of the key */
+	KeyReservation *reservations;	/**< reservations of the key */
+	struct KeyName *next;	/**< next name in the hash bucket */
+} KeyName;
+
+/** Interned key names by hash */
+static KeyName *key_hash[KEY_HASH_SIZE];
+/** Interned key names by id; unused ids are NULL */
+static KeyName **key_ids;
+static int key_ids_size;
+/** Key reservations by client */
+static KeyReservation *client_index[CLIENT_HASH_SIZE];
 
-LinkedList *keylist;
 char *toggle_rotate_key;
 char *prev_screen_key;
 char *next_screen_key;
@@ -41,15 +80,22 @@ char *scroll_down_key;
 
 /* Local functions */
 int server_input(int key);
-void input_send_to_client(Client *c, const char *key);
+static void input_read_keys(void);
+static void input_send_keys(void);
 void input_internal_key(const char *key);
+static KeyName *input_lookup_key(const char *key);
 
 
 int input_init(void)
 {
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	keylist = LL_new();
+	key_ids_size = 32;
+	key_ids = calloc(key_ids_size, sizeof(KeyName *));
+	if (key_ids == NULL) {
+		report(RPT_ERR, "%s: malloc failure", __FUNCTION__);
+		return -1;
+	}
 
 	/* Get rotate/scroll keys from config file */
 	toggle_rotate_key = strdup(config_get_string("server", "ToggleRotateKey", 0, "Enter"));
@@ -64,12 +110,20 @@ int input_init(void)
 
 int input_shutdown()
 {
-	if (!keylist) {
+	int i;
+
+	if (!key_ids) {
 		/* Program shutdown before completed startup */
 		return -1;
 	}
 
-	free(keylist);
+	/* Releasing the last reservation of a key frees its name */
+	for (i = 0; i < CLIENT_HASH_SIZE; i++) {
+		while (client_index[i] != NULL)
+			input_release_client_keys(client_index[i]->client);
+	}
+	free(key_ids);
+	key_ids = NULL;
 
 	free(toggle_rotate_key);
 	free(prev_screen_key);
@@ -81,14 +135,93 @@ int input_shutdown()
 }
 
 
+/**
+ * Read the pending keys of all drivers into the key queue.
+ *
+ * Drivers are asked round-robin, one key per driver at a time, so a driver
+ * producing a constant stream of keys (e.g. a repeating remote) can neither
+ * block nor delay keys from other drivers. Repeated keys are kept as
+ * separate events, drivers do not tell auto-repeat from real key presses.
+ * When the queue is full, the remaining keys are left in the drivers and
+ * read on the next call.
+ */
+static void
+input_read_keys(void)
+{
+	int num = drivers_count();
+	int active[num];	/* driver may still have keys */
+	int source, round, more;
+	const char *key;
+
+	key_queue_len = 0;
+	if (num <= 0)
+		return;
+	for (source = 0; source < num; source++)
+		active[source] = 1;
+
+	for (round = 0, more = 1; more && (round < KEY_READS_PER_DRIVER); round++) {
+		more = 0;
+		for (source = 0; source < num; source++) {
+			KeyEvent *ev;
+
+			if (!active[source])
+				continue;
+			if (key_queue_len >= KEY_QUEUE_SIZE)
+				return;
+			if ((key = drivers_get_key(source)) == NULL) {
+				active[source] = 0;
+				continue;
+			}
+			more = 1;
+
+			ev = &key_queue[key_queue_len];
+			strncpy(ev->key, key, KEY_NAME_LEN - 1);
+			ev->key[KEY_NAME_LEN - 1] = '\0';
+			ev->target = NULL;
+			key_queue_len++;
+		}
+	}
+}
+
+
+/**
+ * Send the queued keys of each client with one write per client.
+ */
+static void
+input_send_keys(void)
+{
+	char buf[KEY_QUEUE_SIZE * (KEY_NAME_LEN + sizeof("key \n"))];
+	int i, j;
+
+	for (i = 0; i < key_queue_len; i++) {
+		Client *c = key_queue[i].target;
+		size_t len = 0;
+
+		if (c == NULL)
+			continue;
+
+		/* Collect all keys of this client in queue order */
+		for (j = i; j < key_queue_len; j++) {
+			if (key_queue[j].target == c) {
+				len += snprintf(buf + len, sizeof(buf) - len, "key %s\n",
+						key_queue[j].key);
+				key_queue[j].target = NULL;
+			}
+		}
+		debug(RPT_DEBUG, "%s: sending %d bytes to client on socket %d",
+		      __FUNCTION__, (int) len, c->sock);
+		sock_send(c->sock, buf, len);
+	}
+}
+
+
 int
 handle_input(void)
 {
-	const char *key;
 	Screen *current_screen;
 	Client *current_client;
-	Client *target;
 	KeyReservation *kr;
+	int i;
 
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
@@ -99,48 +232,35 @@ handle_input(void)
 		current_client = NULL;
 
 	/* Handle all keypresses */
-	while ((key = drivers_get_key()) != NULL) {
+	input_read_keys();
+	for (i = 0; i < key_queue_len; i++) {
+		KeyEvent *ev = &key_queue[i];
 
 		/* Find what client wants the key */
-		kr = input_find_key(key, current_client);
+		kr = input_find_key(ev->key, current_client);
 		if (kr) {
 			/* A hit ! */
-			report(RPT_DEBUG, "%s: reserved key: \"%.40s\"", __FUNCTION__, key);
-			target = kr->client;
+			report(RPT_DEBUG, "%s: reserved key: \"%.40s\"", __FUNCTION__, ev->key);
+			ev->target = kr->client;
 		} else {
-			report(RPT_DEBUG, "%s: left over key: \"%.40s\"", __FUNCTION__, key);
+			report(RPT_DEBUG, "%s: left over key: \"%.40s\"", __FUNCTION__, ev->key);
 			/*target = current_client;*/
-			target = NULL; /* left-over keys are always for internal client */
+			ev->target = NULL; /* left-over keys are always for internal client */
 		}
-		if (target == NULL) {
+		if (ev->target == NULL) {
 			report(RPT_DEBUG, "%s: key is for internal client", __FUNCTION__);
-			input_internal_key(key);
+			input_internal_key(ev->key);
 		} else {
 			/* It's an external client */
-			report(RPT_DEBUG, "%s: key is for external client on socket %d", __FUNCTION__, target->sock);
-			input_send_to_client(target, key);
+			report(RPT_DEBUG, "%s: key is for external client on socket %d", __FUNCTION__, ev->target->sock);
 		}
 	}
-	return 0;
-}
 
+	/* Keys for external clients are sent in one write per client */
+	input_send_keys();
+	key_queue_len = 0;
 
-void input_send_to_client(Client *c, const char *key)
-{
-	char *s;
-	size_t size = strlen(key) + sizeof("key %s\n"); // this is large enough
-
-	debug(RPT_DEBUG, "%s(client=[%d], key=\"%.40s\")", __FUNCTION__, c->sock, key);
-
-	/* Allocate just as much as we need */
-	s = calloc(1, size);
-	if (s != NULL) {
-		snprintf(s, size, "key %s\n", key);
-		sock_send_string(c->sock, s);
-		free(s);
-	}
-	else
-		report(RPT_ERR, "%s: malloc failure", __FUNCTION__);
+	return 0;
 }
 
 
@@ -175,9 +295,153 @@ input_internal_key(const char *key)
 	}
 }
 
+/**
+ * Hash function for key names (FNV-1a).
+ * \param key  Name of the key.
+ * \return     Hash value.
+ */
+static unsigned int
+input_hash_key(const char *key)
+{
+	unsigned int hash = 2166136261u;
+
+	while (*key != '\0') {
+		hash ^= (unsigned char) *key++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/**
+ * Get the bucket of the per client reservation index for a client.
+ * \param client  The client, NULL for internal clients.
+ * \return        Pointer to the head of the bucket's list.
+ */
+static KeyReservation **
+input_client_bucket(Client *client)
+{
+	uintptr_t h = (uintptr_t) client;
+
+	return &client_index[(h ^ (h >> 7) ^ (h >> 13)) & (CLIENT_HASH_SIZE - 1)];
+}
+
+
+/**
+ * Look up an interned key name.
+ * \param key  Name of the key.
+ * \return     Pointer to the interned name, NULL if the key is not reserved.
+ */
+static KeyName *
+input_lookup_key(const char *key)
+{
+	unsigned int hash = input_hash_key(key);
+	KeyName *kn;
+
+	for (kn = key_hash[hash & (KEY_HASH_SIZE - 1)]; kn != NULL; kn = kn->next) {
+		if ((kn->hash == hash) && (strcmp(kn->name, key) == 0))
+			return kn;
+	}
+	return NULL;
+}
+
+
+/**
+ * Intern a key name, i.e. get the unique KeyName of a key and assign it an
+ * id if it does not have one yet.
+ * \param key  Name of the key.
+ * \return     Pointer to the interned name, NULL on error.
+ */
+static KeyName *
+input_intern_key(const char *key)
+{
+	KeyName *kn;
+	int id;
+
+	if ((kn = input_lookup_key(key)) != NULL)
+		return kn;
+
+	/* Find an unused id, grow the table if there is none */
+	for (id = 0; (id < key_ids_size) && (key_ids[id] != NULL); id++)
+		;
+	if (id == key_ids_size) {
+		KeyName **tmp = realloc(key_ids, 2 * key_ids_size * sizeof(KeyName *));
+
+		if (tmp == NULL)
+			return NULL;
+		memset(tmp + key_ids_size, 0, key_ids_size * sizeof(KeyName *));
+		key_ids = tmp;
+		key_ids_size *= 2;
+	}
+
+	kn = calloc(1, sizeof(KeyName));
+	if (kn == NULL)
+		return NULL;
+	kn->name = strdup(key);
+	if (kn->name == NULL) {
+		free(kn);
+		return NULL;
+	}
+	kn->hash = input_hash_key(key);
+	kn->id = id;
+	kn->next = key_hash[kn->hash & (KEY_HASH_SIZE - 1)];
+	key_hash[kn->hash & (KEY_HASH_SIZE - 1)] = kn;
+	key_ids[id] = kn;
+
+	return kn;
+}
+
+
+/**
+ * Remove a reservation from both indexes and free it. The key name is
+ * freed with its last reservation.
+ * \param kr  The reservation.
+ */
+static void
+input_free_reservation(KeyReservation *kr)
+{
+	KeyName *kn = key_ids[kr->key_id];
+	KeyReservation **pkr;
+
+	report(RPT_INFO, "Key \"%.40s\" reserved %s by client [%d] and is now released",
+		kr->key, (kr->exclusive ? "exclusively" : "shared"),
+		(kr->client ? kr->client->sock : -1));
+
+	for (pkr = &kn->reservations; *pkr != NULL; pkr = &(*pkr)->next_by_key) {
+		if (*pkr == kr) {
+			*pkr = kr->next_by_key;
+			break;
+		}
+	}
+	for (pkr = input_client_bucket(kr->client); *pkr != NULL; pkr = &(*pkr)->next_by_client) {
+		if (*pkr == kr) {
+			*pkr = kr->next_by_client;
+			break;
+		}
+	}
+	free(kr);
+
+	if (--kn->refs == 0) {
+		KeyName **pkn;
+
+		for (pkn = &key_hash[kn->hash & (KEY_HASH_SIZE - 1)]; *pkn != NULL; pkn = &(*pkn)->next) {
+			if (*pkn == kn) {
+				*pkn = kn->next;
+				break;
+			}
+		}
+		key_ids[kn->id] = NULL;
+		free(kn->name);
+		free(kn);
+	}
+}
+
+
 int input_reserve_key(const char *key, bool exclusive, Client *client)
 {
+	KeyName *kn;
 	KeyReservation *kr;
+	KeyReservation **bucket;
 
 	debug(RPT_DEBUG, "%s(key=\"%.40s\", exclusive=%d, client=[%d])",
 		__FUNCTION__, key, exclusive, (client?client->sock:-1));
@@ -185,8 +449,9 @@ int input_reserve_key(const char *key, bool exclusive, Client *client)
 	/* Find out if this key is already reserved in a way that interferes
 	 * with the new reservation.
 	 */
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
-		if (strcmp(kr->key, key) == 0) {
+	kn = input_lookup_key(key);
+	if (kn != NULL) {
+		for (kr = kn->reservations; kr != NULL; kr = kr->next_by_key) {
 			if (kr->exclusive || exclusive) {
 				/* Sorry ! */
 				return -1;
@@ -196,10 +461,21 @@ int input_reserve_key(const char *key, bool exclusive, Client *client)
 
 	/* We can now safely add it ! */
 	kr = malloc(sizeof(KeyReservation));
-	kr->key = strdup(key);
+	if (kr == NULL || (kn = input_intern_key(key)) == NULL) {
+		report(RPT_ERR, "%s: malloc failure", __FUNCTION__);
+		free(kr);
+		return -1;
+	}
+	kr->key = kn->name;
+	kr->key_id = kn->id;
 	kr->exclusive = exclusive;
 	kr->client = client;
-	LL_Push(keylist, kr);
+	kr->next_by_key = kn->reservations;
+	kn->reservations = kr;
+	bucket = input_client_bucket(client);
+	kr->next_by_client = *bucket;
+	*bucket = kr;
+	kn->refs++;
 
 	report(RPT_INFO, "Key \"%.40s\" is now reserved %s by client [%d]",
 		key, (exclusive ? "exclusively" : "shared"), (client ? client->sock : -1));
@@ -209,17 +485,17 @@ int input_reserve_key(const char *key, bool exclusive, Client *client)
 
 void input_release_key(const char *key, Client *client)
 {
+	KeyName *kn;
 	KeyReservation *kr;
 
 	debug(RPT_DEBUG, "%s(key=\"%.40s\", client=[%d])", __FUNCTION__, key, (client ? client->sock : -1));
 
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
-		if ((kr->client == client) && (strcmp(kr->key, key) == 0)) {
-			report(RPT_INFO, "Key \"%.40s\" reserved %s by client [%d] and is now released",
-				key, (kr->exclusive ? "exclusively" : "shared"), (client ? client->sock : -1));
-			free(kr->key);
-			free(kr);
-			LL_DeleteNode(keylist, NEXT);
+	if ((kn = input_lookup_key(key)) == NULL)
+		return;
+
+	for (kr = kn->reservations; kr != NULL; kr = kr->next_by_key) {
+		if (kr->client == client) {
+			input_free_reservation(kr);
 			return;
 		}
 	}
@@ -228,32 +504,30 @@ void input_release_key(const char *key, Client *client)
 void input_release_client_keys(Client *client)
 {
 	KeyReservation *kr;
+	KeyReservation *next;
 
 	debug(RPT_DEBUG, "%s(client=[%d])", __FUNCTION__, (client ? client->sock : -1));
 
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
-		if (kr->client == client) {
-			report(RPT_INFO, "Key \"%.40s\" reserved %s by client [%d] and is now released",
-				kr->key, (kr->exclusive ? "exclusively" : "shared"), (client ? client->sock : -1));
-			free(kr->key);
-			free(kr);
-			// jump to node before deleted one to not miss any
-			LL_DeleteNode(keylist, PREV);
-		}
+	for (kr = *input_client_bucket(client); kr != NULL; kr = next) {
+		next = kr->next_by_client;
+		if (kr->client == client)
+			input_free_reservation(kr);
 	}
 }
 
 KeyReservation *input_find_key(const char *key, Client *client)
 {
+	KeyName *kn;
 	KeyReservation *kr;
 
 	debug(RPT_DEBUG, "%s(key=\"%.40s\", client=[%d])", __FUNCTION__, key, (client?client->sock:-1));
 
-	for (kr = LL_GetFirst(keylist); kr != NULL; kr = LL_GetNext(keylist)) {
-		if (strcmp(kr->key, key) == 0) {
-			if (kr->exclusive || client == kr->client) {
-				return kr;
-			}
+	if ((kn = input_lookup_key(key)) == NULL)
+		return NULL;
+
+	for (kr = kn->reservations; kr != NULL; kr = kr->next_by_key) {
+		if (kr->exclusive || client == kr->client) {
+			return kr;
 		}
 	}
 	return NULL;
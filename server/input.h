@@ -25,9 +25,12 @@
 int handle_input(void);
 
 typedef struct KeyReservation {
-	char *key;
+	char *key;		/* Interned name, do not free */
+	int key_id;		/* Id of the interned name */
 	bool exclusive;
 	Client *client;		/* NULL for internal clients */
+	struct KeyReservation *next_by_key;	/* Next reservation of the key */
+	struct KeyReservation *next_by_client;	/* Next in the client's index bucket */
 } KeyReservation;
 
 
@@ -236,6 +236,7 @@ main(int argc, char **argv)
 	CHAIN(e, screenlist_init());
 	CHAIN(e, init_drivers());
 	CHAIN(e, clients_init());
+	CHAIN(e, parse_init());
 	CHAIN(e, input_init());
 	CHAIN(e, menuscreens_init());
 	CHAIN(e, server_screen_init());
@@ -784,13 +785,20 @@ do_mainloop(void)
                 process_lag += t_diff;
 		if (process_lag > 0) {
 			/* Time for a processing stroke */
+			int pending;
+
 			sock_poll_clients();		/* poll clients for input*/
-			parse_all_client_messages();	/* analyze input from network clients*/
+			pending = parse_all_client_messages();	/* analyze input from network clients*/
+			drivers_wait_input(0);	/* check input fds of drivers */
 			handle_input();		/* handle key input from devices*/
 
 			/* We've done the job... */
 			process_lag = 0 - (1e6/PROCESS_FREQ);
 			/* Note : this does not make a fixed frequency */
+
+			/* Clients over their budget continue right after rendering */
+			if (pending > 0)
+				process_lag = 0;
 		}
 
 		render_lag += t_diff;
@@ -817,10 +825,11 @@ do_mainloop(void)
 			/* Note: this DOES make a fixed frequency (except with slowdown) */
 		}
 
-		/* Sleep just as long as needed */
+		/* Sleep just as long as needed, handle key input at once */
 		sleeptime = min(0-process_lag, 0-render_lag);
 		if (sleeptime > 0) {
-			usleep(sleeptime);
+			if (drivers_wait_input(sleeptime) > 0)
+				handle_input();
 		}
 
 		/* Check if a SIGHUP has been caught */
@@ -230,6 +230,12 @@ menu_destroy(Menu *menu)
 	LL_Destroy(menu->data.menu.contents);
 	menu->data.menu.contents = NULL;
 
+	/* The row widgets belong to the screen, only the arrays are ours */
+	free(menu->data.menu.rows);
+	free(menu->data.menu.row_icons);
+	menu->data.menu.rows = NULL;
+	menu->data.menu.row_icons = NULL;
+
 	/* After this the general menuitem routine destroys the rest... */
 }
 
@@ -367,8 +373,7 @@ void menu_reset(Menu *menu)
 void menu_build_screen(MenuItem *menu, Screen *s)
 {
 	Widget *w;
-	MenuItem *subitem;
-	int itemnr;
+	int row, num_rows;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], screen=[%s])", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"),
@@ -387,67 +392,52 @@ void menu_build_screen(MenuItem *menu, Screen *s)
 		w->text = strdup(menu->text);
 		w->x = 1;
 	}	
+	menu->w.text = w;
 
-	/* Create widgets for each subitem in the menu */
-	for (subitem = LL_GetFirst(menu->data.menu.contents), itemnr = 0;
-	     subitem != NULL;
-	     subitem = LL_GetNext(menu->data.menu.contents), itemnr ++)
-	{
-		char buf[10];
+	/*
+	 * Create widgets for the display lines only, however long the menu
+	 * is. menu_update_screen() binds them to the subitems in view.
+	 */
+	free(menu->data.menu.rows);
+	free(menu->data.menu.row_icons);
+	num_rows = display_props->height;
+	menu->data.menu.rows = calloc(num_rows, sizeof(Widget *));
+	menu->data.menu.row_icons = calloc(num_rows, sizeof(Widget *));
+	if ((menu->data.menu.rows == NULL) || (menu->data.menu.row_icons == NULL)) {
+		report(RPT_ERR, "%s: Could not allocate memory", __FUNCTION__);
+		free(menu->data.menu.rows);
+		free(menu->data.menu.row_icons);
+		menu->data.menu.rows = NULL;
+		menu->data.menu.row_icons = NULL;
+		num_rows = 0;
+	}
+	menu->data.menu.num_rows = num_rows;
 
-		if (subitem->is_hidden)
-			continue;
-		snprintf(buf, sizeof(buf)-1, "text%d", itemnr);
+	for (row = 0; row < num_rows; row++) {
+		char buf[16];
+
+		snprintf(buf, sizeof(buf)-1, "text%d", row);
 		buf[sizeof(buf)-1] = '\0';
-		w = widget_create(buf, WID_STRING, s);
+		w = widget_create(buf, WID_NONE, s);
 					/* (buf will be copied) */
 		if (w != NULL) {
 			screen_add_widget(s, w);
 			w->x = 2;
+			w->text = calloc(1, display_props->width + 1);
+		}
+		menu->data.menu.rows[row] = w;
 
-			switch (subitem->type) {
-			  case MENUITEM_CHECKBOX:
-
-				/* Limit string length */
-				w->text = strdup(subitem->text);
-				if (strlen(subitem->text) >= display_props->width-2)
-					w->text[display_props->width-2] = '\0';
-
-				/* Add icon for checkbox */
-				snprintf(buf, sizeof(buf)-1, "icon%d", itemnr);
-				buf[sizeof(buf)-1] = '\0';
-				w = widget_create(buf, WID_ICON, s);
-						/* (buf will be copied) */
-				screen_add_widget(s, w);
-				w->x = display_props->width - 1;
-				w->length = ICON_CHECKBOX_OFF;
-				break;
-			  case MENUITEM_RING:
-				/* Create string for text + ringtext */
-				w->text = malloc(display_props->width);
-				break;
-			  case MENUITEM_MENU:
-				/* Limit string length */
-				w->text = malloc(strlen(subitem->text) + 4);
-				strcpy(w->text, subitem->text);
-				strcat(w->text, " >");
-				if (strlen(subitem->text) >= display_props->width-1)
-					w->text[display_props->width-1] = '\0';
-				break;
-			  case MENUITEM_ACTION:
-			  case MENUITEM_SLIDER:
-			  case MENUITEM_NUMERIC:
-			  case MENUITEM_ALPHA:
-			  case MENUITEM_IP:
-				/* Limit string length */
-				w->text = malloc(display_props->width);
-				strncpy(w->text, subitem->text, display_props->width);
-				w->text[display_props->width-1] = '\0';
-				break;
-			 default:
-				assert(!"unexpected menuitem type");
-			}
+		/* Add icon for checkboxes */
+		snprintf(buf, sizeof(buf)-1, "icon%d", row);
+		buf[sizeof(buf)-1] = '\0';
+		w = widget_create(buf, WID_NONE, s);
+					/* (buf will be copied) */
+		if (w != NULL) {
+			screen_add_widget(s, w);
+			w->x = display_props->width - 1;
+			w->length = ICON_CHECKBOX_OFF;
 		}
+		menu->data.menu.row_icons[row] = w;
 	}
 
 	/* Add arrow for selection on the left */
@@ -457,6 +447,7 @@ void menu_build_screen(MenuItem *menu, Screen *s)
 		w->length = ICON_SELECTOR_AT_LEFT;
 		w->x = 1;
 	}
+	menu->data.menu.selector = w;
 
 	/* Add scrollers on the right side on top and bottom */
 	/* TODO: when menu is in a frame, these can be removed */
@@ -467,6 +458,7 @@ void menu_build_screen(MenuItem *menu, Screen *s)
 		w->x = display_props->width;
 		w->y = 1;
 	}
+	menu->data.menu.upscroller = w;
 
 	w = widget_create("downscroller", WID_ICON, s);
 	if (w != NULL) {
@@ -475,7 +467,71 @@ void menu_build_screen(MenuItem *menu, Screen *s)
 		w->x = display_props->width;
 		w->y = display_props->height;
 	}
+	menu->data.menu.downscroller = w;
+}
 
+
+/**
+ * Show a subitem of a menu on a display line.
+ * \param subitem  The subitem.
+ * \param w        String widget of the line.
+ * \param icon     Icon widget of the line (used for checkboxes).
+ * \param y        Display line.
+ */
+static void
+menu_update_row(MenuItem *subitem, Widget *w, Widget *icon, int y)
+{
+	char buf[LCD_MAX_WIDTH];
+	char *p;
+	int len = display_props->width - 1;
+
+	w->y = y;
+	w->type = WID_STRING;
+
+	switch (subitem->type) {
+	  case MENUITEM_CHECKBOX:
+		/* Limit string length to leave room for the icon */
+		snprintf(w->text, len, "%s", subitem->text);
+
+		/* Update icon value for checkbox */
+		if (icon != NULL) {
+			icon->y = y;
+			icon->length = ((int[]){ICON_CHECKBOX_OFF,ICON_CHECKBOX_ON,ICON_CHECKBOX_GRAY})[subitem->data.checkbox.value];
+			icon->type = WID_ICON;
+		}
+		break;
+	  case MENUITEM_RING:
+		p = LL_GetByIndex(subitem->data.ring.strings, subitem->data.ring.value);
+		fill_labeled_value(w->text, len, subitem->text, p, LV_VALUE_ONLY);
+
+		break;
+	  case MENUITEM_MENU:
+		/* Limit string length */
+		snprintf(w->text, len + 1, "%s >", subitem->text);
+		break;
+	  case MENUITEM_ACTION:
+		/* Limit string length */
+		snprintf(w->text, len + 1, "%s", subitem->text);
+		break;
+	    case MENUITEM_SLIDER:
+		snprintf(buf, display_props->width, "%d", subitem->data.slider.value);
+		buf[display_props->width-1] = '\0';
+		fill_labeled_value(w->text, len, subitem->text, buf, LV_LABEL_VALU);
+	    	break;
+	    case MENUITEM_NUMERIC:
+		snprintf(buf, display_props->width, "%d", subitem->data.numeric.value);
+		buf[display_props->width-1] = '\0';
+		fill_labeled_value(w->text, len, subitem->text, buf, LV_LABEL_VALU);
+	    	break;
+	    case MENUITEM_ALPHA:
+		fill_labeled_value(w->text, len, subitem->text, subitem->data.alpha.value, LV_LABEL_VALU);
+	    	break;
+	    case MENUITEM_IP:
+		fill_labeled_value(w->text, len, subitem->text, subitem->data.ip.value, LV_LABEL_ALUE);
+	    	break;
+	  default:
+		assert(!"unexpected menuitem type");
+	}
 }
 
 
@@ -484,7 +540,8 @@ void menu_update_screen(MenuItem *menu, Screen *s)
 	Widget *w;
 	MenuItem *subitem;
 	int itemnr;
-	int hidden_count = 0;
+	int row;
+	int scroll;
 
 	debug(RPT_DEBUG, "%s(menu=[%s], screen=[%s])", __FUNCTION__,
 			((menu != NULL) ? menu->id : "(null)"),
@@ -493,107 +550,65 @@ void menu_update_screen(MenuItem *menu, Screen *s)
 	if ((menu == NULL) || (s == NULL))
 		return;
 
+	scroll = menu->data.menu.scroll;
+
 	/* Update widgets for the title */
-	w = screen_find_widget(s, "title");
-	if (w == NULL)
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "title");
-	w->y = 1 - menu->data.menu.scroll;
+	w = menu->w.text;
+	if (w != NULL) {
+		w->y = 1 - scroll;
+
+		/* TODO: remove next 3 limes when rendering is safe */
+		w->type = ((w->y > 0) && (w->y <= display_props->height))
+			  ? WID_TITLE
+			  : WID_NONE;	/* make invisible */
+	}
 
-	/* TODO: remove next 3 limes when rendering is safe */
-	w->type = ((w->y > 0) && (w->y <= display_props->height))
-		  ? WID_TITLE
-		  : WID_NONE;	/* make invisible */
+	/* Hide all lines, those with a subitem in view are shown again */
+	for (row = 0; row < menu->data.menu.num_rows; row++) {
+		if (menu->data.menu.rows[row] != NULL)
+			menu->data.menu.rows[row]->type = WID_NONE;
+		if (menu->data.menu.row_icons[row] != NULL)
+			menu->data.menu.row_icons[row]->type = WID_NONE;
+	}
 
-	/* Update widgets for each subitem in the menu */
+	/* Bind the lines to the subitems in view */
 	for (subitem = LL_GetFirst(menu->data.menu.contents), itemnr = 0;
 	     subitem != NULL;
-	     subitem = LL_GetNext(menu->data.menu.contents), itemnr ++)
+	     subitem = LL_GetNext(menu->data.menu.contents))
 	{
-		char buf[LCD_MAX_WIDTH];	// long enough for "icon%d" and such
-		char *p;
-		int len = display_props->width - 1;
+		int y;
 
 		if (subitem->is_hidden) {
 			debug(RPT_DEBUG, "%s: menu %s has hidden menu: %s",
 			      __FUNCTION__, menu->id, subitem->id);
-			hidden_count++;
 			continue;
 		}
-		snprintf(buf, sizeof(buf)-1, "text%d", itemnr);
-		buf[sizeof(buf)-1] = '\0';
-		w = screen_find_widget(s, buf);
-		if (w == NULL)
-			report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, buf);
-		w->y = 2 + itemnr - hidden_count - menu->data.menu.scroll;
-
-		/* TODO: remove next 3 lines when rendering is safe */
-		w->type = ((w->y > 0) && (w->y <= display_props->height))
-			  ? WID_STRING
-			  : WID_NONE;	/* make invisible */
-
-		switch (subitem->type) {
-		  case MENUITEM_CHECKBOX:
-			/* Update icon value for checkbox */
-			snprintf(buf, sizeof(buf)-1, "icon%d", itemnr);
-			buf[sizeof(buf)-1] = '\0';
-			w = screen_find_widget(s, buf);
-			if (w == NULL)
-				report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, buf);
-			w->y = 2 + itemnr - menu->data.menu.scroll;
-			w->length = ((int[]){ICON_CHECKBOX_OFF,ICON_CHECKBOX_ON,ICON_CHECKBOX_GRAY})[subitem->data.checkbox.value];
-
-			/* TODO: remove next 3 lines when rendering is safe */
-			w->type = ((w->y > 0) && (w->y <= display_props->height))
-				  ? WID_ICON
-				  : WID_NONE;	/* make invisible */
-			break;
-		  case MENUITEM_RING:
-			p = LL_GetByIndex(subitem->data.ring.strings, subitem->data.ring.value);
-			fill_labeled_value(w->text, len, subitem->text, p, LV_VALUE_ONLY);
-
+		y = 2 + itemnr - scroll;
+		itemnr++;
+		if (y < 1)
+			continue;
+		if ((y > display_props->height) || (y > menu->data.menu.num_rows))
 			break;
-		    case MENUITEM_SLIDER:
-			snprintf(buf, display_props->width, "%d", subitem->data.slider.value);
-			buf[display_props->width-1] = '\0';
-			fill_labeled_value(w->text, len, subitem->text, buf, LV_LABEL_VALU);
-		    	break;
-		    case MENUITEM_NUMERIC:
-			snprintf(buf, display_props->width, "%d", subitem->data.numeric.value);
-			buf[display_props->width-1] = '\0';
-			fill_labeled_value(w->text, len, subitem->text, buf, LV_LABEL_VALU);
-		    	break;
-		    case MENUITEM_ALPHA:
-			fill_labeled_value(w->text, len, subitem->text, subitem->data.alpha.value, LV_LABEL_VALU);
-		    	break;
-		    case MENUITEM_IP:
-			fill_labeled_value(w->text, len, subitem->text, subitem->data.ip.value, LV_LABEL_ALUE);
-		    	break;
-		  default:
-                      break;
-		}
+		if (menu->data.menu.rows[y-1] != NULL)
+			menu_update_row(subitem, menu->data.menu.rows[y-1],
+					menu->data.menu.row_icons[y-1], y);
 	}
 
 	/* Update selector position */
-	w = screen_find_widget(s, "selector");
+	w = menu->data.menu.selector;
 	if (w != NULL)
-		w->y = 2 + menu->data.menu.selector_pos - menu->data.menu.scroll;
-	else
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "selector");
+		w->y = 2 + menu->data.menu.selector_pos - scroll;
 
 	/* Enable upscroller (if necessary) */
-	w = screen_find_widget(s, "upscroller");
+	w = menu->data.menu.upscroller;
 	if (w != NULL)
-		w->type = (menu->data.menu.scroll > 0) ? WID_ICON : WID_NONE;
-	else
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "upscroller");
+		w->type = (scroll > 0) ? WID_ICON : WID_NONE;
 
 	/* Enable downscroller (if necessary) */
-	w = screen_find_widget(s, "downscroller");
+	w = menu->data.menu.downscroller;
 	if (w != NULL)
-		w->type = (menu_visible_item_count(menu) >= menu->data.menu.scroll + display_props->height)
+		w->type = (menu_visible_item_count(menu) >= scroll + display_props->height)
 			? WID_ICON : WID_NONE;
-	else
-		report(RPT_ERR, "%s: could not find widget: %s", __FUNCTION__, "downscroller");
 }
 
 
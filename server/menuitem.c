@@ -241,6 +241,7 @@ MenuItem *menuitem_create(MenuItemType type, char *id, MenuEventFunc(*event_func
 	}
 	new_item->client = client;
 	new_item->is_hidden = false;
+	memset(&(new_item->w), '\0', sizeof(new_item->w));
 
 	/* Clear the type specific data part */
 	memset(&(new_item->data), '\0', sizeof(new_item->data));
@@ -660,6 +661,9 @@ void menuitem_rebuild_screen(MenuItem *item, Screen *s)
 		}
 
 		if (item != NULL) {
+			/* Forget the handles of the widgets just destroyed */
+			memset(&(item->w), '\0', sizeof(item->w));
+
 			/* Call type specific screen building function */
 			build_screen = build_screen_table [item->type];
 			if (build_screen) {
@@ -693,10 +697,12 @@ void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 		w->text = strdup(item->text);
 		w->x = 1;
 		w->y = 1;
+		item->w.text = w;
 	}
 
 	w = widget_create("bar", WID_HBAR, s);
 	screen_add_widget(s, w);
+	item->w.value = w;
 	w->width = display_props->width;
 	if (display_props->height > 2) {
 		/* This is option 1: we have enought space, so the bar and
@@ -709,6 +715,7 @@ void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 
 	w = widget_create("min", WID_STRING, s);
 	screen_add_widget(s, w);
+	item->w.min = w;
 	w->text = NULL;
 	w->x = 1;
 	if (display_props->height > 2) {
@@ -719,6 +726,7 @@ void menuitem_rebuild_screen_slider(MenuItem *item, Screen *s)
 
 	w = widget_create("max", WID_STRING, s);
 	screen_add_widget(s, w);
+	item->w.max = w;
 	w->text = NULL;
 	w->x = 1;
 	if (display_props->height > 2) {
@@ -746,10 +754,12 @@ void menuitem_rebuild_screen_numeric(MenuItem *item, Screen *s)
 		w->text = strdup(item->text);
 		w->x = 1;
 		w->y = 1;
+		item->w.text = w;
 	}
 
 	w = widget_create("value", WID_STRING, s);
 	screen_add_widget(s, w);
+	item->w.value = w;
 	w->text = malloc(MAX_NUMERIC_LEN);
 	w->x = 2;
 	w->y = display_props->height / 2 + 1;
@@ -758,6 +768,7 @@ void menuitem_rebuild_screen_numeric(MenuItem *item, Screen *s)
 	if (display_props->height > 2) {
 		w = widget_create("error", WID_STRING, s);
 		screen_add_widget(s, w);
+		item->w.error = w;
 		w->text = strdup("");
 		w->x = 1;
 		w->y = display_props->height;
@@ -782,10 +793,12 @@ void menuitem_rebuild_screen_alpha(MenuItem *item, Screen *s)
 		w->text = strdup(item->text);
 		w->x = 1;
 		w->y = 1;
+		item->w.text = w;
 	}
 
 	w = widget_create("value", WID_STRING, s);
 	screen_add_widget(s, w);
+	item->w.value = w;
 	w->text = malloc(item->data.alpha.maxlength+1);
 	w->x = 2;
 	w->y = display_props->height / 2 + 1;
@@ -794,6 +807,7 @@ void menuitem_rebuild_screen_alpha(MenuItem *item, Screen *s)
 	if (display_props->height > 2) {
 		w = widget_create("error", WID_STRING, s);
 		screen_add_widget(s, w);
+		item->w.error = w;
 		w->text = strdup("");
 		w->x = 1;
 		w->y = display_props->height;
@@ -818,10 +832,12 @@ void menuitem_rebuild_screen_ip(MenuItem *item, Screen *s)
 		w->text = strdup(item->text);
 		w->x = 1;
 		w->y = 1;
+		item->w.text = w;
 	}
 
 	w = widget_create("value", WID_STRING, s);
 	screen_add_widget(s, w);
+	item->w.value = w;
 	w->text = malloc(item->data.ip.maxlength+1);
 	w->x = 2;
 	w->y = display_props->height / 2 + 1;
@@ -830,6 +846,7 @@ void menuitem_rebuild_screen_ip(MenuItem *item, Screen *s)
 	if (display_props->height > 2) {
 		w = widget_create("error", WID_STRING, s);
 		screen_add_widget(s, w);
+		item->w.error = w;
 		w->text = strdup("");
 		w->x = 1;
 		w->y = display_props->height;
@@ -880,7 +897,7 @@ void menuitem_update_screen_slider(MenuItem *item, Screen *s)
 
 	/* And adjust the data */
 
-	w = screen_find_widget(s, "bar");
+	w = item->w.value;
 	if (display_props->height <= 2) {
 		/* This is option 2: we're tight on lines, so we put the bar
 		 * and min/max texts on the same line.
@@ -895,11 +912,11 @@ void menuitem_update_screen_slider(MenuItem *item, Screen *s)
 		* (item->data.slider.value - item->data.slider.minvalue)
 		/ (item->data.slider.maxvalue - item->data.slider.minvalue);
 
-	w = screen_find_widget(s, "min");
+	w = item->w.min;
 	if (w->text) free(w->text);
 	w->text = strdup(item->data.slider.mintext);
 
-	w = screen_find_widget(s, "max");
+	w = item->w.max;
 	if (w->text) free(w->text);
 	w->x = 1 + display_props->width - max_len;
 	w->text = strdup(item->data.slider.maxtext);
@@ -916,7 +933,7 @@ void menuitem_update_screen_numeric(MenuItem *item, Screen *s)
 	if ((item == NULL) || (s == NULL))
 		return;
 
-	w = screen_find_widget(s, "value");
+	w = item->w.value;
 	strcpy(w->text, item->data.numeric.edit_str + item->data.numeric.edit_offs);
 
 	s->cursor = CURSOR_DEFAULT_ON;
@@ -925,7 +942,7 @@ void menuitem_update_screen_numeric(MenuItem *item, Screen *s)
 
 	/* Only display error string if enough space... */
 	if (display_props->height > 2) {
-		w = screen_find_widget(s, "error");
+		w = item->w.error;
 		free(w->text);
 		w->text = strdup(error_strs[item->data.numeric.error_code]);
 	}
@@ -942,7 +959,7 @@ void menuitem_update_screen_alpha(MenuItem *item, Screen *s)
 	if ((item == NULL) || (s == NULL))
 		return;
 
-	w = screen_find_widget(s, "value");
+	w = item->w.value;
 	if (item->data.alpha.password_char == '\0') {
 		strcpy(w->text, item->data.alpha.edit_str + item->data.alpha.edit_offs);
 	} else {
@@ -958,7 +975,7 @@ void menuitem_update_screen_alpha(MenuItem *item, Screen *s)
 
 	/* Only display error string if enough space... */
 	if (display_props->height > 2) {
-		w = screen_find_widget(s, "error");
+		w = item->w.error;
 		free(w->text);
 		w->text = strdup(error_strs[item->data.alpha.error_code]);
 	}
@@ -975,7 +992,7 @@ void menuitem_update_screen_ip(MenuItem *item, Screen *s)
 	if ((item == NULL) || (s == NULL))
 		return;
 
-	w = screen_find_widget(s, "value");
+	w = item->w.value;
 	if (w != NULL)
 		strcpy(w->text, item->data.ip.edit_str + item->data.ip.edit_offs);
 
@@ -985,7 +1002,7 @@ void menuitem_update_screen_ip(MenuItem *item, Screen *s)
 
 	/* Only display error string if enough space... */
 	if (display_props->height > 2) {
-		w = screen_find_widget(s, "error");
+		w = item->w.error;
 		free(w->text);
 		w->text = strdup(error_strs[item->data.ip.error_code]);
 	}
@@ -129,6 +129,15 @@ typedef struct MenuItem {
 	char *text;	/**< Visible name of the item */
 	void* client;	/**< The owner of this menuitem. */
 	bool is_hidden; /**< If the item currently should not appear in a menu. */
+	/** Widgets of this item's screen, set when the menu screen is built.
+	 * Only valid while this item is active. */
+	struct menuitem_widgets {
+		struct Widget *text;	/**< Title of the item's screen */
+		struct Widget *value;	/**< Value, or bar of a slider */
+		struct Widget *min;	/**< Min text of a slider */
+		struct Widget *max;	/**< Max text of a slider */
+		struct Widget *error;	/**< Error message */
+	} w;
 	union data {
 		struct menu {
 			int selector_pos;	/**< At what menuitem is the
@@ -138,6 +147,19 @@ typedef struct MenuItem {
 			void *association;      /**< To associate an object
                                                    with this menu */
 			LinkedList *contents;	/**< What's in this menu */
+			bool on_demand;		/**< Contents are supplied by the
+						   client when the menu is
+						   entered and deleted when
+						   it is left */
+			int num_rows;		/**< Number of row widgets */
+			struct Widget **rows;	/**< Widgets for the display
+						   lines, bound to the
+						   subitems in view */
+			struct Widget **row_icons;	/**< Checkbox icons of
+						   the display lines */
+			struct Widget *selector;	/**< Selector widget */
+			struct Widget *upscroller;	/**< Up arrow widget */
+			struct Widget *downscroller;	/**< Down arrow widget */
 		} menu;
 		struct action {
 			/* nothing */
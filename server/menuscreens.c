@@ -239,6 +239,38 @@ is_menu_key(const char *key)
 		return false;
 }
 
+/**
+ * Delete the contents of on_demand menus that have been left. The client
+ * supplies them again when the menu is entered the next time.
+ * \param old_menuitem  Item that was active.
+ * \param new_menuitem  Item that is active now (may be NULL).
+ */
+static void
+menuscreen_release_on_demand(MenuItem *old_menuitem, MenuItem *new_menuitem)
+{
+	MenuItem *item, *release = NULL;
+
+	/* Find the outermost on_demand menu around the old item that does not
+	 * contain the new one */
+	for (item = old_menuitem; item != NULL; item = item->parent) {
+		MenuItem *p;
+
+		if ((item->type != MENUITEM_MENU) || !item->data.menu.on_demand)
+			continue;
+		for (p = new_menuitem; (p != NULL) && (p != item); p = p->parent)
+			;
+		if (p == item)
+			break;
+		release = item;
+	}
+
+	if (release != NULL) {
+		debug(RPT_DEBUG, "%s: releasing contents of menu [%s]",
+		      __FUNCTION__, release->id);
+		menu_destroy_all_items(release);
+	}
+}
+
 /** This function changes the menuitem to the given one, and does necessary
  * actions.
  * To leave the menu system, specify NULL for new_menuitem.
@@ -284,6 +316,9 @@ menuscreen_switch_item(MenuItem * new_menuitem)
 	if (new_menuitem && new_menuitem->event_func)
 		new_menuitem->event_func(new_menuitem, MENUEVENT_ENTER);
 
+	if (old_menuitem)
+		menuscreen_release_on_demand(old_menuitem, new_menuitem);
+
 	return;
 }
 
@@ -18,17 +18,31 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "shared/LL.h"
 #include "shared/sockets.h"
 #include "shared/report.h"
+#include "shared/configfile.h"
 #include "clients.h"
+#include "screen.h"
+#include "widget.h"
 #include "commands/command_list.h"
+#include "commands/widget_commands.h"
 #include "parse.h"
 #include "sock.h"
 
 #define MAX_ARGUMENTS 40
 
+/** Skip widget_set commands that a later one for the same widget overwrites */
+static int coalesce_widget_set = 0;
+/** Maximum number of commands of one client per pass, 0 = unlimited */
+static int client_command_budget = 0;
+/** Maximum time in microseconds spent on one client per pass, 0 = unlimited */
+static long client_time_budget = 0;
+/** Rotates the client that is served first in a pass */
+static unsigned int first_client = 0;
+
 
 static inline int is_whitespace(char x)	{
 	return ((x == ' ') || (x == '\t') || (x == '\r'));
@@ -47,7 +61,14 @@ static inline int is_closing_quote(char x, char q) {
 }
 
 
-static int parse_message(const char *str, Client *c)
+/**
+ * Split a command into its arguments.
+ * \param str        The command.
+ * \param arg_space  Space for the arguments, at least as long as \c str.
+ * \param argv       Array of MAX_ARGUMENTS to receive the arguments.
+ * \return  Number of arguments, -1 if the command could not be parsed.
+ */
+static int parse_arguments(const char *str, char *arg_space, char **argv)
 {
 	typedef enum { ST_INITIAL, ST_WHITESPACE, ST_ARGUMENT, ST_FINAL } State;
 	State state = ST_INITIAL;
@@ -55,22 +76,8 @@ static int parse_message(const char *str, Client *c)
 	int error = 0;
 	char quote = '\0';	/* The quote used to open a quote string */
 	int pos = 0;
-	char *arg_space;
 	int argc = 0;
-	char *argv[MAX_ARGUMENTS];
 	int argpos = 0;
-	CommandFunc function = NULL;
-
-	debug(RPT_DEBUG, "%s(str=\"%.120s\", client=[%d])", __FUNCTION__, str, c->sock);
-
-	/* We will create a list of strings that is shorter or equally long as
-	 * the original string str.
-	 */
-	arg_space = malloc(strlen(str)+1);
-	if (arg_space == NULL) {
-		report(RPT_ERR, "%s: Could not allocate memory", __FUNCTION__);
-		sock_send_error(c->sock, "error allocating memory!\n");
-	}
 
 	argv[0] = arg_space;
 
@@ -180,11 +187,8 @@ static int parse_message(const char *str, Client *c)
 	else
 		error = 1;
 
-	if (error) {
-		sock_send_error(c->sock, "Could not parse command\n");
-		free(arg_space);
-		return 0;
-	}
+	if (error)
+		return -1;
 
 #if 0 /* show what we have parsed */
 	int i;
@@ -193,6 +197,22 @@ static int parse_message(const char *str, Client *c)
 	}
 #endif
 
+	return argc;
+}
+
+
+/**
+ * Call the function for a command that has been split into arguments.
+ * \param c     The client that sent the command.
+ * \param argc  Number of arguments.
+ * \param argv  The arguments.
+ * \param str   The command as sent (for error reports).
+ */
+static void parse_execute(Client *c, int argc, char **argv, const char *str)
+{
+	CommandFunc function = NULL;
+	int error;
+
 	/* Now find and call the appropriate function...*/
 	function = get_command_function(argv[0]);
 
@@ -207,35 +227,239 @@ static int parse_message(const char *str, Client *c)
 		sock_printf_error(c->sock, "Invalid command \"%.40s\"\n", argv[0]);
 		report(RPT_WARNING, "Invalid command from client on socket %d: %.40s", c->sock, str);
 	}
+}
+
+
+static int parse_message(const char *str, Client *c)
+{
+	char *arg_space;
+	int argc;
+	char *argv[MAX_ARGUMENTS];
+
+	debug(RPT_DEBUG, "%s(str=\"%.120s\", client=[%d])", __FUNCTION__, str, c->sock);
+
+	/* We will create a list of strings that is shorter or equally long as
+	 * the original string str.
+	 */
+	arg_space = malloc(strlen(str)+1);
+	if (arg_space == NULL) {
+		report(RPT_ERR, "%s: Could not allocate memory", __FUNCTION__);
+		sock_send_error(c->sock, "error allocating memory!\n");
+		return 0;
+	}
+
+	argc = parse_arguments(str, arg_space, argv);
+	if (argc < 0)
+		sock_send_error(c->sock, "Could not parse command\n");
+	else
+		parse_execute(c, argc, argv, str);
 
 	free(arg_space);
 	return 0;
 }
 
 
-int
-parse_all_client_messages(void)
+/**
+ * Check whether a command is a widget_set command.
+ * \param str  The command, may be NULL.
+ * \return  Non-zero if it is.
+ */
+static int is_widget_set(const char *str)
 {
-	Client *c;
+	if (str == NULL)
+		return 0;
+	while (is_whitespace(*str))
+		str++;
+	return ((strncmp(str, "widget_set", 10) == 0) && is_whitespace(str[10]));
+}
+
 
+/**
+ * Process a run of widget_set commands of a client. A command that is
+ * followed by a valid widget_set for the same widget is only answered, not
+ * executed, as its effect would be overwritten anyway.
+ * \param c    The client.
+ * \param str  The first widget_set command, taken from the client's queue.
+ *             This function frees it and takes further commands from the
+ *             queue as long as they can be coalesced.
+ */
+static void parse_widget_set_run(Client *c, char *str)
+{
+	char *arg_space, *next_space;
+	int argc, next_argc;
+	char *argv[MAX_ARGUMENTS], *next_argv[MAX_ARGUMENTS];
+	Widget *w = NULL;
+
+	arg_space = malloc(strlen(str)+1);
+	if (arg_space == NULL) {
+		parse_message(str, c);
+		free(str);
+		return;
+	}
+	argc = parse_arguments(str, arg_space, argv);
+
+	while ((argc >= 3) && is_widget_set(client_peek_message(c))) {
+		const char *next = client_peek_message(c);
+		const char *error;
+
+		next_space = malloc(strlen(next)+1);
+		if (next_space == NULL)
+			break;
+		next_argc = parse_arguments(next, next_space, next_argv);
+		if ((next_argc < 3) ||
+		    (strcmp(argv[1], next_argv[1]) != 0) ||
+		    (strcmp(argv[2], next_argv[2]) != 0)) {
+			free(next_space);
+			break;
+		}
+
+		/* Only if the next command will succeed it supersedes this one */
+		if (w == NULL) {
+			Screen *s = client_find_screen(c, argv[1]);
+
+			if (s != NULL)
+				w = screen_find_widget(s, argv[2]);
+		}
+		if ((w == NULL) || (widget_set_check(w, next_argc, next_argv) != NULL)) {
+			free(next_space);
+			break;
+		}
+
+		/* Answer as if it had been executed */
+		debug(RPT_DEBUG, "%s: skipping superseded command \"%.120s\"", __FUNCTION__, str);
+		error = widget_set_check(w, argc, argv);
+		if (error != NULL)
+			sock_send_error(c->sock, (char *) error);
+		else
+			sock_send_string(c->sock, "success\n");
+
+		/* Continue with the next command */
+		free(str);
+		free(arg_space);
+		str = client_get_message(c);
+		arg_space = next_space;
+		argc = next_argc;
+		memcpy(argv, next_argv, sizeof(argv));
+	}
+
+	if (argc < 0)
+		sock_send_error(c->sock, "Could not parse command\n");
+	else
+		parse_execute(c, argc, argv, str);
+
+	free(str);
+	free(arg_space);
+}
+
+
+/**
+ * Read the parser's settings from the config file.
+ * \return  0 on success.
+ */
+int
+parse_init(void)
+{
 	debug(RPT_DEBUG, "%s()", __FUNCTION__);
 
-	for (c = clients_getfirst(); c != NULL; c = clients_getnext()) {
-		char *str;
+	coalesce_widget_set = config_get_bool("server", "CoalesceWidgetSet", 0, 0);
+
+	client_command_budget = config_get_int("server", "ClientCommandBudget", 0, 0);
+	if (client_command_budget < 0)
+		client_command_budget = 0;
+	client_time_budget = config_get_int("server", "ClientTimeBudget", 0, 0);
+	if (client_time_budget < 0)
+		client_time_budget = 0;
+	if (client_command_budget > 0 || client_time_budget > 0)
+		report(RPT_INFO, "Client budget per pass: %d commands, %ld us (0 = unlimited)",
+		       client_command_budget, client_time_budget);
+
+	return 0;
+}
 
-		/* And parse all its messages...*/
-		/*debug(RPT_DEBUG, "parse: Getting messages...");*/
-		for (str = client_get_message(c); str != NULL; str = client_get_message(c)) {
+
+/**
+ * Execute the queued messages of one client until its queue is empty or its
+ * budget for this pass is used up. At least one message is executed.
+ * \param c  The client.
+ * \return  1 if messages are left for the next pass, 0 otherwise.
+ */
+static int
+parse_client_messages(Client *c)
+{
+	struct timeval start, now;
+	int count = 0;
+	char *str;
+
+	if (client_time_budget > 0)
+		gettimeofday(&start, NULL);
+
+	/* And parse all its messages...*/
+	/*debug(RPT_DEBUG, "parse: Getting messages...");*/
+	for (str = client_get_message(c); str != NULL; str = client_get_message(c)) {
+		if (coalesce_widget_set && (c->state == ACTIVE) && is_widget_set(str)) {
+			parse_widget_set_run(c, str);
+		}
+		else {
 			parse_message(str, c);
 			free(str);
+		}
 
-			if (c->state == GONE) {
-				sock_destroy_client_socket(c);
+		if (c->state == GONE) {
+			sock_destroy_client_socket(c);
+			return 0;
+		}
+
+		if (c->queue_depth == 0)
+			break;
+		if ((client_command_budget > 0) && (++count >= client_command_budget))
+			break;
+		if (client_time_budget > 0) {
+			gettimeofday(&now, NULL);
+			if ((now.tv_sec - start.tv_sec) * 1000000L
+			    + (now.tv_usec - start.tv_usec) >= client_time_budget)
 				break;
-			}
 		}
 	}
+
+	if (c->queue_depth > 0) {
+		c->throttled++;
+		debug(RPT_DEBUG, "%s: client on socket %d has %d messages left",
+		      __FUNCTION__, c->sock, c->queue_depth);
+		return 1;
+	}
 	return 0;
 }
 
 
+int
+parse_all_client_messages(void)
+{
+	Client *c;
+	unsigned int start = 0;
+	unsigned int i;
+	int pending = 0;
+
+	debug(RPT_DEBUG, "%s()", __FUNCTION__);
+
+	/* With a budget, start with another client each pass to be fair */
+	if (client_command_budget > 0 || client_time_budget > 0) {
+		int n = clients_client_count();
+
+		if (n > 0)
+			start = first_client++ % n;
+	}
+
+	i = 0;
+	for (c = clients_getfirst(); c != NULL; c = clients_getnext()) {
+		if (i++ >= start)
+			pending += parse_client_messages(c);
+	}
+	i = 0;
+	for (c = clients_getfirst(); c != NULL && i < start; c = clients_getnext()) {
+		i++;
+		pending += parse_client_messages(c);
+	}
+	return pending;
+}
+
+
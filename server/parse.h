@@ -12,7 +12,11 @@
 #ifndef PARSE_H
 #define PARSE_H
 
+/* Read the parser's settings */
+int parse_init(void);
+
 // This should be pretty self-explanatory...
+// Returns the number of clients that have messages left for the next pass.
 int parse_all_client_messages(void);
 
 #endif
@@ -62,10 +62,11 @@ char *server_msg_text;
 int server_msg_expire = 0;
 
 
-static int render_frame(LinkedList *list, int left, int top, int right, int bottom, int fwid, int fhgt, char fscroll, int fspeed, long timer);
-static int render_string(Widget *w, int left, int top, int right, int bottom, int fy);
-static int render_hbar(Widget *w, int left, int top, int right, int bottom, int fy);
-static int render_vbar(Widget *w, int left, int top, int right, int bottom);
+static int render_frame(Screen *s, int indexed, int left, int top, int right, int bottom, int x0, int y0, int vwid, int vhgt, int fwid, int fhgt, char fscroll, int fspeed, long timer);
+static void render_widget(Widget *w, int left, int top, int right, int bottom, int ox, int oy, long timer);
+static int render_string(Widget *w, int left, int top, int right, int bottom, int ox, int oy);
+static int render_hbar(Widget *w, int left, int top, int right, int bottom, int ox, int oy);
+static int render_vbar(Widget *w, int left, int top, int right, int bottom, int ox, int oy);
 static int render_title(Widget *w, int left, int top, int right, int bottom, long timer);
 static int render_scroller(Widget *w, int left, int top, int right, int bottom, long timer);
 static int render_num(Widget *w, int left, int top, int right, int bottom);
@@ -154,7 +155,8 @@ render_screen(Screen *s, long timer)
 	drivers_output(output_state);
 
 	/* 4. Draw a frame... */
-	render_frame(s->widgetlist, 0, 0,
+	render_frame(s, 0, 0, 0,
+			display_props->width, display_props->height, 0, 0,
 			display_props->width, display_props->height,
 			s->width, s->height, 'v', max(s->duration / s->height, 1), timer);
 
@@ -194,37 +196,60 @@ render_screen(Screen *s, long timer)
 
 }
 
-/* The following function is positively ghastly (as was mentioned above!) */
-/* Best thing to do is to remove support for frames... but anyway... */
-/* */
+/**
+ * Render the widgets of a screen or frame into a window of the display.
+ *
+ * Widget coordinates in the frame are relative to its origin \c x0/y0,
+ * shifted by the frame's scrolling offset. Only what falls into the window
+ * \c left+1..right, \c top+1..bottom is drawn, which also clips nested
+ * frames to their parents.
+ *
+ * If \c indexed is set, the row index of \c s is used to visit only the
+ * widgets on visible rows. The top level screen is walked as a list, as
+ * the server's own screens move their widgets without telling.
+ *
+ * \param s        Screen (of the frame) to render.
+ * \param indexed  Use the row index of \c s.
+ * \param left     Left edge of the visible window.
+ * \param top      Top edge of the visible window.
+ * \param right    Right edge of the visible window.
+ * \param bottom   Bottom edge of the visible window.
+ * \param x0       Display column of the frame's origin.
+ * \param y0       Display row of the frame's origin.
+ * \param vwid     Width of the frame's view.
+ * \param vhgt     Height of the frame's view.
+ * \param fwid     Width of the frame's contents.
+ * \param fhgt     Height of the frame's contents.
+ * \param fscroll  Direction of scrolling ('v' or 'h').
+ * \param fspeed   Speed of scrolling.
+ * \param timer    Current timer tick.
+ * \return  -1 on error, 0 on success.
+ */
 static int
-render_frame(LinkedList *list,
-		int left,	/* left edge of frame */
-		int top,	/* top edge of frame */
-		int right,	/* right edge of frame */
-		int bottom,	/* bottom edge of frame */
-		int fwid,	/* frame width? */
-		int fhgt,	/* frame height? */
-		char fscroll,	/* direction of scrolling */
-		int fspeed,	/* speed of scrolling... */
-		long timer)	/* current timer tick */
+render_frame(Screen *s, int indexed,
+		int left, int top, int right, int bottom,
+		int x0, int y0, int vwid, int vhgt,
+		int fwid, int fhgt, char fscroll, int fspeed, long timer)
 {
-	int fy = 0;		/* Scrolling offset for the frame... */
+	int fx = 0;		/* Horizontal scrolling offset for the frame... */
+	int fy = 0;		/* Vertical scrolling offset for the frame... */
+	int ox, oy;
+	Widget *w;
 
-	debug(RPT_DEBUG, "%s(list=%p, left=%d, top=%d, "
-			  "right=%d, bottom=%d, fwid=%d, fhgt=%d, "
-			  "fscroll='%c', fspeed=%d, timer=%ld)",
-			  __FUNCTION__, list, left, top, right, bottom,
-			  fwid, fhgt, fscroll, fspeed, timer);
+	debug(RPT_DEBUG, "%s(s=%p, indexed=%d, left=%d, top=%d, "
+			  "right=%d, bottom=%d, x0=%d, y0=%d, vwid=%d, vhgt=%d, "
+			  "fwid=%d, fhgt=%d, fscroll='%c', fspeed=%d, timer=%ld)",
+			  __FUNCTION__, s, indexed, left, top, right, bottom,
+			  x0, y0, vwid, vhgt, fwid, fhgt, fscroll, fspeed, timer);
 
 	/* return on no data or illegal height */
-	if ((list == NULL) || (fhgt <= 0))
+	if ((s == NULL) || (s->widgetlist == NULL) || (fhgt <= 0))
 		return -1;
 
 	if (fscroll == 'v') {		/* vertical scrolling */
 		// only set offset !=0 when fspeed is != 0 and there is something to scroll
-		if ((fspeed != 0) && (fhgt > bottom - top)) {
-			int fy_max = fhgt - (bottom - top) + 1;
+		if ((fspeed != 0) && (fhgt > vhgt)) {
+			int fy_max = fhgt - vhgt + 1;
 
 			fy = (fspeed > 0)
 			     ? (timer / fspeed) % fy_max
@@ -236,115 +261,176 @@ render_frame(LinkedList *list,
 		}
 	}
 	else if (fscroll == 'h') {	/* horizontal scrolling */
-		/* TODO:  Frames don't scroll horizontally yet! */
+		if ((fspeed != 0) && (fwid > vwid)) {
+			int fx_max = fwid - vwid + 1;
+
+			fx = (fspeed > 0)
+			     ? (timer / fspeed) % fx_max
+			     : (-fspeed * timer) % fx_max;
+
+			fx = max(fx, 0);	// safeguard against negative values
+
+			debug(RPT_DEBUG, "%s: fx=%d", __FUNCTION__, fx);
+		}
 	}
 
-	/* reset widget list */
-	LL_Rewind(list);
+	/* widget (x,y) is drawn at display position (ox + x, oy + y) */
+	ox = x0 - fx;
+	oy = y0 - fy;
 
-	/* loop over all widgets */
-	do {
-		Widget *w = (Widget *) LL_Get(list);
+	if (indexed && (screen_build_index(s) == 0)) {
+		ScreenIndexEntry *index = s->index;
+		int first = s->index_rowless;
+		int last = s->index_len;
+		int i;
 
-		if (w == NULL)
-			return -1;
+		/* find the widgets on the visible rows top-oy+1 .. bottom-oy */
+		while (first < last) {
+			int mid = (first + last) / 2;
 
-		/* TODO:  Make this cleaner and more flexible! */
-		switch (w->type) {
-			case WID_STRING:
-				render_string(w, left, top - fy, right, bottom, fy);
-				break;
-			case WID_HBAR:
-				render_hbar(w, left, top - fy, right, bottom, fy);
-				break;
-			case WID_VBAR:			  /* FIXME:  Vbars don't work in frames! */
-				render_vbar(w, left, top, right, bottom);
-				break;
-			case WID_ICON:			  /* FIXME:  Icons don't work in frames! */
-				drivers_icon(w->x, w->y, w->length);
-				break;
-			case WID_TITLE:			  /* FIXME:  Doesn't work quite right in frames... */
-				render_title(w, left, top, right, bottom, timer);
-				break;
-			case WID_SCROLLER:		  /* FIXME: doesn't work in frames... */
-				render_scroller(w, left, top, right, bottom, timer);
-				break;
-			case WID_FRAME:
-				{
-					/* FIXME: doesn't handle nested frames quite right!
-					 * doesn't handle scrolling in nested frames at all...
-					 */
-					int new_left = left + w->left - 1;
-					int new_top = top + w->top - 1;
-					int new_right = min(left + w->right, right);
-					int new_bottom = min(top + w->bottom, bottom);
-
-					if ((new_left < right) && (new_top < bottom))	/* Render only if it's visible... */
-						render_frame(w->frame_screen->widgetlist, new_left, new_top,
-								new_right, new_bottom, w->width, w->height,
-								w->length, w->speed, timer);
-				}
-				break;
-			case WID_NUM:				  /* FIXME: doesn't work in frames... */
-				/* NOTE: y=10 means COLON (:) */
-				if ((w->x > 0) && (w->y >= 0) && (w->y <= 10)) {
-					drivers_num(w->x + left, w->y);
-				}
-				break;
-			case WID_NONE:
-				/* FALLTHROUGH */
-			default:
-				break;
+			if (index[mid].row <= top - oy)
+				first = mid + 1;
+			else
+				last = mid;
+		}
+		for (last = first; (last < s->index_len) && (index[last].row <= bottom - oy); last++)
+			;
+
+		if (s->index_rowless == 0) {
+			/* only widgets on different rows may be out of list order */
+			for (i = first; i < last; i++)
+				render_widget(index[i].widget, left, top, right, bottom, ox, oy, timer);
+		}
+		else {
+			/* keep the list order, widgets may overlap frames etc. */
+			ScreenIndexEntry *visible;
+			int n = screen_index_visible(s, first, last, &visible);
+
+			for (i = 0; i < n; i++)
+				render_widget(visible[i].widget, left, top, right, bottom, ox, oy, timer);
 		}
-	} while (LL_Next(list) == 0);
+		return 0;
+	}
+
+	/* loop over all widgets */
+	for (w = LL_GetFirst(s->widgetlist); w != NULL; w = LL_GetNext(s->widgetlist))
+		render_widget(w, left, top, right, bottom, ox, oy, timer);
 
 	return 0;
 }
 
 
+/**
+ * Render one widget of a frame.
+ * \param w       Widget to render.
+ * \param left    Left edge of the visible window.
+ * \param top     Top edge of the visible window.
+ * \param right   Right edge of the visible window.
+ * \param bottom  Bottom edge of the visible window.
+ * \param ox      Display column of the frame's (scrolled) origin.
+ * \param oy      Display row of the frame's (scrolled) origin.
+ * \param timer   Current timer tick.
+ */
+static void
+render_widget(Widget *w, int left, int top, int right, int bottom, int ox, int oy, long timer)
+{
+	/* TODO:  Make this cleaner and more flexible! */
+	switch (w->type) {
+		case WID_STRING:
+			render_string(w, left, top, right, bottom, ox, oy);
+			break;
+		case WID_HBAR:
+			render_hbar(w, left, top, right, bottom, ox, oy);
+			break;
+		case WID_VBAR:
+			render_vbar(w, left, top, right, bottom, ox, oy);
+			break;
+		case WID_ICON:
+			if ((w->x + ox > left) && (w->x + ox <= right) &&
+			    (w->y + oy > top) && (w->y + oy <= bottom))
+				drivers_icon(w->x + ox, w->y + oy, w->length);
+			break;
+		case WID_TITLE:			  /* FIXME:  Doesn't scroll horizontally in frames... */
+			if ((w->y + oy > top) && (w->y + oy <= bottom))
+				render_title(w, left, oy, right, bottom, timer);
+			break;
+		case WID_SCROLLER:		  /* FIXME: doesn't work in frames... */
+			render_scroller(w, left, top, right, bottom, timer);
+			break;
+		case WID_FRAME:
+			{
+				/* the frame's view, clipped by the visible window */
+				int new_x0 = ox + w->left - 1;
+				int new_y0 = oy + w->top - 1;
+				int vwid = w->right - w->left + 1;
+				int vhgt = w->bottom - w->top + 1;
+				int new_left = max(new_x0, left);
+				int new_top = max(new_y0, top);
+				int new_right = min(new_x0 + vwid, right);
+				int new_bottom = min(new_y0 + vhgt, bottom);
+
+				if ((new_left < new_right) && (new_top < new_bottom))	/* Render only if it's visible... */
+					render_frame(w->frame_screen, 1, new_left, new_top,
+							new_right, new_bottom, new_x0, new_y0,
+							vwid, vhgt, w->width, w->height,
+							w->length, w->speed, timer);
+			}
+			break;
+		case WID_NUM:				  /* FIXME: doesn't work in frames... */
+			/* NOTE: y=10 means COLON (:) */
+			if ((w->x > 0) && (w->y >= 0) && (w->y <= 10)) {
+				drivers_num(w->x + left, w->y);
+			}
+			break;
+		case WID_NONE:
+			/* FALLTHROUGH */
+		default:
+			break;
+	}
+}
+
+
 static int
-render_string(Widget *w, int left, int top, int right, int bottom, int fy)
+render_string(Widget *w, int left, int top, int right, int bottom, int ox, int oy)
 {
-	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, fy=%d)",
-			  __FUNCTION__, w, left, top, right, bottom, fy);
+	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, ox=%d, oy=%d)",
+			  __FUNCTION__, w, left, top, right, bottom, ox, oy);
 
 	if ((w != NULL) && (w->text != NULL) &&
-	    (w->x > 0) && (w->y > 0) && (w->y > fy) && (w->y <= bottom - top)) {
+	    (w->x > 0) && (w->y > 0) && (w->y + oy > top) && (w->y + oy <= bottom)) {
+		int x = w->x + ox;
+		int skip = max(left + 1 - x, 0);	/* columns left of the window */
 		int length;
 		char str[BUFSIZE];
 
-		/*
-		 * FIXME: Could be a bug here? w->x is recalculated (On first
-		 * call only? Is it preserved between calls?) and first
-		 * character of w->text shows up on the rightmost column for
-		 * strings totally off-screen. Is this on purpose? (M. Dolze)
-		 */
-		w->x = min(w->x, right - left);
-		length = min(right - left - w->x + 1, sizeof(str)-1);
-		strncpy(str, w->text, length);
-		str[length] = '\0';
-		drivers_string(w->x + left, w->y + top, str);
+		length = min(right - x - skip + 1, sizeof(str)-1);
+		if ((length > 0) && (skip < strlen(w->text))) {
+			strncpy(str, w->text + skip, length);
+			str[length] = '\0';
+			drivers_string(x + skip, w->y + oy, str);
+		}
 	}
 	return 0;
 }
 
 
 static int
-render_hbar(Widget *w, int left, int top, int right, int bottom, int fy)
+render_hbar(Widget *w, int left, int top, int right, int bottom, int ox, int oy)
 {
-	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, fy=%d)",
-			  __FUNCTION__, w, left, top, right, bottom, fy);
+	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, ox=%d, oy=%d)",
+			  __FUNCTION__, w, left, top, right, bottom, ox, oy);
 
 	if ((w != NULL) &&
-	    (w->x > 0) && (w->y > 0) && (w->y > fy) && (w->y <= bottom - top)) {
+	    (w->x > 0) && (w->y > 0) && (w->y + oy > top) && (w->y + oy <= bottom) &&
+	    (w->x + ox > left) && (w->x + ox <= right)) {
 		if (w->length > 0) {
-			int full_len = display_props->width - w->x - left + 1;
+			int full_len = right - w->x - ox + 1;
 			int promille = 1000;
 
-			if ((w->length / display_props->cellwidth) < right - left - w->x + 1)
+			if ((w->length / display_props->cellwidth) < full_len)
 				promille = (long) 1000 * w->length / (display_props->cellwidth * full_len);
 
-			drivers_hbar(w->x + left, w->y + top, full_len, promille, BAR_PATTERN_FILLED);
+			drivers_hbar(w->x + ox, w->y + oy, full_len, promille, BAR_PATTERN_FILLED);
 		}
 		else if (w->length < 0) {
 			/* TODO:  Rearrange stuff to get left-extending
@@ -359,17 +445,20 @@ render_hbar(Widget *w, int left, int top, int right, int bottom, int fy)
 
 
 static int
-render_vbar(Widget *w, int left, int top, int right, int bottom)
+render_vbar(Widget *w, int left, int top, int right, int bottom, int ox, int oy)
 {
-	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d)",
-			  __FUNCTION__, w, left, top, right, bottom);
+	debug(RPT_DEBUG, "%s(w=%p, left=%d, top=%d, right=%d, bottom=%d, ox=%d, oy=%d)",
+			  __FUNCTION__, w, left, top, right, bottom, ox, oy);
 
-	if ((w != NULL) && (w->x > 0) && (w->y > 0)) {
+	if ((w != NULL) && (w->x > 0) && (w->y > 0) &&
+	    (w->x + ox > left) && (w->x + ox <= right) &&
+	    (w->y + oy > top) && (w->y + oy <= bottom)) {
 		if (w->length > 0) {
-			int full_len = display_props->height;
-			int promille = (long) 1000 * w->length / (display_props->cellheight * full_len);
+			/* rows up to the top of the window, the rest is clipped */
+			int full_len = min(display_props->height, w->y + oy - top);
+			int promille = min(1000, (long) 1000 * w->length / (display_props->cellheight * full_len));
 
-			drivers_vbar(w->x + left, w->y + top, full_len, promille, BAR_PATTERN_FILLED);
+			drivers_vbar(w->x + ox, w->y + oy, full_len, promille, BAR_PATTERN_FILLED);
 		}
 		else if (w->length < 0) {
 			/* TODO:  Rearrange stuff to get down-extending
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 
 #include "shared/report.h"
 
@@ -91,6 +92,13 @@ screen_create(char *id, Client *client)
 	s->cursor = CURSOR_OFF;
 	s->cursor_x = 1;
 	s->cursor_y = 1;
+	s->index = NULL;
+	s->index_len = 0;
+	s->index_rowless = 0;
+	s->visible = NULL;
+	s->visible_len = 0;
+	s->visible_first = -1;
+	s->visible_last = -1;
 
 	s->widgetlist = LL_new();
 	if (s->widgetlist == NULL) {
@@ -128,6 +136,7 @@ screen_destroy(Screen *s)
 	}
 	LL_Destroy(s->widgetlist);
 	s->widgetlist = NULL;
+	screen_invalidate_index(s);
 
 	if (s->id != NULL) {
 		free(s->id);
@@ -157,6 +166,7 @@ screen_add_widget(Screen *s, Widget *w)
 	debug(RPT_DEBUG, "%s(s=[%.40s], widget=[%.40s])", __FUNCTION__, s->id, w->id);
 
 	LL_Push(s->widgetlist, (void *) w);
+	screen_invalidate_index(s);
 
 	return 0;
 }
@@ -174,11 +184,136 @@ screen_remove_widget(Screen *s, Widget *w)
 	debug(RPT_DEBUG, "%s(s=[%.40s], widget=[%.40s])", __FUNCTION__, s->id, w->id);
 
 	LL_Remove(s->widgetlist, (void *) w, NEXT);
+	screen_invalidate_index(s);
 
 	return 0;
 }
 
 
+/** Compare two entries of a row index by row and list position. */
+static int
+screen_index_compare(const void *a, const void *b)
+{
+	const ScreenIndexEntry *ea = a;
+	const ScreenIndexEntry *eb = b;
+
+	if (ea->row != eb->row)
+		return (ea->row < eb->row) ? -1 : 1;
+	return ea->seq - eb->seq;
+}
+
+
+/** Index the widgets of a screen by row, unless the index is up to date.
+ * Widgets drawn on the single row given by their y coordinate (strings,
+ * hbars, icons and titles) are sorted by that row. All others come first
+ * in list order; \c s->index_rowless tells how many there are.
+ * \param s    Screen to index.
+ * \retval <0  Error allocating the index.
+ * \retval  0  Success.
+ */
+int
+screen_build_index(Screen *s)
+{
+	ScreenIndexEntry *index;
+	Widget *w;
+	int len, seq, rowless;
+
+	if (s->index != NULL)
+		return 0;
+
+	len = LL_Length(s->widgetlist);
+	index = malloc((len + 1) * sizeof(ScreenIndexEntry));
+	s->visible = malloc((len + 1) * sizeof(ScreenIndexEntry));
+	if ((index == NULL) || (s->visible == NULL)) {
+		report(RPT_ERR, "%s: Error allocating", __FUNCTION__);
+		free(index);
+		free(s->visible);
+		s->visible = NULL;
+		return -1;
+	}
+
+	rowless = 0;
+	for (w = LL_GetFirst(s->widgetlist), seq = 0; w != NULL; w = LL_GetNext(s->widgetlist), seq++) {
+		index[seq].widget = w;
+		index[seq].seq = seq;
+		switch (w->type) {
+			case WID_STRING:
+			case WID_HBAR:
+			case WID_ICON:
+			case WID_TITLE:
+				index[seq].row = w->y;
+				break;
+			default:
+				index[seq].row = INT_MIN;
+				rowless++;
+				break;
+		}
+	}
+	qsort(index, len, sizeof(ScreenIndexEntry), screen_index_compare);
+
+	s->index = index;
+	s->index_len = len;
+	s->index_rowless = rowless;
+	return 0;
+}
+
+
+/** Compare two entries of a row index by list position. */
+static int
+screen_seq_compare(const void *a, const void *b)
+{
+	return ((const ScreenIndexEntry *) a)->seq - ((const ScreenIndexEntry *) b)->seq;
+}
+
+
+/** Get the widgets to draw for the entries \c first .. \c last-1 of the row
+ * index: the rowless widgets and those entries, merged in list order. The
+ * result is kept until the range or the index changes, so the merge only
+ * runs when a frame scrolls.
+ * \param s        Screen with an up to date index (see screen_build_index()).
+ * \param first    First index entry on a visible row.
+ * \param last     Entry after the last one on a visible row.
+ * \param visible  Receives the entries in list order.
+ * \return  Number of entries in \c visible.
+ */
+int
+screen_index_visible(Screen *s, int first, int last, ScreenIndexEntry **visible)
+{
+	if ((first != s->visible_first) || (last != s->visible_last)) {
+		s->visible_len = s->index_rowless + last - first;
+		memcpy(s->visible, s->index, s->index_rowless * sizeof(ScreenIndexEntry));
+		memcpy(s->visible + s->index_rowless, s->index + first,
+		       (last - first) * sizeof(ScreenIndexEntry));
+		qsort(s->visible, s->visible_len, sizeof(ScreenIndexEntry), screen_seq_compare);
+		s->visible_first = first;
+		s->visible_last = last;
+	}
+	*visible = s->visible;
+	return s->visible_len;
+}
+
+
+/** Drop the row index of a screen. It is rebuilt when it is needed next.
+ * \param s  Screen whose widgets have been added, removed or moved.
+ */
+void
+screen_invalidate_index(Screen *s)
+{
+	if ((s == NULL) || (s->index == NULL))
+		return;
+
+	free(s->index);
+	s->index = NULL;
+	s->index_len = 0;
+	s->index_rowless = 0;
+	free(s->visible);
+	s->visible = NULL;
+	s->visible_len = 0;
+	s->visible_first = -1;
+	s->visible_last = -1;
+}
+
+
 /** Find a widget on a screen by its id.
  * \param s   Screen where to look for the widget.
  * \param id  Identifier of the widget.
@@ -38,6 +38,13 @@ typedef enum {	PRI_HIDDEN, PRI_BACKGROUND, PRI_INFO, PRI_FOREGROUND,
 		PRI_ALERT, PRI_INPUT
 } Priority;
 
+/** Entry of the row index of a screen (see screen_build_index()) */
+typedef struct ScreenIndexEntry {
+	struct Widget *widget;	/**< the widget */
+	int row;		/**< its row, INT_MIN if not bound to one row */
+	int seq;		/**< its position in the widget list */
+} ScreenIndexEntry;
+
 typedef struct Screen {
 	char *id;
 	char *name;
@@ -53,6 +60,13 @@ typedef struct Screen {
 	char *keys;
 	LinkedList *widgetlist;
 	struct Client *client;
+	ScreenIndexEntry *index;	/**< Widgets sorted by row, NULL if outdated */
+	int index_len;			/**< Number of entries in \c index */
+	int index_rowless;		/**< Leading entries not bound to one row */
+	ScreenIndexEntry *visible;	/**< Rowless and visible entries in list order */
+	int visible_len;		/**< Number of entries in \c visible */
+	int visible_first;		/**< First entry of \c index in \c visible, -1 if none */
+	int visible_last;		/**< Entry after the last one in \c visible */
 } Screen;
 
 extern int  default_duration ;
@@ -96,6 +110,15 @@ static inline Widget *screen_getnext_widget(Screen *s)
 }
 
 
+/* Index the widgets of a screen by row */
+int screen_build_index(Screen *s);
+
+/* Get the widgets to draw for a range of the row index in list order */
+int screen_index_visible(Screen *s, int first, int last, ScreenIndexEntry **visible);
+
+/* Drop the row index after widgets have been added, removed or moved */
+void screen_invalidate_index(Screen *s);
+
 /* Find a widget in a screen */
 Widget *screen_find_widget(Screen *s, char *id);
 
@@ -33,8 +33,18 @@
 // Length of longest transmission allowed at once...
 #define MAXMSG 8192
 
+// Size of the buffer used between sock_buffer_begin() and sock_buffer_flush()
+#define SENDBUF_SIZE 16384
+
 typedef struct sockaddr_in sockaddr_in;
 
+/** Collects the data sent to one socket until sock_buffer_flush() */
+static struct {
+	int fd;				/**< buffered socket, -1 if none */
+	size_t len;			/**< number of bytes in \c data */
+	char data[SENDBUF_SIZE];	/**< the data to send */
+} sendbuf = { -1, 0 };
+
 /**
  * Tries to resolve a resolve a hostname.
  * \param name      Pointer to resolves IP-address
@@ -212,28 +222,25 @@ sock_recv_string (int fd, char *dest, size_t maxlen)
 }
 
 /**
- * Send raw data.
+ * Write all data to a socket.
  * \param fd    Socket file descriptor
  * \param src   Buffer holding the data to send
- * \param size  Number of bytes to send at most
- * \return  Number of bytes sent.
+ * \param size  Number of bytes to send
+ * \return  Number of bytes sent, -1 on error.
  */
-int
-sock_send (int fd, void *src, size_t size)
+static int
+sock_write (int fd, const char *src, size_t size)
 {
 	int offset = 0;
 
-	if (!src)
-		return -1;
-
 	while (offset != size) {
 		// write isn't guaranteed to send the entire string at once,
 		// so we have to sent it in a loop like this
-                int sent = write (fd, ((char *) src) + offset, size - offset);
+                int sent = write (fd, src + offset, size - offset);
 		if (sent == -1) {
 			if (errno != EAGAIN) {
 				report (RPT_ERR, "sock_send: socket write error");
-				report (RPT_DEBUG, "Message was: '%.*s'", size-offset, (char *) src);
+				report (RPT_DEBUG, "Message was: '%.*s'", size-offset, src);
 				return sent;
 			}
 			continue;
@@ -249,6 +256,74 @@ sock_send (int fd, void *src, size_t size)
 	return offset;
 }
 
+/**
+ * Send raw data.
+ * Between sock_buffer_begin() and sock_buffer_flush() data for the buffered
+ * socket is only collected.
+ * \param fd    Socket file descriptor
+ * \param src   Buffer holding the data to send
+ * \param size  Number of bytes to send at most
+ * \return  Number of bytes sent.
+ */
+int
+sock_send (int fd, void *src, size_t size)
+{
+	if (!src)
+		return -1;
+
+	if ((fd >= 0) && (fd == sendbuf.fd)) {
+		if (sendbuf.len + size > sizeof(sendbuf.data)) {
+			if (sock_buffer_flush() < 0)
+				return -1;
+			sendbuf.fd = fd;
+		}
+		if (size <= sizeof(sendbuf.data)) {
+			memcpy(sendbuf.data + sendbuf.len, src, size);
+			sendbuf.len += size;
+			return size;
+		}
+	}
+
+	return sock_write(fd, (char *) src, size);
+}
+
+/**
+ * Start collecting the data sent to a socket, so that it goes out with a
+ * single write() in sock_buffer_flush(). Data still buffered for another
+ * socket is sent first.
+ * \param fd  Socket file descriptor
+ * \return  0 on success, -1 on error.
+ */
+int
+sock_buffer_begin (int fd)
+{
+	int err = 0;
+
+	if (sendbuf.fd != fd)
+		err = sock_buffer_flush();
+	sendbuf.fd = fd;
+
+	return (err < 0) ? -1 : 0;
+}
+
+/**
+ * Send the data collected since sock_buffer_begin() and stop buffering.
+ * \return  Number of bytes sent, -1 on error.
+ */
+int
+sock_buffer_flush (void)
+{
+	int fd = sendbuf.fd;
+	size_t len = sendbuf.len;
+
+	sendbuf.fd = -1;
+	sendbuf.len = 0;
+	if (len == 0)
+		return 0;
+
+	return sock_write(fd, sendbuf.data, len);
+}
+
 /**
  * Receive raw data.
  * \param fd      Socket file descriptor
@@ -27,6 +27,10 @@ int sock_printf (int fd, const char *format, .../*args*/);
 int sock_send_string (int fd, char *string);
 /** Send raw data */
 int sock_send (int fd, void *src, size_t size);
+/** Collect the data sent to a socket until sock_buffer_flush() */
+int sock_buffer_begin (int fd);
+/** Send the collected data with one write */
+int sock_buffer_flush (void);
 /** Receive a line of text */
 int sock_recv_string (int fd, char *dest, size_t maxlen);
 /** Receive raw data */